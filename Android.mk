@@ -3,7 +3,11 @@
 include $(CLEAR_VARS)
 LOCAL_MODULE    := nedgz
 LOCAL_CFLAGS    := -Wall
-LOCAL_SRC_FILES := nedgz/nedgz_tile.c nedgz/nedgz_log.c nedgz/nedgz_scene.c nedgz/nedgz_util.c
+LOCAL_SRC_FILES := nedgz/nedgz_tile.c nedgz/nedgz_log.c nedgz/nedgz_scene.c nedgz/nedgz_util.c \
+                   nedgz/nedgz_codec.c nedgz/nedgz_pack.c nedgz/nedgz_pool.c nedgz/nedgz_stats.c \
+                   nedgz/nedgz_loader.c nedgz/nedgz_cache.c \
+                   nedgz/nedgz_batch.c nedgz/nedgz_path.c nedgz/nedgz_progress.c \
+                   nedgz/nedgz_profile.c nedgz/nedgz_scenearray.c nedgz/nedgz_cull.c
 
 LOCAL_LDLIBS    := -Llibs/armeabi \
                    -llog -lz
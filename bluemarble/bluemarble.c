@@ -32,51 +32,13 @@
 #include "terrain/terrain_util.h"
 #include "texgz/texgz_tex.h"
 #include "texgz/texgz_png.h"
+#include "nedgz/nedgz_path.h"
 
 #define LOG_TAG "bluemarble"
 #include "nedgz/nedgz_log.h"
 
 #define SUBTILE_SIZE 256
 
-static int mymkdir(const char* fname)
-{
-	assert(fname);
-
-	int  len = strnlen(fname, 255);
-	char dir[256];
-	int  i;
-	for(i = 0; i < len; ++i)
-	{
-		dir[i]     = fname[i];
-		dir[i + 1] = '\0';
-
-		if(dir[i] == '/')
-		{
-			if(access(dir, R_OK) == 0)
-			{
-				// dir already exists
-				continue;
-			}
-
-			// try to mkdir
-			if(mkdir(dir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
-			{
-				if(errno == EEXIST)
-				{
-					// already exists
-				}
-				else
-				{
-					LOGE("mkdir %s failed", dir);
-					return 0;
-				}
-			}
-		}
-	}
-
-	return 1;
-}
-
 static void interpolatec(texgz_tex_t* tex,
                          float u, float v,
                          unsigned char* r,
@@ -221,8 +183,12 @@ static void sample_tile(texgz_tex_t* src,
 	snprintf(fname, 256, "png256/%i/9/%i/%i.png",
 	         month, x, y);
 	fname[255] = '\0';
-	mymkdir(fname);
-	texgz_png_export(dst, fname);
+	nedgz_path_mkdir(fname);
+	if((texgz_png_export(dst, fname) == 0) &&
+	   nedgz_path_retry(fname))
+	{
+		texgz_png_export(dst, fname);
+	}
 }
 
 static void sample_sector(texgz_tex_t* dst,
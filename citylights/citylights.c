@@ -32,51 +32,14 @@
 #include "terrain/terrain_util.h"
 #include "texgz/texgz_tex.h"
 #include "texgz/texgz_png.h"
+#include "nedgz/nedgz_path.h"
+#include "nedgz/nedgz_progress.h"
 
 #define LOG_TAG "citylights"
 #include "nedgz/nedgz_log.h"
 
 #define SUBTILE_SIZE 256
 
-static int mymkdir(const char* fname)
-{
-	assert(fname);
-
-	int  len = strnlen(fname, 255);
-	char dir[256];
-	int  i;
-	for(i = 0; i < len; ++i)
-	{
-		dir[i]     = fname[i];
-		dir[i + 1] = '\0';
-
-		if(dir[i] == '/')
-		{
-			if(access(dir, R_OK) == 0)
-			{
-				// dir already exists
-				continue;
-			}
-
-			// try to mkdir
-			if(mkdir(dir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
-			{
-				if(errno == EEXIST)
-				{
-					// already exists
-				}
-				else
-				{
-					LOGE("mkdir %s failed", dir);
-					return 0;
-				}
-			}
-		}
-	}
-
-	return 1;
-}
-
 static void interpolatec(texgz_tex_t* tex,
                          float u, float v,
                          unsigned char* r,
@@ -220,8 +183,12 @@ static void sample_tile(texgz_tex_t* src,
 	char fname[256];
 	snprintf(fname, 256, "png256/7/%i/%i.png",
 	         x, y);
-	mymkdir(fname);
-	texgz_png_export(dst, fname);
+	nedgz_path_mkdir(fname);
+	if((texgz_png_export(dst, fname) == 0) &&
+	   nedgz_path_retry(fname))
+	{
+		texgz_png_export(dst, fname);
+	}
 }
 
 int main(int argc, char** argv)
@@ -260,24 +227,23 @@ int main(int argc, char** argv)
 	// 2^7 gives 128 tiles at zoom=7
 	int x;
 	int y;
-	int t     = 128;
-	int idx   = 0;
-	int count = t*t;
+	int t = 128;
+	nedgz_progress_t* progress = nedgz_progress_new("citylights", t*t);
+	if(progress == NULL)
+	{
+		goto fail_progress;
+	}
+
 	for(y = 0; y < t; ++y)
 	{
 		for(x = 0; x < t; ++x)
 		{
-			++idx;
-			if(idx%64 == 1)
-			{
-				LOGI("7/%i/%i: %0.1f %%",
-				     x, y, 100.0f*((float) idx)/((float) count));
-			}
-
 			sample_tile(src, dst, x, y);
+			nedgz_progress_done(progress, 1);
 		}
 	}
 
+	nedgz_progress_delete(&progress);
 	texgz_tex_delete(&dst);
 	texgz_tex_delete(&src);
 
@@ -285,6 +251,8 @@ int main(int argc, char** argv)
 	return EXIT_SUCCESS;
 
 	// failure
+	fail_progress:
+		texgz_tex_delete(&dst);
 	fail_dst:
 	fail_convert:
 		texgz_tex_delete(&src);
@@ -117,14 +117,13 @@ int main(int argc, char** argv)
 			{
 				printf("mkdir drive/bluemarble/%i/%i\n", month, zoom);
 
-				int x;
-				int y;
-				for(y = y0; y <= y1; ++y)
+				int            x;
+				int            y;
+				nedgz_zorder_t zorder;
+				nedgz_zorder_init(&zorder, x0, y0, x1, y1);
+				while(nedgz_zorder_next(&zorder, &x, &y))
 				{
-					for(x = x0; x <= x1; ++x)
-					{
-						printf("cp bluemarble/%i/%i/%i_%i.pak drive/bluemarble/%i/%i/\n", month, zoom, x, y, month, zoom);
-					}
+					printf("cp bluemarble/%i/%i/%i_%i.pak drive/bluemarble/%i/%i/\n", month, zoom, x, y, month, zoom);
 				}
 			}
 		}
@@ -132,42 +131,39 @@ int main(int argc, char** argv)
 		{
 			printf("mkdir drive/osm/%i\n", zoom);
 
-			int x;
-			int y;
-			for(y = y0; y <= y1; ++y)
+			int            x;
+			int            y;
+			nedgz_zorder_t zorder;
+			nedgz_zorder_init(&zorder, x0, y0, x1, y1);
+			while(nedgz_zorder_next(&zorder, &x, &y))
 			{
-				for(x = x0; x <= x1; ++x)
-				{
-					printf("cp osm/%i/%i_%i.pak drive/osm/%i/\n", zoom, x, y, zoom);
-				}
+				printf("cp osm/%i/%i_%i.pak drive/osm/%i/\n", zoom, x, y, zoom);
 			}
 		}
 		else if(mode == MODE_NED)
 		{
 			printf("mkdir drive/ned/%i\n", zoom);
 
-			int x;
-			int y;
-			for(y = y0; y <= y1; ++y)
+			int            x;
+			int            y;
+			nedgz_zorder_t zorder;
+			nedgz_zorder_init(&zorder, x0, y0, x1, y1);
+			while(nedgz_zorder_next(&zorder, &x, &y))
 			{
-				for(x = x0; x <= x1; ++x)
-				{
-					printf("cp ned/%i/%i_%i.nedgz drive/ned/%i/\n", zoom, x, y, zoom);
-				}
+				printf("cp ned/%i/%i_%i.nedgz drive/ned/%i/\n", zoom, x, y, zoom);
 			}
 		}
 		else if(mode == MODE_HILLSHADE)
 		{
 			printf("mkdir drive/hillshade/%i\n", zoom);
 
-			int x;
-			int y;
-			for(y = y0; y <= y1; ++y)
+			int            x;
+			int            y;
+			nedgz_zorder_t zorder;
+			nedgz_zorder_init(&zorder, x0, y0, x1, y1);
+			while(nedgz_zorder_next(&zorder, &x, &y))
 			{
-				for(x = x0; x <= x1; ++x)
-				{
-					printf("cp hillshade/%i/%i_%i.pak drive/hillshade/%i/\n", zoom, x, y, zoom);
-				}
+				printf("cp hillshade/%i/%i_%i.pak drive/hillshade/%i/\n", zoom, x, y, zoom);
 			}
 		}
 	}
@@ -25,11 +25,17 @@
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include "flt_tile.h"
+#include "nedgz/nedgz_geom.h"
 #include "nedgz/nedgz_tile.h"
+#include "nedgz/nedgz_pool.h"
+#include "nedgz/nedgz_batch.h"
+#include "nedgz/nedgz_profile.h"
+#include "nedgz/nedgz_progress.h"
 #include "nedgz/nedgz_util.h"
 
 #define LOG_TAG "flt"
@@ -48,34 +54,51 @@ static flt_tile_t* flt_bl = NULL;
 static flt_tile_t* flt_bc = NULL;
 static flt_tile_t* flt_br = NULL;
 
+// recycles nedgz tiles between sample_tile calls
+static nedgz_pool_t* pool = NULL;
+
+// tiles are committed to disk after each flt_cc
+static nedgz_batch_t* batch = NULL;
+
+// skip tiles which were completed by a previous run
+static int resume = 0;
+
+// reports tiles/sec and the ETA
+static nedgz_progress_t* progress = NULL;
+static int stage_import = -1;
+static int stage_sample = -1;
+static int stage_commit = -1;
+
 static int sample_subtile(nedgz_tile_t* tile, int i, int j)
 {
 	assert(tile);
 	LOGD("debug i=%i, j=%i", i, j);
 
+	// lat only depends on m and lon only depends on n
+	double lat[NEDGZ_SUBTILE_SIZE];
+	double lon[NEDGZ_SUBTILE_SIZE];
+	nedgz_geom32_coordv(tile->x, tile->y, tile->zoom, i, j,
+	                    lat, lon);
+
 	int m;
 	int n;
 	for(m = 0; m < NEDGZ_SUBTILE_SIZE; ++m)
 	{
 		for(n = 0; n < NEDGZ_SUBTILE_SIZE; ++n)
 		{
-			double lat;
-			double lon;
-			nedgz_tile_coord(tile, i, j, m, n, &lat, &lon);
-
 			// flt_cc most likely place to find sample
 			// At edges of range a subtile may not be
 			// fully covered by flt_xx
 			short height;
-			if((flt_cc && flt_tile_sample(flt_cc, lat, lon, &height)) ||
-			   (flt_tc && flt_tile_sample(flt_tc, lat, lon, &height)) ||
-			   (flt_bc && flt_tile_sample(flt_bc, lat, lon, &height)) ||
-			   (flt_cl && flt_tile_sample(flt_cl, lat, lon, &height)) ||
-			   (flt_cr && flt_tile_sample(flt_cr, lat, lon, &height)) ||
-			   (flt_tl && flt_tile_sample(flt_tl, lat, lon, &height)) ||
-			   (flt_bl && flt_tile_sample(flt_bl, lat, lon, &height)) ||
-			   (flt_tr && flt_tile_sample(flt_tr, lat, lon, &height)) ||
-			   (flt_br && flt_tile_sample(flt_br, lat, lon, &height)))
+			if((flt_cc && flt_tile_sample(flt_cc, lat[m], lon[n], &height)) ||
+			   (flt_tc && flt_tile_sample(flt_tc, lat[m], lon[n], &height)) ||
+			   (flt_bc && flt_tile_sample(flt_bc, lat[m], lon[n], &height)) ||
+			   (flt_cl && flt_tile_sample(flt_cl, lat[m], lon[n], &height)) ||
+			   (flt_cr && flt_tile_sample(flt_cr, lat[m], lon[n], &height)) ||
+			   (flt_tl && flt_tile_sample(flt_tl, lat[m], lon[n], &height)) ||
+			   (flt_bl && flt_tile_sample(flt_bl, lat[m], lon[n], &height)) ||
+			   (flt_tr && flt_tile_sample(flt_tr, lat[m], lon[n], &height)) ||
+			   (flt_br && flt_tile_sample(flt_br, lat[m], lon[n], &height)))
 			{
 				if(nedgz_tile_set(tile, i, j, m, n, height) == 0)
 				{
@@ -92,13 +115,21 @@ static int sample_tile(int x, int y, int zoom)
 {
 	LOGD("debug x=%i, y=%i, zoom=%i", x, y, zoom);
 
-	nedgz_tile_t* tile = nedgz_tile_new(x, y, zoom);
+	if(resume && nedgz_tile_valid("ned", x, y, zoom))
+	{
+		nedgz_progress_skip(progress, 1);
+		return 1;
+	}
+
+	double t0 = nedgz_progress_begin(progress);
+	nedgz_tile_t* tile = nedgz_pool_get(pool, x, y, zoom);
 	if(tile == NULL)
 	{
 		return 0;
 	}
 
 	// sample subtiles i,j
+	NEDGZ_PROFILE_BEGIN(flt2ned_sample);
 	int j;
 	int i;
 	for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
@@ -107,16 +138,20 @@ static int sample_tile(int x, int y, int zoom)
 		{
 			if(sample_subtile(tile, i, j) == 0)
 			{
+				NEDGZ_PROFILE_END(flt2ned_sample);
 				goto fail_sample;
 			}
 		}
 	}
+	NEDGZ_PROFILE_END(flt2ned_sample);
 
-	if(nedgz_tile_export(tile, "ned") == 0)
+	if(nedgz_batch_export(batch, tile, "ned", 0) == 0)
 	{
 		goto fail_export;
 	}
-	nedgz_tile_delete(&tile);
+	nedgz_pool_put(pool, &tile);
+	nedgz_progress_end(progress, stage_sample, t0);
+	nedgz_progress_done(progress, 1);
 
 	// success
 	return 1;
@@ -124,7 +159,7 @@ static int sample_tile(int x, int y, int zoom)
 	// failure
 	fail_export:
 	fail_sample:
-		nedgz_tile_delete(&tile);
+		nedgz_pool_put(pool, &tile);
 	return 0;
 }
 
@@ -133,27 +168,38 @@ static int sample_tile_range(int x0, int y0, int x1, int y1, int zoom)
 	LOGD("debug x0=%i, y0=%i, x1=%i, y1=%i, zoom=%i", x0, y0, x1, y1, zoom);
 
 	// sample tiles whose origin should be in flt_cc
-	int x;
-	int y;
-	for(y = y0; y <= y1; ++y)
+	// in Z-order for locality of the output directories
+	int            x;
+	int            y;
+	nedgz_zorder_t zorder;
+	nedgz_zorder_init(&zorder, x0, y0, x1, y1);
+	while(nedgz_zorder_next(&zorder, &x, &y))
 	{
-		for(x = x0; x <= x1; ++x)
+		if(sample_tile(x, y, zoom) == 0)
 		{
-			if(sample_tile(x, y, zoom) == 0)
-			{
-				return 0;
-			}
+			return 0;
 		}
 	}
 
-	return 1;
+	double t0  = nedgz_progress_begin(progress);
+	int    ret = nedgz_batch_commit(batch);
+	nedgz_progress_end(progress, stage_commit, t0);
+	return ret;
 }
 
 int main(int argc, char** argv)
 {
+	// optionally resume an interrupted run
+	if((argc == 8) && (strcmp(argv[1], "-resume") == 0))
+	{
+		resume = 1;
+		--argc;
+		++argv;
+	}
+
 	if(argc != 7)
 	{
-		LOGE("usage: %s [arcs] [zoom] [latT] [lonL] [latB] [lonR]", argv[0]);
+		LOGE("usage: %s [-resume] [arcs] [zoom] [latT] [lonL] [latB] [lonR]", argv[0]);
 		return EXIT_FAILURE;
 	}
 
@@ -164,19 +210,51 @@ int main(int argc, char** argv)
 	int latB = (int) strtol(argv[5], NULL, 0);
 	int lonR = (int) strtol(argv[6], NULL, 0);
 
+	// only one tile is sampled at a time
+	pool = nedgz_pool_new(1);
+	if(pool == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+
+	batch = nedgz_batch_new();
+	if(batch == NULL)
+	{
+		goto fail_batch;
+	}
+
+	// estimate the tile count from the tile origins in the
+	// region covered by the flt tiles (excluding overlap)
+	float x0f;
+	float y0f;
+	float x1f;
+	float y1f;
+	nedgz_coord2tile((double) latT, (double) lonL, zoom, &x0f, &y0f);
+	nedgz_coord2tile((double) (latB - 1), (double) (lonR + 1), zoom,
+	                 &x1f, &y1f);
+	int count = ((int) floor(x1f) - (int) ceil(x0f) + 1)*
+	            ((int) floor(y1f) - (int) ceil(y0f) + 1);
+	progress = nedgz_progress_new("flt2ned", count);
+	if(progress == NULL)
+	{
+		goto fail_progress;
+	}
+	nedgz_batch_progress(batch, progress);
+	stage_import = nedgz_progress_stage(progress, "import");
+	stage_sample = nedgz_progress_stage(progress, "sample");
+	stage_commit = nedgz_progress_stage(progress, "commit");
+
 	int lati;
 	int lonj;
-	int idx   = 0;
-	int count = (latT - latB + 1)*(lonR - lonL + 1);
 	for(lati = latB; lati <= latT; ++lati)
 	{
 		for(lonj = lonL; lonj <= lonR; ++lonj)
 		{
-			// status message
-			++idx;
-			LOGI("%i/%i", idx, count);
+			LOGD("debug lat=%i, lon=%i", lati, lonj);
 
 			// initialize flt data
+			double t0 = nedgz_progress_begin(progress);
+			NEDGZ_PROFILE_BEGIN(flt2ned_import);
 			if(flt_tl == NULL)
 			{
 				flt_tl = flt_tile_import(arcs, lati + 1, lonj - 1);
@@ -213,6 +291,8 @@ int main(int argc, char** argv)
 			{
 				flt_br = flt_tile_import(arcs, lati - 1, lonj + 1);
 			}
+			NEDGZ_PROFILE_END(flt2ned_import);
+			nedgz_progress_end(progress, stage_import, t0);
 
 			// flt_cc may be NULL for sparse data
 			if(flt_cc)
@@ -287,6 +367,9 @@ int main(int argc, char** argv)
 		flt_tile_delete(&flt_cr);
 		flt_tile_delete(&flt_br);
 	}
+	nedgz_progress_delete(&progress);
+	nedgz_batch_delete(&batch);
+	nedgz_pool_delete(&pool);
 
 	// success
 	return EXIT_SUCCESS;
@@ -302,5 +385,10 @@ int main(int argc, char** argv)
 		flt_tile_delete(&flt_tr);
 		flt_tile_delete(&flt_cr);
 		flt_tile_delete(&flt_br);
+		nedgz_progress_delete(&progress);
+	fail_progress:
+		nedgz_batch_delete(&batch);
+	fail_batch:
+		nedgz_pool_delete(&pool);
 	return EXIT_FAILURE;
 }
@@ -28,6 +28,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include "nedgz/nedgz_path.h"
 #include "net/net_socket.h"
 #include "net/net_socket_wget.h"
 
@@ -49,31 +50,10 @@ int main(int argc, char** argv)
 
 	// create directories if necessary
 	char dname[256];
-	snprintf(dname, 256, "%s", "localhost");
-	if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+	snprintf(dname, 256, "%s", "localhost/osm/");
+	if(nedgz_path_mkdir(dname) == 0)
 	{
-		if(errno == EEXIST)
-		{
-			// already exists
-		}
-		else
-		{
-			LOGE("mkdir %s failed", dname);
-			return EXIT_FAILURE;
-		}
-	}
-	snprintf(dname, 256, "%s", "localhost/osm");
-	if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
-	{
-		if(errno == EEXIST)
-		{
-			// already exists
-		}
-		else
-		{
-			LOGE("mkdir %s failed", dname);
-			return EXIT_FAILURE;
-		}
+		return EXIT_FAILURE;
 	}
 
 	// open the list
@@ -106,18 +86,10 @@ int main(int argc, char** argv)
 
 		// create directories if necessary
 		char dname[256];
-		snprintf(dname, 256, "localhost/osm/%i", zoom);
-		if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+		snprintf(dname, 256, "localhost/osm/%i/", zoom);
+		if(nedgz_path_mkdir(dname) == 0)
 		{
-			if(errno == EEXIST)
-			{
-				// already exists
-			}
-			else
-			{
-				LOGE("mkdir %s failed", dname);
-				continue;
-			}
+			continue;
 		}
 
 		int i;
@@ -128,18 +100,10 @@ int main(int argc, char** argv)
 			for(j = 0; j < SUBTILE_COUNT; ++j)
 			{
 				int xj = SUBTILE_COUNT*x + j;
-				snprintf(dname, 256, "localhost/osm/%i/%i", zoom, xj);
-				if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+				snprintf(dname, 256, "localhost/osm/%i/%i/", zoom, xj);
+				if(nedgz_path_mkdir(dname) == 0)
 				{
-					if(errno == EEXIST)
-					{
-						// already exists
-					}
-					else
-					{
-						LOGE("mkdir %s failed", dname);
-						continue;
-					}
+					continue;
 				}
 
 				// osm server fails sometimes even if tile exists but since
@@ -181,7 +145,7 @@ int main(int argc, char** argv)
 				// save data
 				char fname[256];
 				snprintf(fname, 256, "localhost/osm/%i/%i/%i.png", zoom, xj, yi);
-				FILE* fdata = fopen(fname, "w");
+				FILE* fdata = nedgz_path_fopen(fname, "w");
 				if(fdata == NULL)
 				{
 					LOGE("fopen failed fname=%s", fname);
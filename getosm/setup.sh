@@ -1 +1,2 @@
+ln -s ../../nedgz
 ln -s ../../net
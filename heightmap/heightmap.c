@@ -30,6 +30,10 @@
 #include <sys/types.h>
 #include "flt_tile.h"
 #include "nedgz/nedgz_tile.h"
+#include "nedgz/nedgz_geom.h"
+#include "nedgz/nedgz_path.h"
+#include "nedgz/nedgz_profile.h"
+#include "nedgz/nedgz_progress.h"
 #include "nedgz/nedgz_util.h"
 #include "texgz/texgz_tex.h"
 #include "libpak/pak_file.h"
@@ -50,47 +54,12 @@ static flt_tile_t* flt_bl = NULL;
 static flt_tile_t* flt_bc = NULL;
 static flt_tile_t* flt_br = NULL;
 
-#define SUBTILE_SIZE 256
+#define SUBTILE_SIZE NEDGZ_GEOM256_SIZE
 
-static void subtile2coord(int x, int y, int zoom,
-                          int i, int j, int m, int n,
-                          double* lat, double* lon)
-{
-	assert(lat);
-	assert(lon);
-	LOGD("debug x=%i, y=%i, zoom=%i, i=%i, j=%i, m=%i, n=%i",
-	     x, y, zoom, i, j, m, n);
-
-	float s  = (float) SUBTILE_SIZE;
-	float c  = (float) NEDGZ_SUBTILE_COUNT;
-	float xx = (float) x;
-	float yy = (float) y;
-	float jj = (float) j;
-	float ii = (float) i;
-	float nn = (float) n/(s - 1.0f);
-	float mm = (float) m/(s - 1.0f);
-
-	nedgz_tile2coord(xx + (jj + nn)/c, yy + (ii + mm)/c,
-	                 zoom, lat, lon);
-}
-
-static void tile_coord(nedgz_tile_t* self, int i, int j, int m, int n,
-                       double* lat, double* lon)
-{
-	assert(self);
-	assert(i >= 0);
-	assert(i < NEDGZ_SUBTILE_COUNT);
-	assert(j >= 0);
-	assert(j < NEDGZ_SUBTILE_COUNT);
-	assert(m >= 0);
-	assert(m < SUBTILE_SIZE);
-	assert(n >= 0);
-	assert(n < SUBTILE_SIZE);
-	LOGD("debug i=%i, j=%i, m=%i, n=%i", i, j, m, n);
-
-	subtile2coord(self->x, self->y, self->zoom,
-	              i, j, m, n, lat, lon);
-}
+// reports tiles/sec and the ETA
+static nedgz_progress_t* progress = NULL;
+static int stage_import = -1;
+static int stage_sample = -1;
 
 static int sample_subtile(nedgz_tile_t* tile, int i, int j,
                           pak_file_t* pak)
@@ -110,29 +79,31 @@ static int sample_subtile(nedgz_tile_t* tile, int i, int j,
 		return 0;
 	}
 
+	// lat only depends on m and lon only depends on n
+	double lat[SUBTILE_SIZE];
+	double lon[SUBTILE_SIZE];
+	nedgz_geom256_coordv(tile->x, tile->y, tile->zoom, i, j,
+	                     lat, lon);
+
 	int m;
 	int n;
 	for(m = 0; m < SUBTILE_SIZE; ++m)
 	{
 		for(n = 0; n < SUBTILE_SIZE; ++n)
 		{
-			double lat;
-			double lon;
-			tile_coord(tile, i, j, m, n, &lat, &lon);
-
 			// flt_cc most likely place to find sample
 			// At edges of range a subtile may not be
 			// fully covered by flt_xx
 			short height;
-			if((flt_cc && flt_tile_sample(flt_cc, lat, lon, &height)) ||
-			   (flt_tc && flt_tile_sample(flt_tc, lat, lon, &height)) ||
-			   (flt_bc && flt_tile_sample(flt_bc, lat, lon, &height)) ||
-			   (flt_cl && flt_tile_sample(flt_cl, lat, lon, &height)) ||
-			   (flt_cr && flt_tile_sample(flt_cr, lat, lon, &height)) ||
-			   (flt_tl && flt_tile_sample(flt_tl, lat, lon, &height)) ||
-			   (flt_bl && flt_tile_sample(flt_bl, lat, lon, &height)) ||
-			   (flt_tr && flt_tile_sample(flt_tr, lat, lon, &height)) ||
-			   (flt_br && flt_tile_sample(flt_br, lat, lon, &height)))
+			if((flt_cc && flt_tile_sample(flt_cc, lat[m], lon[n], &height)) ||
+			   (flt_tc && flt_tile_sample(flt_tc, lat[m], lon[n], &height)) ||
+			   (flt_bc && flt_tile_sample(flt_bc, lat[m], lon[n], &height)) ||
+			   (flt_cl && flt_tile_sample(flt_cl, lat[m], lon[n], &height)) ||
+			   (flt_cr && flt_tile_sample(flt_cr, lat[m], lon[n], &height)) ||
+			   (flt_tl && flt_tile_sample(flt_tl, lat[m], lon[n], &height)) ||
+			   (flt_bl && flt_tile_sample(flt_bl, lat[m], lon[n], &height)) ||
+			   (flt_tr && flt_tile_sample(flt_tr, lat[m], lon[n], &height)) ||
+			   (flt_br && flt_tile_sample(flt_br, lat[m], lon[n], &height)))
 			{
 				short* pixels = (short*) tex->pixels;
 				pixels[m*SUBTILE_SIZE + n] = height;
@@ -146,11 +117,13 @@ static int sample_subtile(nedgz_tile_t* tile, int i, int j,
 	}
 
 	// j=dx, i=dy
+	NEDGZ_PROFILE_BEGIN(heightmap_export);
 	char fname[256];
 	snprintf(fname, 256, "%i_%i", j, i);
 	pak_file_writek(pak, fname);
 	texgz_tex_exportf(tex, pak->f);
 	texgz_tex_delete(&tex);
+	NEDGZ_PROFILE_END(heightmap_export);
 
 	return 1;
 }
@@ -161,20 +134,13 @@ static int sample_tile(int x, int y, int zoom)
 
 	// create directories if necessary
 	char dname[256];
-	snprintf(dname, 256, "heightmap/%i", zoom);
-	if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+	snprintf(dname, 256, "heightmap/%i/", zoom);
+	if(nedgz_path_mkdir(dname) == 0)
 	{
-		if(errno == EEXIST)
-		{
-			// already exists
-		}
-		else
-		{
-			LOGE("mkdir %s failed", dname);
-			return 0;
-		}
+		return 0;
 	}
 
+	double t0 = nedgz_progress_begin(progress);
 	nedgz_tile_t* tile = nedgz_tile_new(x, y, zoom);
 	if(tile == NULL)
 	{
@@ -184,6 +150,11 @@ static int sample_tile(int x, int y, int zoom)
 	char fname[256];
 	snprintf(fname, 256, "heightmap/%i/%i_%i.pak", zoom, x, y);
 	pak_file_t* pak = pak_file_open(fname, PAK_FLAG_WRITE);
+	if((pak == NULL) && nedgz_path_retry(fname))
+	{
+		pak = pak_file_open(fname, PAK_FLAG_WRITE);
+	}
+
 	if(pak == NULL)
 	{
 		goto fail_pak;
@@ -196,7 +167,10 @@ static int sample_tile(int x, int y, int zoom)
 	{
 		for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
 		{
-			if(sample_subtile(tile, i, j, pak) == 0)
+			NEDGZ_PROFILE_BEGIN(heightmap_subtile);
+			int sampled = sample_subtile(tile, i, j, pak);
+			NEDGZ_PROFILE_END(heightmap_subtile);
+			if(sampled == 0)
 			{
 				goto fail_sample;
 			}
@@ -205,6 +179,9 @@ static int sample_tile(int x, int y, int zoom)
 
 	pak_file_close(&pak);
 	nedgz_tile_delete(&tile);
+	nedgz_progress_writefile(progress, fname);
+	nedgz_progress_end(progress, stage_sample, t0);
+	nedgz_progress_done(progress, 1);
 
 	// success
 	return 1;
@@ -222,16 +199,16 @@ static int sample_tile_range(int x0, int y0, int x1, int y1, int zoom)
 	LOGD("debug x0=%i, y0=%i, x1=%i, y1=%i, zoom=%i", x0, y0, x1, y1, zoom);
 
 	// sample tiles whose origin should be in flt_cc
-	int x;
-	int y;
-	for(y = y0; y <= y1; ++y)
+	// in Z-order for locality of the output directories
+	int            x;
+	int            y;
+	nedgz_zorder_t zorder;
+	nedgz_zorder_init(&zorder, x0, y0, x1, y1);
+	while(nedgz_zorder_next(&zorder, &x, &y))
 	{
-		for(x = x0; x <= x1; ++x)
+		if(sample_tile(x, y, zoom) == 0)
 		{
-			if(sample_tile(x, y, zoom) == 0)
-			{
-				return 0;
-			}
+			return 0;
 		}
 	}
 
@@ -248,18 +225,10 @@ int main(int argc, char** argv)
 
 	// create directories if necessary
 	char dname[256];
-	snprintf(dname, 256, "%s", "heightmap");
-	if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+	snprintf(dname, 256, "%s", "heightmap/");
+	if(nedgz_path_mkdir(dname) == 0)
 	{
-		if(errno == EEXIST)
-		{
-			// already exists
-		}
-		else
-		{
-			LOGE("mkdir %s failed", dname);
-			return EXIT_FAILURE;
-		}
+		return EXIT_FAILURE;
 	}
 
 	int arcs = (int) strtol(argv[1], NULL, 0);
@@ -269,19 +238,36 @@ int main(int argc, char** argv)
 	int latB = (int) strtol(argv[5], NULL, 0);
 	int lonR = (int) strtol(argv[6], NULL, 0);
 
+	// estimate the tile count from the tile origins in the
+	// region covered by the flt tiles (excluding overlap)
+	float x0f;
+	float y0f;
+	float x1f;
+	float y1f;
+	nedgz_coord2tile((double) latT, (double) lonL, zoom, &x0f, &y0f);
+	nedgz_coord2tile((double) (latB - 1), (double) (lonR + 1), zoom,
+	                 &x1f, &y1f);
+	int count = ((int) floor(x1f) - (int) ceil(x0f) + 1)*
+	            ((int) floor(y1f) - (int) ceil(y0f) + 1);
+	progress = nedgz_progress_new("heightmap", count);
+	if(progress == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+	stage_import = nedgz_progress_stage(progress, "import");
+	stage_sample = nedgz_progress_stage(progress, "sample");
+
 	int lati;
 	int lonj;
-	int idx   = 0;
-	int count = (latT - latB + 1)*(lonR - lonL + 1);
 	for(lati = latB; lati <= latT; ++lati)
 	{
 		for(lonj = lonL; lonj <= lonR; ++lonj)
 		{
-			// status message
-			++idx;
-			LOGI("%i/%i", idx, count);
+			LOGD("debug lat=%i, lon=%i", lati, lonj);
 
 			// initialize flt data
+			double t0 = nedgz_progress_begin(progress);
+			NEDGZ_PROFILE_BEGIN(heightmap_import);
 			if(flt_tl == NULL)
 			{
 				flt_tl = flt_tile_import(arcs, lati + 1, lonj - 1);
@@ -318,6 +304,8 @@ int main(int argc, char** argv)
 			{
 				flt_br = flt_tile_import(arcs, lati - 1, lonj + 1);
 			}
+			NEDGZ_PROFILE_END(heightmap_import);
+			nedgz_progress_end(progress, stage_import, t0);
 
 			// flt_cc may be NULL for sparse data
 			if(flt_cc)
@@ -392,6 +380,7 @@ int main(int argc, char** argv)
 		flt_tile_delete(&flt_cr);
 		flt_tile_delete(&flt_br);
 	}
+	nedgz_progress_delete(&progress);
 
 	// success
 	return EXIT_SUCCESS;
@@ -407,5 +396,6 @@ int main(int argc, char** argv)
 		flt_tile_delete(&flt_tr);
 		flt_tile_delete(&flt_cr);
 		flt_tile_delete(&flt_br);
+		nedgz_progress_delete(&progress);
 	return EXIT_FAILURE;
 }
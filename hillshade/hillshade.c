@@ -27,6 +27,11 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include "nedgz/nedgz_cache.h"
+#include "nedgz/nedgz_geom.h"
+#include "nedgz/nedgz_path.h"
+#include "nedgz/nedgz_profile.h"
+#include "nedgz/nedgz_progress.h"
 #include "nedgz/nedgz_util.h"
 #include "nedgz/nedgz_tile.h"
 #include "texgz/texgz_tex.h"
@@ -36,7 +41,12 @@
 #include "texgz/texgz_log.h"
 
 #define GOTO_USE_3X3
-#define SUBTILE_SIZE 256
+#define SUBTILE_SIZE NEDGZ_GEOM256_SIZE
+
+// each heightmap subtile is used by up to nine hillshade
+// subtiles so decoded subtiles are cached
+#define CACHE_SIZE (64*1024*1024)
+static nedgz_cache_t* cache = NULL;
 
 // hillshading
 static pak_file_t* dst = NULL;
@@ -60,28 +70,15 @@ static texgz_tex_t* tex_cr = NULL;
 static texgz_tex_t* tex_bl = NULL;
 static texgz_tex_t* tex_bc = NULL;
 static texgz_tex_t* tex_br = NULL;
-
-static void subtile2coord(int x, int y, int zoom,
-                          int i, int j, int m, int n,
-                          double* lat, double* lon)
-{
-	assert(lat);
-	assert(lon);
-	LOGD("debug x=%i, y=%i, zoom=%i, i=%i, j=%i, m=%i, n=%i",
-	     x, y, zoom, i, j, m, n);
-
-	float s  = (float) SUBTILE_SIZE;
-	float c  = (float) NEDGZ_SUBTILE_COUNT;
-	float xx = (float) x;
-	float yy = (float) y;
-	float jj = (float) j;
-	float ii = (float) i;
-	float nn = (float) n/(s - 1.0f);
-	float mm = (float) m/(s - 1.0f);
-
-	nedgz_tile2coord(xx + (jj + nn)/c, yy + (ii + mm)/c,
-	                 zoom, lat, lon);
-}
+static nedgz_cacheitem_t* item_tl = NULL;
+static nedgz_cacheitem_t* item_tc = NULL;
+static nedgz_cacheitem_t* item_tr = NULL;
+static nedgz_cacheitem_t* item_cl = NULL;
+static nedgz_cacheitem_t* item_cc = NULL;
+static nedgz_cacheitem_t* item_cr = NULL;
+static nedgz_cacheitem_t* item_bl = NULL;
+static nedgz_cacheitem_t* item_bc = NULL;
+static nedgz_cacheitem_t* item_br = NULL;
 
 static void tile_coord(int x, int y, int zoom,
                        int i, int j,
@@ -93,13 +90,13 @@ static void tile_coord(int x, int y, int zoom,
 	assert(j >= 0);
 	assert(j < NEDGZ_SUBTILE_COUNT);
 	assert(m >= 0);
-	assert(m < 256);
+	assert(m < SUBTILE_SIZE);
 	assert(n >= 0);
-	assert(n < 256);
+	assert(n < SUBTILE_SIZE);
 	LOGD("debug i=%i, j=%i, m=%i, n=%i", i, j, m, n);
 
-	subtile2coord(x, y, zoom,
-	              i, j, m, n, lat, lon);
+	nedgz_geom256_coord(x, y, zoom,
+	                    i, j, m, n, lat, lon);
 }
 
 static void world_coord2xy(double lat, double lon,
@@ -119,53 +116,78 @@ static void world_coord2xy(double lat, double lon,
 	*y = (float) ((lat - home_lat)*lat2meter);
 }
 
-static texgz_tex_t* opentex(int i, int j)
+static void freetex(void* data)
 {
-	LOGD("debug i=%i, j=%i", i, j);
+	assert(data);
+	LOGD("debug");
+
+	texgz_tex_t* tex = (texgz_tex_t*) data;
+	texgz_tex_delete(&tex);
+}
+
+static texgz_tex_t* opentex(int zoom, int x, int y, int i, int j,
+                            nedgz_cacheitem_t** _item)
+{
+	assert(_item);
+	LOGD("debug zoom=%i, x=%i, y=%i, i=%i, j=%i", zoom, x, y, i, j);
+
+	*_item = NULL;
 
 	pak_file_t* pak = src_cc;
 	if((i < 0) && (j < 0))
 	{
 		i   += NEDGZ_SUBTILE_COUNT;
 		j   += NEDGZ_SUBTILE_COUNT;
+		x   -= 1;
+		y   -= 1;
 		pak  = src_tl;
 	}
 	else if((i >= NEDGZ_SUBTILE_COUNT) && (j < 0))
 	{
 		i   -= NEDGZ_SUBTILE_COUNT;
 		j   += NEDGZ_SUBTILE_COUNT;
+		x   -= 1;
+		y   += 1;
 		pak  = src_bl;
 	}
 	else if((i < 0) && (j >= NEDGZ_SUBTILE_COUNT))
 	{
 		i   += NEDGZ_SUBTILE_COUNT;
 		j   -= NEDGZ_SUBTILE_COUNT;
+		x   += 1;
+		y   -= 1;
 		pak  = src_tr;
 	}
 	else if((i >= NEDGZ_SUBTILE_COUNT) && (j >= NEDGZ_SUBTILE_COUNT))
 	{
 		i   -= NEDGZ_SUBTILE_COUNT;
 		j   -= NEDGZ_SUBTILE_COUNT;
+		x   += 1;
+		y   += 1;
 		pak  = src_br;
 	}
 	else if(i < 0)
 	{
 		i   += NEDGZ_SUBTILE_COUNT;
+		y   -= 1;
 		pak  = src_tc;
 	}
 	else if(i >= NEDGZ_SUBTILE_COUNT)
 	{
 		i   -= NEDGZ_SUBTILE_COUNT;
+		y   += 1;
 		pak  = src_bc;
 	}
 	else if(j < 0)
 	{
 		j   += NEDGZ_SUBTILE_COUNT;
+		x   -= 1;
 		pak  = src_cl;
 	}
 	else if(j >= NEDGZ_SUBTILE_COUNT)
 	{
 		j   -= NEDGZ_SUBTILE_COUNT;
+		x   += 1;
 		pak  = src_cr;
 	}
 
@@ -175,17 +197,43 @@ static texgz_tex_t* opentex(int i, int j)
 		return NULL;
 	}
 
+	// check the cache before decoding the subtile
+	int id = i*NEDGZ_SUBTILE_COUNT + j;
+	*_item = nedgz_cache_get(cache, zoom, x, y, id);
+	if(*_item)
+	{
+		NEDGZ_PROFILE_COUNT(hillshade_cache_hit, 1);
+		return (texgz_tex_t*) (*_item)->data;
+	}
+
 	char key[256];
 	snprintf(key, 256, "%i_%i", j, i);
 
 	// heightmap may be sparse
+	NEDGZ_PROFILE_BEGIN(hillshade_seek);
 	int size = pak_file_seek(pak, key);
+	NEDGZ_PROFILE_END(hillshade_seek);
 	if(size == 0)
 	{
 		return NULL;
 	}
 
-	return texgz_tex_importf(pak->f, size);
+	NEDGZ_PROFILE_BEGIN(hillshade_decode);
+	texgz_tex_t* tex = texgz_tex_importf(pak->f, size);
+	NEDGZ_PROFILE_END(hillshade_decode);
+	if(tex == NULL)
+	{
+		return NULL;
+	}
+	NEDGZ_PROFILE_COUNT(hillshade_decode_bytes, size);
+
+	*_item = nedgz_cache_put(cache, zoom, x, y, id, (void*) tex,
+	                         SUBTILE_SIZE*SUBTILE_SIZE*sizeof(short));
+	if(*_item == NULL)
+	{
+		return NULL;
+	}
+	return tex;
 }
 
 static float get_height(int c, int r)
@@ -485,21 +533,22 @@ static void sample_subtile(int zoom, int x, int y, int i, int j)
 	}
 
 	// open heightmap src
-	tex_cc = opentex(i, j);
+	tex_cc = opentex(zoom, x, y, i, j, &item_cc);
 	if(tex_cc == NULL)
 	{
 		goto fail_tex_cc;
 	}
-	tex_tl = opentex(i - 1, j - 1);
-	tex_tc = opentex(i - 1, j);
-	tex_tr = opentex(i - 1, j + 1);
-	tex_cl = opentex(i, j - 1);
-	tex_cr = opentex(i, j + 1);
-	tex_bl = opentex(i + 1, j - 1);
-	tex_bc = opentex(i + 1, j);
-	tex_br = opentex(i + 1, j + 1);
+	tex_tl = opentex(zoom, x, y, i - 1, j - 1, &item_tl);
+	tex_tc = opentex(zoom, x, y, i - 1, j,     &item_tc);
+	tex_tr = opentex(zoom, x, y, i - 1, j + 1, &item_tr);
+	tex_cl = opentex(zoom, x, y, i,     j - 1, &item_cl);
+	tex_cr = opentex(zoom, x, y, i,     j + 1, &item_cr);
+	tex_bl = opentex(zoom, x, y, i + 1, j - 1, &item_bl);
+	tex_bc = opentex(zoom, x, y, i + 1, j,     &item_bc);
+	tex_br = opentex(zoom, x, y, i + 1, j + 1, &item_br);
 
 	// compute hillshading
+	NEDGZ_PROFILE_BEGIN(hillshade_dz);
 	int m;
 	int n;
 	for(m = 0; m < SUBTILE_SIZE; ++m)
@@ -509,22 +558,35 @@ static void sample_subtile(int zoom, int x, int y, int i, int j)
 			compute_dz(tex, m, n, mask_dx, mask_dy);
 		}
 	}
+	NEDGZ_PROFILE_END(hillshade_dz);
 
 	// export hillshading
+	NEDGZ_PROFILE_BEGIN(hillshade_export);
 	char key[256];
 	snprintf(key, 256, "%i_%i", j, i);
 	pak_file_writek(dst, key);
 	texgz_tex_exportf(tex, dst->f);
-
-	texgz_tex_delete(&tex_tl);
-	texgz_tex_delete(&tex_tc);
-	texgz_tex_delete(&tex_tr);
-	texgz_tex_delete(&tex_cl);
-	texgz_tex_delete(&tex_cc);
-	texgz_tex_delete(&tex_cr);
-	texgz_tex_delete(&tex_bl);
-	texgz_tex_delete(&tex_bc);
-	texgz_tex_delete(&tex_br);
+	NEDGZ_PROFILE_END(hillshade_export);
+
+	// the heightmap src is owned by the cache
+	nedgz_cache_release(cache, &item_tl);
+	nedgz_cache_release(cache, &item_tc);
+	nedgz_cache_release(cache, &item_tr);
+	nedgz_cache_release(cache, &item_cl);
+	nedgz_cache_release(cache, &item_cc);
+	nedgz_cache_release(cache, &item_cr);
+	nedgz_cache_release(cache, &item_bl);
+	nedgz_cache_release(cache, &item_bc);
+	nedgz_cache_release(cache, &item_br);
+	tex_tl = NULL;
+	tex_tc = NULL;
+	tex_tr = NULL;
+	tex_cl = NULL;
+	tex_cc = NULL;
+	tex_cr = NULL;
+	tex_bl = NULL;
+	tex_bc = NULL;
+	tex_br = NULL;
 fail_tex_cc:
 	texgz_tex_delete(&tex);
 }
@@ -541,18 +603,16 @@ int main(int argc, char** argv)
 
 	// create directories if necessary
 	char dname[256];
-	snprintf(dname, 256, "%s", "hillshade");
-	if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+	snprintf(dname, 256, "%s", "hillshade/");
+	if(nedgz_path_mkdir(dname) == 0)
 	{
-		if(errno == EEXIST)
-		{
-			// already exists
-		}
-		else
-		{
-			LOGE("mkdir %s failed", dname);
-			return EXIT_FAILURE;
-		}
+		return EXIT_FAILURE;
+	}
+
+	cache = nedgz_cache_new(CACHE_SIZE, freetex);
+	if(cache == NULL)
+	{
+		return EXIT_FAILURE;
 	}
 
 	// open the list
@@ -560,13 +620,31 @@ int main(int argc, char** argv)
 	if(f == NULL)
 	{
 		LOGE("failed to open %s", argv[1]);
+		nedgz_cache_delete(&cache);
+		return EXIT_FAILURE;
+	}
+
+	// count the tiles for the progress
+	char* line  = NULL;
+	size_t n    = 0;
+	int   count = 0;
+	while(getline(&line, &n, f) > 0)
+	{
+		++count;
+	}
+	rewind(f);
+
+	nedgz_progress_t* progress = nedgz_progress_new("hillshade", count);
+	if(progress == NULL)
+	{
+		free(line);
+		fclose(f);
+		nedgz_cache_delete(&cache);
 		return EXIT_FAILURE;
 	}
+	int stage_shade = nedgz_progress_stage(progress, "shade");
 
 	// iteratively pak hillshade images
-	char* line = NULL;
-	size_t n   = 0;
-	int index = 0;
 	while(getline(&line, &n, f) > 0)
 	{
 		int x;
@@ -575,33 +653,37 @@ int main(int argc, char** argv)
 		if(sscanf(line, "%i %i %i", &zoom, &x, &y) != 3)
 		{
 			LOGE("invalid line=%s", line);
+			nedgz_progress_fail(progress, 1);
 			continue;
 		}
 
-		LOGI("%i: zoom=%i, x=%i, y=%i", index++, zoom, x, y);
+		LOGD("debug zoom=%i, x=%i, y=%i", zoom, x, y);
+		double t0 = nedgz_progress_begin(progress);
+		NEDGZ_PROFILE_BEGIN(hillshade_tile);
 
 		// create directories if necessary
 		char dname[256];
-		snprintf(dname, 256, "hillshade/%i", zoom);
-		if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+		snprintf(dname, 256, "hillshade/%i/", zoom);
+		if(nedgz_path_mkdir(dname) == 0)
 		{
-			if(errno == EEXIST)
-			{
-				// already exists
-			}
-			else
-			{
-				LOGE("mkdir %s failed", dname);
-				continue;
-			}
+			NEDGZ_PROFILE_END(hillshade_tile);
+			nedgz_progress_fail(progress, 1);
+			continue;
 		}
 
 		// open hillshade dst
 		char fname[256];
 		snprintf(fname, 256, "hillshade/%i/%i_%i.pak", zoom, x, y);
 		dst = pak_file_open(fname, PAK_FLAG_WRITE);
+		if((dst == NULL) && nedgz_path_retry(fname))
+		{
+			dst = pak_file_open(fname, PAK_FLAG_WRITE);
+		}
+
 		if(dst == NULL)
 		{
+			NEDGZ_PROFILE_END(hillshade_tile);
+			nedgz_progress_fail(progress, 1);
 			continue;
 		}
 
@@ -612,8 +694,11 @@ int main(int argc, char** argv)
 		if(src_cc == NULL)
 		{
 			pak_file_close(&dst);
+			NEDGZ_PROFILE_END(hillshade_tile);
+			nedgz_progress_skip(progress, 1);
 			continue;
 		}
+		nedgz_progress_readfile(progress, fname);
 		snprintf(fname, 256, "heightmap/%i/%i_%i.pak", zoom, x - 1, y - 1);
 		src_tl = pak_file_open(fname, PAK_FLAG_READ);
 		snprintf(fname, 256, "heightmap/%i/%i_%i.pak", zoom, x, y - 1);
@@ -651,8 +736,23 @@ int main(int argc, char** argv)
 		pak_file_close(&src_bc);
 		pak_file_close(&src_br);
 		pak_file_close(&dst);
+
+		snprintf(fname, 256, "hillshade/%i/%i_%i.pak", zoom, x, y);
+		NEDGZ_PROFILE_END(hillshade_tile);
+		nedgz_progress_writefile(progress, fname);
+		nedgz_progress_end(progress, stage_shade, t0);
+		nedgz_progress_done(progress, 1);
 	}
 	free(line);
+	fclose(f);
+	nedgz_progress_delete(&progress);
+
+	int    hits;
+	int    misses;
+	size_t size;
+	nedgz_cache_stats(cache, &hits, &misses, &size);
+	LOGI("cache hits=%i, misses=%i", hits, misses);
+	nedgz_cache_delete(&cache);
 
 	return EXIT_SUCCESS;
 }
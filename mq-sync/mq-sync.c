@@ -30,6 +30,7 @@
 #include <signal.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include "nedgz/nedgz_path.h"
 #include "nedgz/nedgz_tile.h"
 #include "nedgz/nedgz_util.h"
 #include "net/net_socket.h"
@@ -43,8 +44,7 @@ typedef struct
 {
 	int             idx;
 	int             cnt;
-	int             x;
-	int             y;
+	nedgz_zorder_t  zorder;
 	int             x0;
 	int             y0;
 	int             x1;
@@ -110,20 +110,8 @@ static int mq_state_next(int id, int* x, int* y)
 	}
 	++gstate->idx;
 
-	// increment x, y except for the first step
-	if(gstate->idx > 1)
-	{
-		++gstate->x;
-		if(gstate->x > gstate->x1)
-		{
-			gstate->x = gstate->x0;
-			++gstate->y;
-		}
-	}
-
-	// update state
-	*x = gstate->x;
-	*y = gstate->y;
+	// walk the tiles in Z-order
+	nedgz_zorder_next(&gstate->zorder, x, y);
 
 	pthread_mutex_unlock(&gstate->mutex);
 	return 1;
@@ -147,56 +135,9 @@ static int mq_sync(int id, int xx, int yy)
 	 * create directories
 	 */
 
-	char dir[256];
-	snprintf(dir, 256, "%s", "mq");
-	if(access(dir, R_OK) != 0)
-	{
-		if(mkdir(dir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
-		{
-			if(errno == EEXIST)
-			{
-				// already exists
-			}
-			else
-			{
-				LOGE("mkdir %s failed", dir);
-				return 0;
-			}
-		}
-	}
-
-	snprintf(dir, 256, "%s/%i", "mq", gstate->zoom);
-	if(access(dir, R_OK) != 0)
-	{
-		if(mkdir(dir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
-		{
-			if(errno == EEXIST)
-			{
-				// already exists
-			}
-			else
-			{
-				LOGE("mkdir %s failed", dir);
-				return 0;
-			}
-		}
-	}
-
-	snprintf(dir, 256, "%s/%i/%i", "mq", gstate->zoom, xx);
-	if(access(dir, R_OK) != 0)
+	if(nedgz_path_mkdir(fname) == 0)
 	{
-		if(mkdir(dir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
-		{
-			if(errno == EEXIST)
-			{
-				// already exists
-			}
-			else
-			{
-				LOGE("mkdir %s failed", dir);
-				return 0;
-			}
-		}
+		return 0;
 	}
 
 	// connect to MapQuest storage
@@ -224,7 +165,7 @@ static int mq_sync(int id, int xx, int yy)
 	// open file.part
 	char pname[256];
 	snprintf(pname, 256, "%s%s", fname, ".part");
-	FILE* f = fopen(pname, "w");
+	FILE* f = nedgz_path_fopen(pname, "w");
 	if(f == NULL)
 	{
 		LOGE("fopen %s failed", pname);
@@ -356,9 +297,10 @@ int main(int argc, char** argv)
 	gstate->zoom = zoom;
 	gstate->cnt  = (gstate->x1 - gstate->x0 + 1)*
 	               (gstate->y1 - gstate->y0 + 1);
-	gstate->x    = gstate->x0;
-	gstate->y    = gstate->y0;
 	gstate->quit = 0;
+	nedgz_zorder_init(&gstate->zorder,
+	                  gstate->x0, gstate->y0,
+	                  gstate->x1, gstate->y1);
 
 	// PTHREAD_MUTEX_DEFAULT is not re-entrant
 	if(pthread_mutex_init(&gstate->mutex, NULL) != 0)
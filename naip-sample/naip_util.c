@@ -29,6 +29,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include "naip_util.h"
+#include "nedgz/nedgz_path.h"
 
 #define LOG_TAG "naip"
 #include "a3d/a3d_log.h"
@@ -37,39 +38,7 @@ int naip_mkdir(const char* fname)
 {
 	assert(fname);
 
-	int  len = strnlen(fname, 255);
-	char dir[256];
-	int  i;
-	for(i = 0; i < len; ++i)
-	{
-		dir[i]     = fname[i];
-		dir[i + 1] = '\0';
-
-		if(dir[i] == '/')
-		{
-			if(access(dir, R_OK) == 0)
-			{
-				// dir already exists
-				continue;
-			}
-
-			// try to mkdir
-			if(mkdir(dir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
-			{
-				if(errno == EEXIST)
-				{
-					// already exists
-				}
-				else
-				{
-					LOGE("mkdir %s failed", dir);
-					return 0;
-				}
-			}
-		}
-	}
-
-	return 1;
+	return nedgz_path_mkdir(fname);
 }
 
 int naip_exists(const char* fname)
@@ -3,3 +3,4 @@ ln -s ../../libexpat
 ln -s ../../texgz
 ln -s ../../terrain
 ln -s ../../libpak
+ln -s ../../nedgz
@@ -50,6 +50,9 @@ static void coord2xy(double lat, double lon,
 	*y = (float) ((lat - home_lat)*lat2meter);
 }
 
+// flat copy of the tile heights
+static short heights[NEDGZ_TILE_SIZE*NEDGZ_TILE_SIZE];
+
 static void getp(nedgz_tile_t* tile, float s, int r, int c, float* x, float* y, float* z)
 {
 	assert(tile);
@@ -62,8 +65,7 @@ static void getp(nedgz_tile_t* tile, float s, int r, int c, float* x, float* y,
 	int j = c/NEDGZ_SUBTILE_SIZE;
 	int m = r % NEDGZ_SUBTILE_SIZE;
 	int n = c % NEDGZ_SUBTILE_SIZE;
-	short height = 0;
-	nedgz_tile_height(tile, i, j, m, n, &height);
+	short height = heights[r*NEDGZ_TILE_SIZE + c];
 	*z = nedgz_feet2meters((float) height);
 
 	double lat;
@@ -92,6 +94,7 @@ int main(int argc, char** argv)
 	{
 		return EXIT_FAILURE;
 	}
+	nedgz_tile_getdata(tile, heights);
 
 	FILE* f = fopen(argv[5], "w");
 	if(f == NULL)
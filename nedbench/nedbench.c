@@ -0,0 +1,762 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "nedgz/nedgz_codec.h"
+#include "nedgz/nedgz_cull.h"
+#include "nedgz/nedgz_path.h"
+#include "nedgz/nedgz_scenearray.h"
+#include "nedgz/nedgz_tile.h"
+#include "nedgz/nedgz_util.h"
+#include "nedbench_suite.h"
+
+#define LOG_TAG "nedbench"
+#include "nedgz/nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+#define BENCH_CODECS 2
+
+static const char* BENCH_CODEC_NAME[BENCH_CODECS] =
+{
+	"zlib",
+	"predict",
+};
+
+#define BENCH_FORMATS 3
+
+static const char* BENCH_FORMAT_NAME[BENCH_FORMATS] =
+{
+	"v1",
+	"v3-zlib",
+	"v3-predict",
+};
+
+static const int BENCH_FORMAT_FLAGS[BENCH_FORMATS] =
+{
+	NEDGZ_FLAG_V1,
+	0,
+	NEDGZ_FLAG_PREDICT,
+};
+
+static double bench_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + ((double) ts.tv_nsec)/1.0e9;
+}
+
+typedef struct
+{
+	int            count;
+	int            max_count;
+	int*           size[BENCH_CODECS];
+	unsigned char* block[BENCH_CODECS];
+} bench_blocks_t;
+
+static int bench_blocks_add(bench_blocks_t* self,
+                            nedgz_subtile_t* subtile)
+{
+	assert(self);
+	assert(subtile);
+	LOGD("debug");
+
+	// grow the block arrays
+	if(self->count == self->max_count)
+	{
+		int max_count = self->max_count ? 2*self->max_count : 64;
+
+		int c;
+		for(c = 0; c < BENCH_CODECS; ++c)
+		{
+			int* size = (int*) realloc(self->size[c],
+			                           max_count*sizeof(int));
+			if(size == NULL)
+			{
+				LOGE("realloc failed");
+				return 0;
+			}
+			self->size[c] = size;
+
+			unsigned char* block;
+			block = (unsigned char*) realloc(self->block[c],
+			                                 max_count*NEDGZ_CODEC_BOUND);
+			if(block == NULL)
+			{
+				LOGE("realloc failed");
+				return 0;
+			}
+			self->block[c] = block;
+		}
+		self->max_count = max_count;
+	}
+
+	int c;
+	for(c = 0; c < BENCH_CODECS; ++c)
+	{
+		unsigned char* block = &self->block[c][self->count*NEDGZ_CODEC_BOUND];
+		int bytes = nedgz_codec_encode(subtile, c, block,
+		                               NEDGZ_CODEC_BOUND);
+		if(bytes == 0)
+		{
+			return 0;
+		}
+
+		// verify the round trip
+		nedgz_subtile_t test;
+		if((nedgz_codec_decode(&test, block, bytes) == 0) ||
+		   (memcmp(test.data, subtile->data, sizeof(test.data)) != 0))
+		{
+			LOGE("%s round trip failed", BENCH_CODEC_NAME[c]);
+			return 0;
+		}
+		self->size[c][self->count] = bytes;
+	}
+	++self->count;
+
+	return 1;
+}
+
+static void bench_blocks_free(bench_blocks_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	int c;
+	for(c = 0; c < BENCH_CODECS; ++c)
+	{
+		free(self->size[c]);
+		free(self->block[c]);
+	}
+}
+
+static int bench_codec(const char* lname, int repeat)
+{
+	assert(lname);
+	LOGD("debug lname=%s, repeat=%i", lname, repeat);
+
+	FILE* f = fopen(lname, "r");
+	if(f == NULL)
+	{
+		LOGE("failed to open %s", lname);
+		return 0;
+	}
+
+	// encode the subtiles of each tile in the list
+	bench_blocks_t blocks;
+	memset((void*) &blocks, 0, sizeof(bench_blocks_t));
+
+	char*  line  = NULL;
+	size_t n     = 0;
+	int    tiles = 0;
+	while(getline(&line, &n, f) > 0)
+	{
+		int x;
+		int y;
+		int zoom;
+		if(sscanf(line, "%i %i %i", &zoom, &x, &y) != 3)
+		{
+			LOGE("invalid line=%s", line);
+			continue;
+		}
+
+		nedgz_tile_t* ned = nedgz_tile_import(".", x, y, zoom);
+		if(ned == NULL)
+		{
+			continue;
+		}
+
+		int i;
+		int j;
+		for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+		{
+			for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+			{
+				nedgz_subtile_t* subtile = nedgz_tile_getij(ned, i, j);
+				if(subtile &&
+				   (bench_blocks_add(&blocks, subtile) == 0))
+				{
+					nedgz_tile_delete(&ned);
+					goto fail_add;
+				}
+			}
+		}
+		nedgz_tile_delete(&ned);
+		++tiles;
+	}
+	free(line);
+	line = NULL;
+
+	if(blocks.count == 0)
+	{
+		LOGE("no subtiles in %s", lname);
+		goto fail_empty;
+	}
+
+	// decode the subtiles repeatedly
+	double raw = (double) blocks.count*sizeof(nedgz_subtile_t);
+	LOGI("tiles=%i, subtiles=%i, raw=%0.0lf", tiles, blocks.count, raw);
+
+	int c;
+	for(c = 0; c < BENCH_CODECS; ++c)
+	{
+		int    k;
+		int    r;
+		double bytes = 0.0;
+		for(k = 0; k < blocks.count; ++k)
+		{
+			bytes += (double) blocks.size[c][k];
+		}
+
+		nedgz_subtile_t subtile;
+		double t0 = bench_time();
+		for(r = 0; r < repeat; ++r)
+		{
+			for(k = 0; k < blocks.count; ++k)
+			{
+				nedgz_codec_decode(&subtile,
+				                   &blocks.block[c][k*NEDGZ_CODEC_BOUND],
+				                   blocks.size[c][k]);
+			}
+		}
+		double dt = bench_time() - t0;
+
+		LOGI("%-8s bytes=%0.0lf, ratio=%0.3lf, decode=%0.1lf MB/s, %0.0lf ns/subtile",
+		     BENCH_CODEC_NAME[c], bytes, raw/bytes,
+		     repeat*raw/dt/(1024.0*1024.0),
+		     1.0e9*dt/((double) repeat*blocks.count));
+	}
+
+	bench_blocks_free(&blocks);
+	fclose(f);
+
+	// success
+	return 1;
+
+	// failure
+	fail_empty:
+	fail_add:
+		free(line);
+		bench_blocks_free(&blocks);
+		fclose(f);
+	return 0;
+}
+
+static void bench_tiles_free(nedgz_tile_t** tiles, int count)
+{
+	// tiles may be NULL
+	LOGD("debug count=%i", count);
+
+	int k;
+	for(k = 0; k < count; ++k)
+	{
+		nedgz_tile_delete(&tiles[k]);
+	}
+	free(tiles);
+}
+
+static void bench_io_remove(nedgz_tile_t** tiles, int count,
+                            const char* base)
+{
+	assert(tiles);
+	assert(base);
+	LOGD("debug count=%i, base=%s", count, base);
+
+	char fname[256];
+	int  k;
+	for(k = 0; k < count; ++k)
+	{
+		snprintf(fname, 256, "%s/%i/%i_%i.nedgz", base,
+		         tiles[k]->zoom, tiles[k]->x, tiles[k]->y);
+		remove(fname);
+	}
+
+	for(k = 0; k < count; ++k)
+	{
+		snprintf(fname, 256, "%s/%i", base, tiles[k]->zoom);
+		rmdir(fname);
+	}
+	rmdir(base);
+	// the removed directories must be created again
+	nedgz_path_reset();
+}
+
+static int bench_io(const char* lname, int repeat)
+{
+	assert(lname);
+	LOGD("debug lname=%s, repeat=%i", lname, repeat);
+
+	FILE* f = fopen(lname, "r");
+	if(f == NULL)
+	{
+		LOGE("failed to open %s", lname);
+		return 0;
+	}
+
+	// import the tiles in the list
+	char*          line      = NULL;
+	size_t         n         = 0;
+	int            count     = 0;
+	int            max_count = 0;
+	nedgz_tile_t** tiles     = NULL;
+	while(getline(&line, &n, f) > 0)
+	{
+		int x;
+		int y;
+		int zoom;
+		if(sscanf(line, "%i %i %i", &zoom, &x, &y) != 3)
+		{
+			LOGE("invalid line=%s", line);
+			continue;
+		}
+
+		if(count == max_count)
+		{
+			max_count = max_count ? 2*max_count : 64;
+
+			nedgz_tile_t** tmp;
+			tmp = (nedgz_tile_t**)
+			      realloc(tiles, max_count*sizeof(nedgz_tile_t*));
+			if(tmp == NULL)
+			{
+				LOGE("realloc failed");
+				goto fail_realloc;
+			}
+			tiles = tmp;
+		}
+
+		tiles[count] = nedgz_tile_import(".", x, y, zoom);
+		if(tiles[count])
+		{
+			++count;
+		}
+	}
+	free(line);
+	line = NULL;
+
+	if(count == 0)
+	{
+		LOGE("no tiles in %s", lname);
+		goto fail_empty;
+	}
+
+	// export and import the tiles repeatedly in each format
+	LOGI("tiles=%i, repeat=%i", count, repeat);
+
+	const char* base = "nedbench-io";
+	int         fmt;
+	for(fmt = 0; fmt < BENCH_FORMATS; ++fmt)
+	{
+		int    k;
+		int    r;
+		double t0 = bench_time();
+		for(r = 0; r < repeat; ++r)
+		{
+			for(k = 0; k < count; ++k)
+			{
+				if(nedgz_tile_exportflags(tiles[k], base,
+				                          BENCH_FORMAT_FLAGS[fmt]) == 0)
+				{
+					goto fail_export;
+				}
+			}
+		}
+		double dt_export = bench_time() - t0;
+
+		t0 = bench_time();
+		for(r = 0; r < repeat; ++r)
+		{
+			for(k = 0; k < count; ++k)
+			{
+				nedgz_tile_t* ned;
+				ned = nedgz_tile_import(base, tiles[k]->x,
+				                        tiles[k]->y, tiles[k]->zoom);
+				if(ned == NULL)
+				{
+					goto fail_import;
+				}
+				nedgz_tile_delete(&ned);
+			}
+		}
+		double dt_import = bench_time() - t0;
+
+		bench_io_remove(tiles, count, base);
+
+		LOGI("%-10s export=%0.1lf tiles/s, import=%0.1lf tiles/s",
+		     BENCH_FORMAT_NAME[fmt],
+		     (double) repeat*count/dt_export,
+		     (double) repeat*count/dt_import);
+	}
+
+	bench_tiles_free(tiles, count);
+	fclose(f);
+
+	// success
+	return 1;
+
+	// failure
+	fail_import:
+	fail_export:
+		bench_io_remove(tiles, count, base);
+	fail_empty:
+	fail_realloc:
+		free(line);
+		bench_tiles_free(tiles, count);
+		fclose(f);
+	return 0;
+}
+
+static int bench_coord(const char* lname, int repeat)
+{
+	assert(lname);
+	LOGD("debug lname=%s, repeat=%i", lname, repeat);
+
+	FILE* f = fopen(lname, "r");
+	if(f == NULL)
+	{
+		LOGE("failed to open %s", lname);
+		return 0;
+	}
+
+	// transform every sample of the tiles in the list with
+	// the scalar and batch functions
+	char*  line  = NULL;
+	size_t n     = 0;
+	int    count = 0;
+	int    bad   = 0;
+	double dt_scalar  = 0.0;
+	double dt_batch   = 0.0;
+	double dt_rscalar = 0.0;
+	double dt_rbatch  = 0.0;
+	while(getline(&line, &n, f) > 0)
+	{
+		int x;
+		int y;
+		int zoom;
+		if(sscanf(line, "%i %i %i", &zoom, &x, &y) != 3)
+		{
+			LOGE("invalid line=%s", line);
+			continue;
+		}
+		++count;
+
+		int    i;
+		int    j;
+		int    m;
+		int    k;
+		int    r;
+		double lat[NEDGZ_SUBTILE_SIZE];
+		double lon[NEDGZ_SUBTILE_SIZE];
+		double lat0[NEDGZ_SUBTILE_SIZE][NEDGZ_SUBTILE_SIZE];
+		double lon0[NEDGZ_SUBTILE_SIZE][NEDGZ_SUBTILE_SIZE];
+		float  u[NEDGZ_SUBTILE_SIZE];
+		float  v[NEDGZ_SUBTILE_SIZE];
+		float  u0[NEDGZ_SUBTILE_SIZE];
+		float  v0[NEDGZ_SUBTILE_SIZE];
+		for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+		{
+			for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+			{
+				double t0 = bench_time();
+				for(r = 0; r < repeat; ++r)
+				{
+					for(m = 0; m < NEDGZ_SUBTILE_SIZE; ++m)
+					{
+						for(k = 0; k < NEDGZ_SUBTILE_SIZE; ++k)
+						{
+							nedgz_subtile2coord(x, y, zoom, i, j, m, k,
+							                    &lat0[m][k], &lon0[m][k]);
+						}
+					}
+				}
+				double t1 = bench_time();
+				for(r = 0; r < repeat; ++r)
+				{
+					nedgz_subtile2coordv(x, y, zoom, i, j,
+					                     NEDGZ_SUBTILE_SIZE, lat, lon);
+				}
+				double t2 = bench_time();
+				dt_scalar += t1 - t0;
+				dt_batch  += t2 - t1;
+
+				// the reverse transform of the diagonal
+				t0 = bench_time();
+				for(r = 0; r < repeat; ++r)
+				{
+					for(m = 0; m < NEDGZ_SUBTILE_SIZE; ++m)
+					{
+						nedgz_coord2tile(lat[m], lon[m], zoom,
+						                 &u0[m], &v0[m]);
+					}
+				}
+				t1 = bench_time();
+				for(r = 0; r < repeat; ++r)
+				{
+					nedgz_lon2tilev(NEDGZ_SUBTILE_SIZE, lon, zoom, u);
+					nedgz_lat2tilev(NEDGZ_SUBTILE_SIZE, lat, zoom, v);
+				}
+				t2 = bench_time();
+				dt_rscalar += t1 - t0;
+				dt_rbatch  += t2 - t1;
+
+				// the batch results must match exactly
+				for(m = 0; m < NEDGZ_SUBTILE_SIZE; ++m)
+				{
+					for(k = 0; k < NEDGZ_SUBTILE_SIZE; ++k)
+					{
+						if((lat0[m][k] != lat[m]) ||
+						   (lon0[m][k] != lon[k]))
+						{
+							++bad;
+						}
+					}
+
+					if((u0[m] != u[m]) || (v0[m] != v[m]))
+					{
+						++bad;
+					}
+				}
+			}
+		}
+	}
+	free(line);
+	fclose(f);
+
+	if(count == 0)
+	{
+		LOGE("no tiles in %s", lname);
+		return 0;
+	}
+
+	double samples = (double) repeat*count*NEDGZ_TILE_SIZE*
+	                 NEDGZ_TILE_SIZE;
+	double rsamples = (double) repeat*count*NEDGZ_SUBTILE_COUNT*
+	                  NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_SIZE;
+	LOGI("tiles=%i, repeat=%i, bad=%i", count, repeat, bad);
+	LOGI("tile2coord scalar=%0.1lf Msamples/s, batch=%0.1lf Msamples/s",
+	     samples/dt_scalar/1.0e6, samples/dt_batch/1.0e6);
+	LOGI("coord2tile scalar=%0.1lf Msamples/s, batch=%0.1lf Msamples/s",
+	     rsamples/dt_rscalar/1.0e6, rsamples/dt_rbatch/1.0e6);
+
+	return bad ? 0 : 1;
+}
+
+static int bench_cull(const char* sname, int frames)
+{
+	assert(sname);
+	LOGD("debug sname=%s, frames=%i", sname, frames);
+
+	if(frames <= 0)
+	{
+		LOGE("invalid frames=%i", frames);
+		return 0;
+	}
+
+	double t0 = bench_time();
+	nedgz_scenearray_t* scene = nedgz_scenearray_import(sname);
+	if(scene == NULL)
+	{
+		return 0;
+	}
+	LOGI("nodes=%i, import=%0.3lf ms", scene->count,
+	     1000.0*(bench_time() - t0));
+
+	nedgz_cull_t* cull = nedgz_cull_new();
+	if(cull == NULL)
+	{
+		goto fail_cull;
+	}
+
+	// fly from San Francisco to New York looking ahead
+	// and slightly down
+	double lat0 = 37.7;
+	double lon0 = -122.4;
+	double lat1 = 40.7;
+	double lon1 = -74.0;
+
+	double    dt        = 0.0;
+	long long visited   = 0;
+	long long frustum   = 0;
+	long long horizon   = 0;
+	long long selected  = 0;
+	int       max_count = 0;
+	int       f;
+	for(f = 0; f < frames; ++f)
+	{
+		double s   = (frames > 1) ? ((double) f)/(frames - 1) : 0.0;
+		double lat = lat0 + s*(lat1 - lat0);
+		double lon = lon0 + s*(lon1 - lon0);
+
+		// climb to cruise altitude and descend
+		double alt = 500.0 + 9500.0*sin(M_PI*s);
+
+		nedgz_cullcamera_t camera;
+		nedgz_cull_camera(&camera, lat, lon, alt, 80.0, -15.0,
+		                  60.0, 16.0/9.0, 1.0, 1.0e6, 1080, 16.0);
+
+		t0 = bench_time();
+		if(nedgz_cull_update(cull, scene, NEDGZ_SCENE_NED, &camera,
+		                     NEDGZ_SCENE_MAXZOOM) == 0)
+		{
+			goto fail_update;
+		}
+		dt += bench_time() - t0;
+
+		visited  += cull->visited;
+		frustum  += cull->culled_frustum;
+		horizon  += cull->culled_horizon;
+		selected += cull->count;
+		if(cull->count > max_count)
+		{
+			max_count = cull->count;
+		}
+
+		if((f == 0) || (f == frames/2) || (f == frames - 1))
+		{
+			LOGI("frame=%i, lat=%0.2lf, lon=%0.2lf, alt=%0.0lf, visited=%i, frustum=%i, horizon=%i, refined=%i, selected=%i",
+			     f, lat, lon, alt, cull->visited, cull->culled_frustum,
+			     cull->culled_horizon, cull->refined, cull->count);
+		}
+	}
+
+	LOGI("frames=%i, %0.1lf us/frame", frames, 1.0e6*dt/frames);
+	LOGI("per frame visited=%0.1lf, frustum=%0.1lf, horizon=%0.1lf, selected=%0.1lf, max_selected=%i",
+	     (double) visited/frames, (double) frustum/frames,
+	     (double) horizon/frames, (double) selected/frames, max_count);
+
+	nedgz_cull_delete(&cull);
+	nedgz_scenearray_delete(&scene);
+
+	// success
+	return 1;
+
+	// failure
+	fail_update:
+		nedgz_cull_delete(&cull);
+	fail_cull:
+		nedgz_scenearray_delete(&scene);
+	return 0;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int main(int argc, char** argv)
+{
+	// to benchmark the subtile codecs on real tiles
+	//     cd ned
+	//     <path>/nedbench codec ned.list
+	// to benchmark tile import/export
+	//     <path>/nedbench io ned.list
+	// to benchmark the coordinate transforms
+	//     <path>/nedbench coord ned.list
+	// where ned.list contains "zoom x y" lines
+	// to run the suite on synthetic tiles
+	//     <path>/nedbench suite [out.json] [repeat]
+	// to compare the results of two suites
+	//     <path>/nedbench compare a.json b.json
+	// to benchmark the cull of a v1 or v2 scene graph
+	//     <path>/nedgen sg 15 50 -125 25 -67 us.sg
+	//     <path>/nedbench cull us.sg [frames]
+	if((argc >= 2) && (strcmp(argv[1], "suite") == 0))
+	{
+		int repeat = 10;
+		if(argc >= 4)
+		{
+			repeat = (int) strtol(argv[3], NULL, 0);
+		}
+
+		if(nedbench_suite((argc >= 3) ? argv[2] : NULL,
+		                  repeat) == 0)
+		{
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+	else if(argc < 3)
+	{
+		LOGE("usage: %s codec|io|coord in.list [repeat]", argv[0]);
+		LOGE("usage: %s suite [out.json] [repeat]", argv[0]);
+		LOGE("usage: %s compare a.json b.json", argv[0]);
+		LOGE("usage: %s cull in.sg [frames]", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	int repeat = 10;
+	if(argc >= 4)
+	{
+		repeat = (int) strtol(argv[3], NULL, 0);
+	}
+
+	if(strcmp(argv[1], "codec") == 0)
+	{
+		if(bench_codec(argv[2], repeat) == 0)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	else if(strcmp(argv[1], "io") == 0)
+	{
+		if(bench_io(argv[2], repeat) == 0)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	else if(strcmp(argv[1], "coord") == 0)
+	{
+		if(bench_coord(argv[2], repeat) == 0)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	else if(strcmp(argv[1], "cull") == 0)
+	{
+		if(bench_cull(argv[2], (argc >= 4) ? repeat : 100) == 0)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	else if((strcmp(argv[1], "compare") == 0) && (argc >= 4))
+	{
+		if(nedbench_suite_compare(argv[2], argv[3]) == 0)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	else
+	{
+		LOGE("invalid mode=%s", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,1350 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "nedgz/nedgz_codec.h"
+#include "nedgz/nedgz_geom.h"
+#include "nedgz/nedgz_path.h"
+#include "nedgz/nedgz_scene.h"
+#include "nedgz/nedgz_scenearray.h"
+#include "nedgz/nedgz_tile.h"
+#include "nedgz/nedgz_util.h"
+#include "flt_tile.h"
+#include "nedbench_suite.h"
+
+#define LOG_TAG "nedbench"
+#include "nedgz/nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+// synthetic tiles near Denver at zoom 13
+#define BENCH_TILES 16
+#define BENCH_X     1700
+#define BENCH_Y     3100
+#define BENCH_ZOOM  13
+
+// the synthetic scene is a complete quadtree
+#define BENCH_SCENE_DEPTH 7
+
+// the synthetic flt tile matches a 3 arc second NED tile
+#define BENCH_FLT_SIZE 1201
+
+#define BENCH_RESULTS 64
+
+typedef struct
+{
+	char   name[64];
+	double ops;
+	double ns;
+	double mbs;
+	double allocs;
+} bench_result_t;
+
+static bench_result_t bench_result[BENCH_RESULTS];
+static int            bench_results = 0;
+
+// prevents the compiler from eliminating benchmark loops
+static volatile long long bench_sink = 0;
+
+/***********************************************************
+* allocation counters                                      *
+***********************************************************/
+
+// nedbench is linked with --wrap=malloc/calloc/realloc so
+// that calls made by nedbench and libnedgz are counted
+// (calls made internally by libc and zlib are not)
+static long long bench_allocs = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+	__atomic_add_fetch(&bench_allocs, 1, __ATOMIC_RELAXED);
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t nmemb, size_t size)
+{
+	__atomic_add_fetch(&bench_allocs, 1, __ATOMIC_RELAXED);
+	return __real_calloc(nmemb, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+	__atomic_add_fetch(&bench_allocs, 1, __ATOMIC_RELAXED);
+	return __real_realloc(ptr, size);
+}
+
+static long long bench_allocs_get(void)
+{
+	return __atomic_load_n(&bench_allocs, __ATOMIC_RELAXED);
+}
+
+/***********************************************************
+* results                                                  *
+***********************************************************/
+
+typedef struct
+{
+	double    t0;
+	long long a0;
+} bench_timer_t;
+
+static void bench_begin(bench_timer_t* timer)
+{
+	assert(timer);
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	timer->a0 = bench_allocs_get();
+	timer->t0 = (double) ts.tv_sec + ((double) ts.tv_nsec)/1.0e9;
+}
+
+// bytes is the number of bytes processed per op or 0.0
+static void bench_end(bench_timer_t* timer, const char* name,
+                      double ops, double bytes)
+{
+	assert(timer);
+	assert(name);
+	assert(ops > 0.0);
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	double    dt = (double) ts.tv_sec + ((double) ts.tv_nsec)/1.0e9 -
+	               timer->t0;
+	long long da = bench_allocs_get() - timer->a0;
+	if(dt <= 0.0)
+	{
+		dt = 1.0e-9;
+	}
+
+	if(bench_results >= BENCH_RESULTS)
+	{
+		LOGW("too many results name=%s", name);
+		return;
+	}
+
+	bench_result_t* r = &bench_result[bench_results++];
+	snprintf(r->name, 64, "%s", name);
+	r->ops    = ops;
+	r->ns     = 1.0e9*dt/ops;
+	r->mbs    = bytes*ops/dt/(1024.0*1024.0);
+	r->allocs = (double) da/ops;
+
+	if(bytes > 0.0)
+	{
+		LOGI("%-24s %12.1lf ns/op %10.1lf MB/s %8.2lf allocs/op",
+		     r->name, r->ns, r->mbs, r->allocs);
+	}
+	else
+	{
+		LOGI("%-24s %12.1lf ns/op %10s      %8.2lf allocs/op",
+		     r->name, r->ns, "-", r->allocs);
+	}
+}
+
+static int bench_results_export(const char* fname, int repeat)
+{
+	assert(fname);
+	LOGD("debug fname=%s, repeat=%i", fname, repeat);
+
+	FILE* f = fopen(fname, "w");
+	if(f == NULL)
+	{
+		LOGE("fopen %s failed", fname);
+		return 0;
+	}
+
+	// one result per line so that the results may be
+	// compared without a JSON parser
+	fprintf(f, "{\"suite\":\"nedbench\",\"repeat\":%i,\"results\":[\n",
+	        repeat);
+
+	int k;
+	for(k = 0; k < bench_results; ++k)
+	{
+		bench_result_t* r = &bench_result[k];
+		fprintf(f, "{\"name\":\"%s\",\"ops\":%0.0lf,\"ns_per_op\":%0.3lf,"
+		        "\"mb_per_s\":%0.3lf,\"allocs_per_op\":%0.3lf}%s\n",
+		        r->name, r->ops, r->ns, r->mbs, r->allocs,
+		        (k + 1 < bench_results) ? "," : "");
+	}
+	fprintf(f, "]}\n");
+
+	if(fclose(f) != 0)
+	{
+		LOGE("fclose %s failed", fname);
+		return 0;
+	}
+
+	return 1;
+}
+
+/***********************************************************
+* synthetic data                                           *
+***********************************************************/
+
+static unsigned int bench_noise(unsigned int x, unsigned int y)
+{
+	// integer hash of the sample position
+	unsigned int h = x*374761393u + y*668265263u;
+	h = (h ^ (h >> 13))*1274126177u;
+	return h ^ (h >> 16);
+}
+
+// smooth terrain with a small amount of noise so that the
+// codecs see realistic residuals
+static short bench_height(double u, double v,
+                          unsigned int x, unsigned int y)
+{
+	double h = 6000.0 + 2500.0*sin(3.0*u)*cos(2.0*v) +
+	           800.0*sin(17.0*u + 5.0*v) +
+	           (double) (bench_noise(x, y) & 0xF) - 8.0;
+	return (short) h;
+}
+
+static nedgz_tile_t** bench_tiles_new(void)
+{
+	LOGD("debug");
+
+	nedgz_tile_t** tiles = (nedgz_tile_t**)
+	                       calloc(BENCH_TILES, sizeof(nedgz_tile_t*));
+	if(tiles == NULL)
+	{
+		LOGE("calloc failed");
+		return NULL;
+	}
+
+	short* data = (short*) malloc(NEDGZ_TILE_SIZE*NEDGZ_TILE_SIZE*
+	                              sizeof(short));
+	if(data == NULL)
+	{
+		LOGE("malloc failed");
+		goto fail_data;
+	}
+
+	int k;
+	int r;
+	int c;
+	for(k = 0; k < BENCH_TILES; ++k)
+	{
+		int x = BENCH_X + (k%4);
+		int y = BENCH_Y + (k/4);
+		for(r = 0; r < NEDGZ_TILE_SIZE; ++r)
+		{
+			unsigned int gy = (unsigned int) (y*NEDGZ_TILE_SIZE + r);
+			double       v  = (double) gy/NEDGZ_TILE_SIZE/4.0;
+			for(c = 0; c < NEDGZ_TILE_SIZE; ++c)
+			{
+				unsigned int gx = (unsigned int) (x*NEDGZ_TILE_SIZE + c);
+				double       u  = (double) gx/NEDGZ_TILE_SIZE/4.0;
+				data[r*NEDGZ_TILE_SIZE + c] = bench_height(u, v, gx, gy);
+			}
+		}
+
+		tiles[k] = nedgz_tile_new(x, y, BENCH_ZOOM);
+		if(tiles[k] == NULL)
+		{
+			goto fail_tile;
+		}
+
+		if(nedgz_tile_setdata(tiles[k], data) == 0)
+		{
+			goto fail_tile;
+		}
+	}
+	free(data);
+
+	// success
+	return tiles;
+
+	// failure
+	fail_tile:
+		for(k = 0; k < BENCH_TILES; ++k)
+		{
+			nedgz_tile_delete(&tiles[k]);
+		}
+		free(data);
+	fail_data:
+		free(tiles);
+	return NULL;
+}
+
+static void bench_tiles_delete(nedgz_tile_t*** _tiles)
+{
+	assert(_tiles);
+
+	nedgz_tile_t** tiles = *_tiles;
+	if(tiles)
+	{
+		LOGD("debug");
+
+		int k;
+		for(k = 0; k < BENCH_TILES; ++k)
+		{
+			nedgz_tile_delete(&tiles[k]);
+		}
+		free(tiles);
+		*_tiles = NULL;
+	}
+}
+
+static nedgz_scene_t* bench_scene_new(int depth, unsigned int* seed)
+{
+	assert(seed);
+	LOGD("debug depth=%i", depth);
+
+	nedgz_scene_t* self = nedgz_scene_new();
+	if(self == NULL)
+	{
+		return NULL;
+	}
+
+	*seed = bench_noise(*seed, (unsigned int) depth);
+	self->exists = 1;
+	self->fsize  = (int) (*seed & 0xFFFF);
+	self->min    = (short) (*seed & 0x3FF);
+	self->max    = self->min + (short) ((*seed >> 16) & 0x1FFF);
+
+	if(depth > 0)
+	{
+		if(((self->tl = bench_scene_new(depth - 1, seed)) == NULL) ||
+		   ((self->tr = bench_scene_new(depth - 1, seed)) == NULL) ||
+		   ((self->bl = bench_scene_new(depth - 1, seed)) == NULL) ||
+		   ((self->br = bench_scene_new(depth - 1, seed)) == NULL))
+		{
+			nedgz_scene_delete(&self);
+			return NULL;
+		}
+	}
+
+	return self;
+}
+
+static flt_tile_t* bench_flt_new(void)
+{
+	LOGD("debug");
+
+	flt_tile_t* self = (flt_tile_t*) calloc(1, sizeof(flt_tile_t));
+	if(self == NULL)
+	{
+		LOGE("calloc failed");
+		return NULL;
+	}
+
+	self->height = (short*) malloc(BENCH_FLT_SIZE*BENCH_FLT_SIZE*
+	                               sizeof(short));
+	if(self->height == NULL)
+	{
+		LOGE("malloc failed");
+		free(self);
+		return NULL;
+	}
+
+	self->lat       = 40;
+	self->lon       = -106;
+	self->lonL      = -106.0;
+	self->latB      = 39.0;
+	self->lonR      = -105.0;
+	self->latT      = 40.0;
+	self->nodata    = -9999.0f;
+	self->byteorder = FLT_LSBFIRST;
+	self->nrows     = BENCH_FLT_SIZE;
+	self->ncols     = BENCH_FLT_SIZE;
+
+	int r;
+	int c;
+	for(r = 0; r < BENCH_FLT_SIZE; ++r)
+	{
+		for(c = 0; c < BENCH_FLT_SIZE; ++c)
+		{
+			double u = (double) c/BENCH_FLT_SIZE;
+			double v = (double) r/BENCH_FLT_SIZE;
+			self->height[r*BENCH_FLT_SIZE + c] =
+				bench_height(u, v, (unsigned int) c, (unsigned int) r);
+		}
+	}
+
+	return self;
+}
+
+/***********************************************************
+* benchmarks                                               *
+***********************************************************/
+
+#define BENCH_FORMATS 3
+
+static const char* BENCH_FORMAT_NAME[BENCH_FORMATS] =
+{
+	"v1",
+	"v3_zlib",
+	"v3_predict",
+};
+
+static const int BENCH_FORMAT_FLAGS[BENCH_FORMATS] =
+{
+	NEDGZ_FLAG_V1,
+	0,
+	NEDGZ_FLAG_PREDICT,
+};
+
+#define BENCH_CODECS 2
+
+static const char* BENCH_CODEC_NAME[BENCH_CODECS] =
+{
+	"zlib",
+	"predict",
+};
+
+static void bench_io_remove(nedgz_tile_t** tiles, const char* base)
+{
+	assert(tiles);
+	assert(base);
+	LOGD("debug base=%s", base);
+
+	char fname[256];
+	int  k;
+	for(k = 0; k < BENCH_TILES; ++k)
+	{
+		snprintf(fname, 256, "%s/%i/%i_%i.nedgz", base,
+		         tiles[k]->zoom, tiles[k]->x, tiles[k]->y);
+		remove(fname);
+	}
+
+	snprintf(fname, 256, "%s/%i", base, BENCH_ZOOM);
+	rmdir(fname);
+	// the removed directories must be created again
+	nedgz_path_reset();
+}
+
+static int bench_io(nedgz_tile_t** tiles, const char* base,
+                    int repeat)
+{
+	assert(tiles);
+	assert(base);
+	LOGD("debug base=%s, repeat=%i", base, repeat);
+
+	double        raw = (double) sizeof(nedgz_subtile_t)*
+	                    NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT;
+	double        ops = (double) repeat*BENCH_TILES;
+	char          name[64];
+	bench_timer_t timer;
+
+	int fmt;
+	int k;
+	int r;
+	for(fmt = 0; fmt < BENCH_FORMATS; ++fmt)
+	{
+		bench_begin(&timer);
+		for(r = 0; r < repeat; ++r)
+		{
+			for(k = 0; k < BENCH_TILES; ++k)
+			{
+				if(nedgz_tile_exportflags(tiles[k], base,
+				                          BENCH_FORMAT_FLAGS[fmt]) == 0)
+				{
+					goto fail_io;
+				}
+			}
+		}
+		snprintf(name, 64, "tile_export_%s", BENCH_FORMAT_NAME[fmt]);
+		bench_end(&timer, name, ops, raw);
+
+		bench_begin(&timer);
+		for(r = 0; r < repeat; ++r)
+		{
+			for(k = 0; k < BENCH_TILES; ++k)
+			{
+				nedgz_tile_t* ned;
+				ned = nedgz_tile_import(base, tiles[k]->x,
+				                        tiles[k]->y, tiles[k]->zoom);
+				if(ned == NULL)
+				{
+					goto fail_io;
+				}
+				bench_sink += (long long) ned->mask;
+				nedgz_tile_delete(&ned);
+			}
+		}
+		snprintf(name, 64, "tile_import_%s", BENCH_FORMAT_NAME[fmt]);
+		bench_end(&timer, name, ops, raw);
+
+		// random access is only supported by v2/v3 files
+		if(BENCH_FORMAT_FLAGS[fmt] & NEDGZ_FLAG_V1)
+		{
+			bench_io_remove(tiles, base);
+			continue;
+		}
+
+		bench_begin(&timer);
+		for(r = 0; r < repeat; ++r)
+		{
+			for(k = 0; k < BENCH_TILES; ++k)
+			{
+				nedgz_tile_t* ned;
+				ned = nedgz_tile_importij(base, tiles[k]->x,
+				                          tiles[k]->y, tiles[k]->zoom,
+				                          k%NEDGZ_SUBTILE_COUNT,
+				                          r%NEDGZ_SUBTILE_COUNT);
+				if(ned == NULL)
+				{
+					goto fail_io;
+				}
+				bench_sink += (long long) ned->mask;
+				nedgz_tile_delete(&ned);
+			}
+		}
+		snprintf(name, 64, "tile_importij_%s", BENCH_FORMAT_NAME[fmt]);
+		bench_end(&timer, name, ops, (double) sizeof(nedgz_subtile_t));
+
+		bench_io_remove(tiles, base);
+	}
+
+	// success
+	return 1;
+
+	// failure
+	fail_io:
+		bench_io_remove(tiles, base);
+	return 0;
+}
+
+static int bench_accessors(nedgz_tile_t** tiles, int repeat)
+{
+	assert(tiles);
+	LOGD("debug repeat=%i", repeat);
+
+	short* data = (short*) malloc(NEDGZ_TILE_SIZE*NEDGZ_TILE_SIZE*
+	                              sizeof(short));
+	if(data == NULL)
+	{
+		LOGE("malloc failed");
+		return 0;
+	}
+
+	double samples = (double) NEDGZ_TILE_SIZE*NEDGZ_TILE_SIZE;
+	double ops     = (double) repeat*BENCH_TILES;
+	double raw     = samples*sizeof(short);
+
+	bench_timer_t timer;
+	int           i;
+	int           j;
+	int           m;
+	int           n;
+	int           k;
+	int           r;
+	short         h;
+
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(k = 0; k < BENCH_TILES; ++k)
+		{
+			for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+			{
+				for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+				{
+					for(m = 0; m < NEDGZ_SUBTILE_SIZE; ++m)
+					{
+						for(n = 0; n < NEDGZ_SUBTILE_SIZE; ++n)
+						{
+							nedgz_tile_height(tiles[k], i, j, m, n, &h);
+							bench_sink += h;
+						}
+					}
+				}
+			}
+		}
+	}
+	bench_end(&timer, "tile_height", ops*samples, sizeof(short));
+
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(k = 0; k < BENCH_TILES; ++k)
+		{
+			for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+			{
+				for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+				{
+					for(m = 0; m < NEDGZ_SUBTILE_SIZE; ++m)
+					{
+						for(n = 0; n < NEDGZ_SUBTILE_SIZE; ++n)
+						{
+							h = (short) (m + n);
+							if(nedgz_tile_set(tiles[k], i, j,
+							                  m, n, h) == 0)
+							{
+								goto fail_set;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	bench_end(&timer, "tile_set", ops*samples, sizeof(short));
+
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(k = 0; k < BENCH_TILES; ++k)
+		{
+			nedgz_tile_getdata(tiles[k], data);
+			bench_sink += data[r];
+		}
+	}
+	bench_end(&timer, "tile_getdata", ops, raw);
+
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(k = 0; k < BENCH_TILES; ++k)
+		{
+			if(nedgz_tile_setdata(tiles[k], data) == 0)
+			{
+				goto fail_set;
+			}
+		}
+	}
+	bench_end(&timer, "tile_setdata", ops, raw);
+
+	// unaligned 64x64 regions which span several subtiles
+	int rows = 64;
+	int cols = 64;
+	int regions = 0;
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(k = 0; k < BENCH_TILES; ++k)
+		{
+			for(i = 0; i + rows <= NEDGZ_TILE_SIZE; i += 48)
+			{
+				for(j = 0; j + cols <= NEDGZ_TILE_SIZE; j += 48)
+				{
+					nedgz_tile_getregion(tiles[k], i + 7, j + 5,
+					                     rows - 7, cols - 5,
+					                     cols, data);
+					bench_sink += data[0];
+					++regions;
+				}
+			}
+		}
+	}
+	bench_end(&timer, "tile_getregion", (double) regions,
+	          (double) (rows - 7)*(cols - 5)*sizeof(short));
+
+	free(data);
+
+	// success
+	return 1;
+
+	// failure
+	fail_set:
+		free(data);
+	return 0;
+}
+
+static void bench_coord(int repeat)
+{
+	LOGD("debug repeat=%i", repeat);
+
+	double lat[NEDGZ_SUBTILE_SIZE];
+	double lon[NEDGZ_SUBTILE_SIZE];
+	float  u[NEDGZ_SUBTILE_SIZE];
+	float  v[NEDGZ_SUBTILE_SIZE];
+	double subtiles = (double) repeat*BENCH_TILES*
+	                  NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT;
+
+	bench_timer_t timer;
+	int           i;
+	int           j;
+	int           m;
+	int           n;
+	int           k;
+	int           r;
+
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(k = 0; k < BENCH_TILES; ++k)
+		{
+			for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+			{
+				for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+				{
+					for(m = 0; m < NEDGZ_SUBTILE_SIZE; ++m)
+					{
+						for(n = 0; n < NEDGZ_SUBTILE_SIZE; ++n)
+						{
+							nedgz_subtile2coord(BENCH_X + k%4,
+							                    BENCH_Y + k/4,
+							                    BENCH_ZOOM, i, j, m, n,
+							                    &lat[m], &lon[n]);
+						}
+					}
+					bench_sink += (long long) lat[0];
+				}
+			}
+		}
+	}
+	bench_end(&timer, "subtile2coord",
+	          subtiles*NEDGZ_SUBTILE_SIZE*NEDGZ_SUBTILE_SIZE, 0.0);
+
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(k = 0; k < BENCH_TILES; ++k)
+		{
+			for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+			{
+				for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+				{
+					nedgz_subtile2coordv(BENCH_X + k%4, BENCH_Y + k/4,
+					                     BENCH_ZOOM, i, j,
+					                     NEDGZ_SUBTILE_SIZE, lat, lon);
+					bench_sink += (long long) lat[0];
+				}
+			}
+		}
+	}
+	bench_end(&timer, "subtile2coordv",
+	          subtiles*NEDGZ_SUBTILE_SIZE*NEDGZ_SUBTILE_SIZE, 0.0);
+
+	// the reverse transform of the subtile diagonal
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(k = 0; k < BENCH_TILES; ++k)
+		{
+			for(i = 0; i < NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT; ++i)
+			{
+				for(m = 0; m < NEDGZ_SUBTILE_SIZE; ++m)
+				{
+					nedgz_coord2tile(lat[m], lon[m], BENCH_ZOOM,
+					                 &u[m], &v[m]);
+				}
+				bench_sink += (long long) u[0];
+			}
+		}
+	}
+	bench_end(&timer, "coord2tile", subtiles*NEDGZ_SUBTILE_SIZE, 0.0);
+
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(k = 0; k < BENCH_TILES; ++k)
+		{
+			for(i = 0; i < NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT; ++i)
+			{
+				nedgz_lon2tilev(NEDGZ_SUBTILE_SIZE, lon, BENCH_ZOOM, u);
+				nedgz_lat2tilev(NEDGZ_SUBTILE_SIZE, lat, BENCH_ZOOM, v);
+				bench_sink += (long long) u[0];
+			}
+		}
+	}
+	bench_end(&timer, "coord2tilev", subtiles*NEDGZ_SUBTILE_SIZE, 0.0);
+}
+
+static void bench_scene_traverse(nedgz_scene_t* scene, long long* sum)
+{
+	// scene may be NULL
+	assert(sum);
+
+	if(scene == NULL)
+	{
+		return;
+	}
+
+	if(scene->exists)
+	{
+		*sum += scene->fsize;
+	}
+	bench_scene_traverse(scene->tl, sum);
+	bench_scene_traverse(scene->tr, sum);
+	bench_scene_traverse(scene->bl, sum);
+	bench_scene_traverse(scene->br, sum);
+}
+
+static int bench_scenearray_visit(void* priv,
+                                  const nedgz_scenenode_t* node,
+                                  int x, int y, int zoom)
+{
+	assert(priv);
+	assert(node);
+
+	long long* sum = (long long*) priv;
+	if(node->mask & NEDGZ_SCENENODE_EXISTS)
+	{
+		*sum += node->fsize;
+	}
+	return 1;
+}
+
+static int bench_scene(const char* base, int repeat)
+{
+	assert(base);
+	LOGD("debug base=%s, repeat=%i", base, repeat);
+
+	unsigned int   seed  = 1;
+	nedgz_scene_t* scene = bench_scene_new(BENCH_SCENE_DEPTH, &seed);
+	if(scene == NULL)
+	{
+		return 0;
+	}
+
+	// nodes in a complete quadtree
+	int nodes = 0;
+	int level = 1;
+	int d;
+	for(d = 0; d <= BENCH_SCENE_DEPTH; ++d)
+	{
+		nodes += level;
+		level *= 4;
+	}
+
+	char fname[512];
+	snprintf(fname, 512, "%s/bench.sg", base);
+
+	bench_timer_t timer;
+	int           r;
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		if(nedgz_scene_export(scene, fname) == 0)
+		{
+			goto fail_export;
+		}
+	}
+	bench_end(&timer, "scene_export", (double) repeat*nodes, 0.0);
+
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		nedgz_scene_t* tmp = nedgz_scene_import(fname);
+		if(tmp == NULL)
+		{
+			goto fail_import;
+		}
+		bench_sink += tmp->fsize;
+		nedgz_scene_delete(&tmp);
+	}
+	bench_end(&timer, "scene_import", (double) repeat*nodes, 0.0);
+	remove(fname);
+
+	// the synthetic scene is complete to BENCH_SCENE_DEPTH
+	// but tiles are only defined inside of the world
+	int tiles  = (1 << BENCH_SCENE_DEPTH)/NEDGZ_SUBTILE_COUNT;
+	int x;
+	int y;
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(y = 0; y < tiles; ++y)
+		{
+			for(x = 0; x < tiles; ++x)
+			{
+				bench_sink += nedgz_scene_exists(scene, x, y,
+				                                 BENCH_SCENE_DEPTH);
+			}
+		}
+	}
+	bench_end(&timer, "scene_exists", (double) repeat*tiles*tiles,
+	          0.0);
+
+	// compare the pointer and array representations
+	nedgz_scenearray_t* array = NULL;
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		nedgz_scenearray_delete(&array);
+		array = nedgz_scenearray_new(scene);
+		if(array == NULL)
+		{
+			goto fail_array;
+		}
+	}
+	bench_end(&timer, "scenearray_new", (double) repeat*nodes, 0.0);
+
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		nedgz_scene_t* tmp = nedgz_scenearray_tree(array);
+		if(tmp == NULL)
+		{
+			goto fail_tree;
+		}
+		bench_sink += tmp->fsize;
+		nedgz_scene_delete(&tmp);
+	}
+	bench_end(&timer, "scenearray_tree", (double) repeat*nodes, 0.0);
+
+	long long sum_tree  = 0;
+	long long sum_array = 0;
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		bench_scene_traverse(scene, &sum_tree);
+	}
+	bench_end(&timer, "scene_traverse", (double) repeat*nodes, 0.0);
+
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		nedgz_scenearray_traverse(array, bench_scenearray_visit,
+		                          (void*) &sum_array);
+	}
+	bench_end(&timer, "scenearray_traverse", (double) repeat*nodes,
+	          0.0);
+
+	// v2 files are mapped rather than parsed
+	if(nedgz_scenearray_export(array, fname) == 0)
+	{
+		goto fail_export2;
+	}
+
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		nedgz_scenearray_t* tmp = nedgz_scenearray_import(fname);
+		if(tmp == NULL)
+		{
+			goto fail_import2;
+		}
+		bench_sink += tmp->count;
+		nedgz_scenearray_delete(&tmp);
+	}
+	bench_end(&timer, "scenearray_import", (double) repeat, 0.0);
+	remove(fname);
+
+	if(sum_tree != sum_array)
+	{
+		LOGE("invalid sum_tree=%lli, sum_array=%lli",
+		     sum_tree, sum_array);
+		goto fail_sum;
+	}
+	bench_sink += sum_array;
+
+	nedgz_scenearray_delete(&array);
+	nedgz_scene_delete(&scene);
+
+	// success
+	return 1;
+
+	// failure
+	fail_import2:
+		remove(fname);
+	fail_export2:
+	fail_sum:
+	fail_tree:
+	fail_array:
+		nedgz_scenearray_delete(&array);
+		nedgz_scene_delete(&scene);
+	return 0;
+
+	fail_import:
+		remove(fname);
+	fail_export:
+		nedgz_scene_delete(&scene);
+	return 0;
+}
+
+static int bench_flt(int repeat)
+{
+	LOGD("debug repeat=%i", repeat);
+
+	flt_tile_t* flt = bench_flt_new();
+	if(flt == NULL)
+	{
+		return 0;
+	}
+
+	// sample a grid which does not align with the flt samples
+	int    samples = 512;
+	double ops     = (double) repeat*samples*samples;
+
+	bench_timer_t timer;
+	int           r;
+	int           m;
+	int           n;
+	short         h;
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(m = 0; m < samples; ++m)
+		{
+			double lat = flt->latB + (m + 0.5)/samples;
+			for(n = 0; n < samples; ++n)
+			{
+				double lon = flt->lonL + (n + 0.5)/samples;
+				if(flt_tile_sample(flt, lat, lon, &h))
+				{
+					bench_sink += h;
+				}
+			}
+		}
+	}
+	bench_end(&timer, "flt_sample", ops, 0.0);
+
+	flt_tile_delete(&flt);
+
+	return 1;
+}
+
+static void bench_subsample(nedgz_tile_t** tiles, int repeat)
+{
+	assert(tiles);
+	LOGD("debug repeat=%i", repeat);
+
+	bench_timer_t timer;
+	int           i;
+	int           j;
+	int           k;
+	int           r;
+
+	// subsample each subtile of the tiles into a parent
+	nedgz_subtile_t dst;
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(k = 0; k < BENCH_TILES; ++k)
+		{
+			for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+			{
+				for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+				{
+					nedgz_subtile_t* src = nedgz_tile_getij(tiles[k], i, j);
+					nedgz_geom32_subsample(dst.data, NEDGZ_SUBTILE_SIZE,
+					                       src->data, i%2, j%2);
+				}
+			}
+			bench_sink += dst.data[0];
+		}
+	}
+	bench_end(&timer, "geom32_subsample",
+	          (double) repeat*BENCH_TILES*NEDGZ_SUBTILE_COUNT*
+	          NEDGZ_SUBTILE_COUNT, sizeof(nedgz_subtile_t));
+
+	// heightmap textures are subsampled with the 256 geometry
+	// where the synthetic texture is tiled from the subtiles
+	static short src256[NEDGZ_GEOM256_SIZE*NEDGZ_GEOM256_SIZE];
+	static short dst256[NEDGZ_GEOM256_SIZE*NEDGZ_GEOM256_SIZE];
+	short        h;
+	int          m;
+	int          n;
+	for(m = 0; m < NEDGZ_GEOM256_SIZE; ++m)
+	{
+		for(n = 0; n < NEDGZ_GEOM256_SIZE; ++n)
+		{
+			nedgz_tile_height(tiles[0],
+			                  m/NEDGZ_SUBTILE_SIZE, n/NEDGZ_SUBTILE_SIZE,
+			                  m%NEDGZ_SUBTILE_SIZE, n%NEDGZ_SUBTILE_SIZE,
+			                  &h);
+			src256[m*NEDGZ_GEOM256_SIZE + n] = h;
+		}
+	}
+
+	bench_begin(&timer);
+	for(r = 0; r < repeat; ++r)
+	{
+		for(k = 0; k < 4*BENCH_TILES; ++k)
+		{
+			nedgz_geom256_subsample(dst256, NEDGZ_GEOM256_SIZE,
+			                        src256, (k/2)%2, k%2);
+		}
+		bench_sink += dst256[r];
+	}
+	bench_end(&timer, "geom256_subsample",
+	          (double) repeat*4*BENCH_TILES, sizeof(src256));
+}
+
+static int bench_codec(nedgz_tile_t** tiles, int repeat)
+{
+	assert(tiles);
+	LOGD("debug repeat=%i", repeat);
+
+	int count = BENCH_TILES*NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT;
+	int* size = (int*) malloc(count*sizeof(int));
+	if(size == NULL)
+	{
+		LOGE("malloc failed");
+		return 0;
+	}
+
+	unsigned char* block = (unsigned char*)
+	                       malloc(count*NEDGZ_CODEC_BOUND);
+	if(block == NULL)
+	{
+		LOGE("malloc failed");
+		goto fail_block;
+	}
+
+	double          ops = (double) repeat*count;
+	char            name[64];
+	bench_timer_t   timer;
+	nedgz_subtile_t subtile;
+	int             c;
+	int             k;
+	int             r;
+	for(c = 0; c < BENCH_CODECS; ++c)
+	{
+		bench_begin(&timer);
+		for(r = 0; r < repeat; ++r)
+		{
+			for(k = 0; k < count; ++k)
+			{
+				nedgz_subtile_t* src;
+				src = nedgz_tile_getij(tiles[k/64], (k/8)%8, k%8);
+				size[k] = nedgz_codec_encode(src, c,
+				                             &block[k*NEDGZ_CODEC_BOUND],
+				                             NEDGZ_CODEC_BOUND);
+				if(size[k] == 0)
+				{
+					goto fail_codec;
+				}
+			}
+		}
+		snprintf(name, 64, "codec_encode_%s", BENCH_CODEC_NAME[c]);
+		bench_end(&timer, name, ops, sizeof(nedgz_subtile_t));
+
+		bench_begin(&timer);
+		for(r = 0; r < repeat; ++r)
+		{
+			for(k = 0; k < count; ++k)
+			{
+				if(nedgz_codec_decode(&subtile,
+				                      &block[k*NEDGZ_CODEC_BOUND],
+				                      size[k]) == 0)
+				{
+					goto fail_codec;
+				}
+				bench_sink += subtile.data[0];
+			}
+		}
+		snprintf(name, 64, "codec_decode_%s", BENCH_CODEC_NAME[c]);
+		bench_end(&timer, name, ops, sizeof(nedgz_subtile_t));
+	}
+
+	free(block);
+	free(size);
+
+	// success
+	return 1;
+
+	// failure
+	fail_codec:
+		free(block);
+	fail_block:
+		free(size);
+	return 0;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int nedbench_suite(const char* fname, int repeat)
+{
+	// fname may be NULL
+	LOGD("debug fname=%s, repeat=%i", fname ? fname : "NULL", repeat);
+
+	if(repeat <= 0)
+	{
+		LOGE("invalid repeat=%i", repeat);
+		return 0;
+	}
+
+	char base[256];
+	snprintf(base, 256, "%s/nedbench-XXXXXX",
+	         getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+	if(mkdtemp(base) == NULL)
+	{
+		LOGE("mkdtemp %s failed", base);
+		return 0;
+	}
+
+	nedgz_tile_t** tiles = bench_tiles_new();
+	if(tiles == NULL)
+	{
+		goto fail_tiles;
+	}
+
+	LOGI("tiles=%i, repeat=%i, base=%s", BENCH_TILES, repeat, base);
+
+	bench_results = 0;
+	if((bench_io(tiles, base, repeat) == 0)      ||
+	   (bench_codec(tiles, repeat) == 0)         ||
+	   (bench_scene(base, repeat) == 0)          ||
+	   (bench_flt(repeat) == 0))
+	{
+		goto fail_bench;
+	}
+	bench_coord(repeat);
+	bench_subsample(tiles, repeat);
+
+	// the accessors overwrite the synthetic tiles
+	if(bench_accessors(tiles, repeat) == 0)
+	{
+		goto fail_bench;
+	}
+
+	if(fname && (bench_results_export(fname, repeat) == 0))
+	{
+		goto fail_export;
+	}
+
+	bench_tiles_delete(&tiles);
+	rmdir(base);
+
+	// success
+	return 1;
+
+	// failure
+	fail_export:
+	fail_bench:
+		bench_tiles_delete(&tiles);
+	fail_tiles:
+		rmdir(base);
+	return 0;
+}
+
+static int bench_results_import(const char* fname,
+                                bench_result_t* results,
+                                int* _count)
+{
+	assert(fname);
+	assert(results);
+	assert(_count);
+	LOGD("debug fname=%s", fname);
+
+	FILE* f = fopen(fname, "r");
+	if(f == NULL)
+	{
+		LOGE("fopen %s failed", fname);
+		return 0;
+	}
+
+	char*  line  = NULL;
+	size_t n     = 0;
+	int    count = 0;
+	while((getline(&line, &n, f) > 0) && (count < BENCH_RESULTS))
+	{
+		bench_result_t* r = &results[count];
+		if(sscanf(line, "{\"name\":\"%63[^\"]\",\"ops\":%lf,"
+		          "\"ns_per_op\":%lf,\"mb_per_s\":%lf,"
+		          "\"allocs_per_op\":%lf",
+		          r->name, &r->ops, &r->ns, &r->mbs,
+		          &r->allocs) == 5)
+		{
+			++count;
+		}
+	}
+	free(line);
+	fclose(f);
+
+	if(count == 0)
+	{
+		LOGE("no results in %s", fname);
+		return 0;
+	}
+
+	*_count = count;
+	return 1;
+}
+
+int nedbench_suite_compare(const char* fname_a,
+                           const char* fname_b)
+{
+	assert(fname_a);
+	assert(fname_b);
+	LOGD("debug fname_a=%s, fname_b=%s", fname_a, fname_b);
+
+	bench_result_t* a = (bench_result_t*)
+	                    calloc(2*BENCH_RESULTS, sizeof(bench_result_t));
+	if(a == NULL)
+	{
+		LOGE("calloc failed");
+		return 0;
+	}
+	bench_result_t* b = &a[BENCH_RESULTS];
+
+	int count_a = 0;
+	int count_b = 0;
+	if((bench_results_import(fname_a, a, &count_a) == 0) ||
+	   (bench_results_import(fname_b, b, &count_b) == 0))
+	{
+		goto fail_import;
+	}
+
+	// negative deltas are improvements
+	LOGI("%-24s %12s %12s %8s %10s", "name", "a ns/op", "b ns/op",
+	     "delta", "allocs/op");
+
+	int i;
+	int j;
+	for(j = 0; j < count_b; ++j)
+	{
+		for(i = 0; i < count_a; ++i)
+		{
+			if(strcmp(a[i].name, b[j].name) == 0)
+			{
+				break;
+			}
+		}
+
+		if(i == count_a)
+		{
+			LOGI("%-24s %12s %12.1lf %8s %10.2lf", b[j].name, "-",
+			     b[j].ns, "new", b[j].allocs);
+			continue;
+		}
+
+		double delta = 0.0;
+		if(a[i].ns > 0.0)
+		{
+			delta = 100.0*(b[j].ns - a[i].ns)/a[i].ns;
+		}
+		LOGI("%-24s %12.1lf %12.1lf %+7.1lf%% %4.2lf->%0.2lf",
+		     b[j].name, a[i].ns, b[j].ns, delta,
+		     a[i].allocs, b[j].allocs);
+	}
+
+	free(a);
+
+	// success
+	return 1;
+
+	// failure
+	fail_import:
+		free(a);
+	return 0;
+}
@@ -0,0 +1 @@
+ln -s ../../nedgz
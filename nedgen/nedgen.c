@@ -0,0 +1,789 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include "nedgz/nedgz_path.h"
+#include "nedgz/nedgz_progress.h"
+#include "nedgz/nedgz_scene.h"
+#include "nedgz/nedgz_tile.h"
+#include "nedgz/nedgz_util.h"
+
+#define LOG_TAG "nedgen"
+#include "nedgz/nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+// fractal terrain parameters where the base frequency is
+// measured in cycles per degree and heights in meters
+#define NEDGEN_FREQ     0.5
+#define NEDGEN_OCTAVES  14
+#define NEDGEN_GAIN     0.55f
+#define NEDGEN_BASE     600.0f
+#define NEDGEN_RELIEF   1800.0f
+#define NEDGEN_NODATA   -9999.0f
+
+// NED tiles overlap their neighbors by 6 samples
+#define NEDGEN_OVERLAP 6
+
+// tile coordinates are only defined for zoom >= 3
+#define NEDGEN_ZOOM_MIN 3
+#define NEDGEN_ZOOM_MAX 24
+
+static unsigned int seed = 1;
+
+// region covered by the named flt tiles where the tile
+// n40w106 covers lat 39 to 40 and lon -106 to -105
+static double region_latT;
+static double region_lonL;
+static double region_latB;
+static double region_lonR;
+
+static float nedgen_hash(int x, int y, int octave)
+{
+	unsigned int h = seed*0x9E3779B9u;
+	h ^= ((unsigned int) x)*374761393u;
+	h ^= ((unsigned int) y)*668265263u;
+	h ^= ((unsigned int) octave)*0x85EBCA6Bu;
+	h  = (h ^ (h >> 13))*1274126177u;
+	h ^= h >> 16;
+	return ((float) (h & 0xFFFF))/32767.5f - 1.0f;
+}
+
+static float nedgen_noise(double u, double v, int octave)
+{
+	double fu = floor(u);
+	double fv = floor(v);
+	int    x  = (int) fu;
+	int    y  = (int) fv;
+
+	// smoothstep interpolation of the lattice values
+	float a = (float) (u - fu);
+	float b = (float) (v - fv);
+	a = a*a*(3.0f - 2.0f*a);
+	b = b*b*(3.0f - 2.0f*b);
+
+	float h00 = nedgen_hash(x,     y,     octave);
+	float h10 = nedgen_hash(x + 1, y,     octave);
+	float h01 = nedgen_hash(x,     y + 1, octave);
+	float h11 = nedgen_hash(x + 1, y + 1, octave);
+	float h0  = h00 + a*(h10 - h00);
+	float h1  = h01 + a*(h11 - h01);
+	return h0 + b*(h1 - h0);
+}
+
+// height in meters where heights <= 0 represent the ocean
+static float nedgen_height(double lat, double lon)
+{
+	double u   = (lon + 180.0)*NEDGEN_FREQ;
+	double v   = (lat + 90.0)*NEDGEN_FREQ;
+	float  amp = 1.0f;
+	float  h   = 0.0f;
+
+	int o;
+	for(o = 0; o < NEDGEN_OCTAVES; ++o)
+	{
+		h   += amp*nedgen_noise(u, v, o);
+		u   *= 2.0;
+		v   *= 2.0;
+		amp *= NEDGEN_GAIN;
+	}
+
+	return NEDGEN_BASE + NEDGEN_RELIEF*h;
+}
+
+static short nedgen_feet(float h)
+{
+	if(h <= 0.0f)
+	{
+		return NEDGZ_NODATA;
+	}
+
+	float f = nedgz_meters2feet(h) + 0.5f;
+	if(f >= 32767.0f)
+	{
+		return 32767;
+	}
+	else if(f < 1.0f)
+	{
+		// avoid confusion with NEDGZ_NODATA
+		return 1;
+	}
+	return (short) f;
+}
+
+static int nedgen_inregion(double lat, double lon)
+{
+	return (lat <= region_latT) && (lat >= region_latB) &&
+	       (lon >= region_lonL) && (lon <= region_lonR);
+}
+
+/***********************************************************
+* flt                                                      *
+***********************************************************/
+
+static int nedgen_flt(int arcs, int lat, int lon)
+{
+	LOGD("debug arcs=%i, lat=%i, lon=%i", arcs, lat, lon);
+
+	// samples per degree where arcs=13 is 1/3 arc second
+	int spd = (arcs == 13) ? 10800 : 3600/arcs;
+	int ncols = spd + 2*NEDGEN_OVERLAP;
+	int nrows = ncols;
+
+	double cellsize  = 1.0/((double) spd);
+	double xllcorner = (double) lon - NEDGEN_OVERLAP*cellsize;
+	double yllcorner = (double) (lat - 1) - NEDGEN_OVERLAP*cellsize;
+
+	char fbase[64];
+	char fname[256];
+	snprintf(fbase, 64, "%s%i%s%03i",
+	         (lat >= 0) ? "n" : "s", abs(lat),
+	         (lon >= 0) ? "e" : "w", abs(lon));
+
+	snprintf(fname, 256, "%s/float%s_%i.hdr", fbase, fbase, arcs);
+	FILE* f = nedgz_path_fopen(fname, "w");
+	if(f == NULL)
+	{
+		LOGE("fopen %s failed", fname);
+		return 0;
+	}
+	fprintf(f, "ncols %i\n", ncols);
+	fprintf(f, "nrows %i\n", nrows);
+	fprintf(f, "xllcorner %0.12lf\n", xllcorner);
+	fprintf(f, "yllcorner %0.12lf\n", yllcorner);
+	fprintf(f, "cellsize %0.15lf\n", cellsize);
+	fprintf(f, "NODATA_value %i\n", (int) NEDGEN_NODATA);
+	fprintf(f, "byteorder LSBFIRST\n");
+	fclose(f);
+
+	snprintf(fname, 256, "%s/float%s_%i.prj", fbase, fbase, arcs);
+	f = fopen(fname, "w");
+	if(f == NULL)
+	{
+		LOGE("fopen %s failed", fname);
+		return 0;
+	}
+	fprintf(f, "Projection GEOGRAPHIC\n");
+	fprintf(f, "Datum NAD83\n");
+	fprintf(f, "Zunits METERS\n");
+	fprintf(f, "Units DD\n");
+	fprintf(f, "Spheroid GRS1980\n");
+	fprintf(f, "Xshift 0.0\n");
+	fprintf(f, "Yshift 0.0\n");
+	fclose(f);
+
+	float* row = (float*) malloc(ncols*sizeof(float));
+	if(row == NULL)
+	{
+		LOGE("malloc failed");
+		return 0;
+	}
+
+	snprintf(fname, 256, "%s/float%s_%i.flt", fbase, fbase, arcs);
+	f = fopen(fname, "w");
+	if(f == NULL)
+	{
+		LOGE("fopen %s failed", fname);
+		goto fail_fopen;
+	}
+
+	// rows are stored top to bottom as little endian floats
+	int r;
+	int c;
+	for(r = 0; r < nrows; ++r)
+	{
+		double latr = yllcorner + (double) (nrows - 1 - r)*cellsize;
+		for(c = 0; c < ncols; ++c)
+		{
+			double lonc = xllcorner + (double) c*cellsize;
+			float  h    = nedgen_height(latr, lonc);
+			row[c] = (h <= 0.0f) ? NEDGEN_NODATA : h;
+		}
+
+		if(fwrite(row, sizeof(float), ncols, f) != ncols)
+		{
+			LOGE("fwrite %s failed", fname);
+			goto fail_fwrite;
+		}
+	}
+
+	if(fclose(f) != 0)
+	{
+		LOGE("fclose %s failed", fname);
+		goto fail_fclose;
+	}
+	free(row);
+
+	// success
+	return 1;
+
+	// failure
+	fail_fwrite:
+		fclose(f);
+	fail_fclose:
+		remove(fname);
+	fail_fopen:
+		free(row);
+	return 0;
+}
+
+/***********************************************************
+* ned                                                      *
+***********************************************************/
+
+static int nedgen_tile(nedgz_tile_t* ned)
+{
+	assert(ned);
+	LOGD("debug x=%i, y=%i, zoom=%i", ned->x, ned->y, ned->zoom);
+
+	double lat[NEDGZ_SUBTILE_SIZE];
+	double lon[NEDGZ_SUBTILE_SIZE];
+
+	int i;
+	int j;
+	int m;
+	int n;
+	for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+	{
+		for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+		{
+			nedgz_subtile2coordv(ned->x, ned->y, ned->zoom, i, j,
+			                     NEDGZ_SUBTILE_SIZE, lat, lon);
+			for(m = 0; m < NEDGZ_SUBTILE_SIZE; ++m)
+			{
+				for(n = 0; n < NEDGZ_SUBTILE_SIZE; ++n)
+				{
+					if(nedgen_inregion(lat[m], lon[n]) == 0)
+					{
+						continue;
+					}
+
+					short h = nedgen_feet(nedgen_height(lat[m], lon[n]));
+					if(h == NEDGZ_NODATA)
+					{
+						continue;
+					}
+
+					if(nedgz_tile_set(ned, i, j, m, n, h) == 0)
+					{
+						return 0;
+					}
+				}
+			}
+		}
+	}
+
+	return 1;
+}
+
+// computes the range of tiles at zoom which overlap the
+// region and returns the tile count
+static int nedgen_range(int zoom, int* x0, int* y0,
+                        int* x1, int* y1)
+{
+	assert(x0);
+	assert(y0);
+	assert(x1);
+	assert(y1);
+	LOGD("debug zoom=%i", zoom);
+
+	float x0f;
+	float y0f;
+	float x1f;
+	float y1f;
+	nedgz_coord2tile(region_latT, region_lonL, zoom, &x0f, &y0f);
+	nedgz_coord2tile(region_latB, region_lonR, zoom, &x1f, &y1f);
+	*x0 = (int) floor(x0f);
+	*y0 = (int) floor(y0f);
+	*x1 = (int) ceil(x1f) - 1;
+	*y1 = (int) ceil(y1f) - 1;
+	if(*x1 < *x0)
+	{
+		*x1 = *x0;
+	}
+	if(*y1 < *y0)
+	{
+		*y1 = *y0;
+	}
+
+	return (*x1 - *x0 + 1)*(*y1 - *y0 + 1);
+}
+
+static int nedgen_ned(int zoom0, int zoom1)
+{
+	LOGD("debug zoom0=%i, zoom1=%i", zoom0, zoom1);
+
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+	int zoom;
+	int count = 0;
+	for(zoom = zoom0; zoom <= zoom1; ++zoom)
+	{
+		count += nedgen_range(zoom, &x0, &y0, &x1, &y1);
+	}
+
+	nedgz_progress_t* progress = nedgz_progress_new("nedgen", count);
+	if(progress == NULL)
+	{
+		return 0;
+	}
+	int stage_sample = nedgz_progress_stage(progress, "sample");
+	int stage_export = nedgz_progress_stage(progress, "export");
+
+	if(nedgz_path_mkdir("ned/") == 0)
+	{
+		goto fail_mkdir;
+	}
+
+	// the list may be passed to nedsg, nedpak and nedbench
+	FILE* f = fopen("ned/ned.list", "w");
+	if(f == NULL)
+	{
+		LOGE("fopen ned/ned.list failed");
+		goto fail_list;
+	}
+
+	nedgz_tile_t* ned = nedgz_tile_new(0, 0, zoom0);
+	if(ned == NULL)
+	{
+		goto fail_tile;
+	}
+
+	int  x;
+	int  y;
+	char fname[256];
+	for(zoom = zoom0; zoom <= zoom1; ++zoom)
+	{
+		nedgen_range(zoom, &x0, &y0, &x1, &y1);
+		for(y = y0; y <= y1; ++y)
+		{
+			for(x = x0; x <= x1; ++x)
+			{
+				double t0 = nedgz_progress_begin(progress);
+				nedgz_tile_reset(ned, x, y, zoom);
+				if(nedgen_tile(ned) == 0)
+				{
+					goto fail_sample;
+				}
+				nedgz_progress_end(progress, stage_sample, t0);
+
+				// the ocean is not exported
+				if(ned->mask == 0)
+				{
+					nedgz_progress_skip(progress, 1);
+					continue;
+				}
+
+				t0 = nedgz_progress_begin(progress);
+				if(nedgz_tile_export(ned, "ned") == 0)
+				{
+					goto fail_export;
+				}
+				fprintf(f, "%i %i %i\n", zoom, x, y);
+				snprintf(fname, 256, "ned/%i/%i_%i.nedgz", zoom, x, y);
+				nedgz_progress_writefile(progress, fname);
+				nedgz_progress_end(progress, stage_export, t0);
+				nedgz_progress_done(progress, 1);
+			}
+		}
+	}
+
+	nedgz_tile_delete(&ned);
+	fclose(f);
+	nedgz_progress_delete(&progress);
+
+	// success
+	return 1;
+
+	// failure
+	fail_export:
+	fail_sample:
+		nedgz_tile_delete(&ned);
+	fail_tile:
+		fclose(f);
+	fail_list:
+	fail_mkdir:
+		nedgz_progress_delete(&progress);
+	return 0;
+}
+
+/***********************************************************
+* sg                                                       *
+***********************************************************/
+
+// the region in tile coordinates for each zoom level
+static float sg_x0[NEDGEN_ZOOM_MAX + 1];
+static float sg_y0[NEDGEN_ZOOM_MAX + 1];
+static float sg_x1[NEDGEN_ZOOM_MAX + 1];
+static float sg_y1[NEDGEN_ZOOM_MAX + 1];
+
+static nedgz_progress_t* sg_progress = NULL;
+
+// leaf heights are estimated from a grid of samples
+#define NEDGEN_SG_SAMPLES 5
+
+static void nedgen_sgleaf(nedgz_scene_t* node, int x, int y, int zoom)
+{
+	assert(node);
+	LOGD("debug x=%i, y=%i, zoom=%i", x, y, zoom);
+
+	double lat;
+	double lon;
+	float  s = (float) (NEDGEN_SG_SAMPLES - 1);
+	int    m;
+	int    n;
+	for(m = 0; m < NEDGEN_SG_SAMPLES; ++m)
+	{
+		for(n = 0; n < NEDGEN_SG_SAMPLES; ++n)
+		{
+			nedgz_tile2coord((float) x + ((float) n)/s,
+			                 (float) y + ((float) m)/s,
+			                 zoom, &lat, &lon);
+			if(nedgen_inregion(lat, lon) == 0)
+			{
+				continue;
+			}
+
+			short h = nedgen_feet(nedgen_height(lat, lon));
+			if(h == NEDGZ_NODATA)
+			{
+				continue;
+			}
+
+			if((node->min == NEDGZ_NODATA) || (h < node->min))
+			{
+				node->min = h;
+			}
+
+			if((node->max == NEDGZ_NODATA) || (h > node->max))
+			{
+				node->max = h;
+			}
+		}
+	}
+}
+
+static void nedgen_sgchild(nedgz_scene_t* node, nedgz_scene_t* child)
+{
+	// child may be NULL
+	assert(node);
+	LOGD("debug");
+
+	if((child == NULL) ||
+	   (child->min == NEDGZ_NODATA) ||
+	   (child->max == NEDGZ_NODATA))
+	{
+		return;
+	}
+
+	if((node->min == NEDGZ_NODATA) || (child->min < node->min))
+	{
+		node->min = child->min;
+	}
+
+	if((node->max == NEDGZ_NODATA) || (child->max > node->max))
+	{
+		node->max = child->max;
+	}
+}
+
+static int nedgen_sgnode(nedgz_scene_t** _node,
+                         int x, int y, int zoom, int max_zoom)
+{
+	assert(_node);
+	assert(*_node == NULL);
+	LOGD("debug x=%i, y=%i, zoom=%i", x, y, zoom);
+
+	// skip tiles outside the region
+	if(((float) x >= sg_x1[zoom]) || ((float) (x + 1) <= sg_x0[zoom]) ||
+	   ((float) y >= sg_y1[zoom]) || ((float) (y + 1) <= sg_y0[zoom]))
+	{
+		return 1;
+	}
+
+	nedgz_scene_t* node = nedgz_scene_new();
+	if(node == NULL)
+	{
+		return 0;
+	}
+
+	if(zoom == max_zoom)
+	{
+		nedgen_sgleaf(node, x, y, zoom);
+		nedgz_progress_done(sg_progress, 1);
+	}
+	else
+	{
+		if((nedgen_sgnode(&node->tl, 2*x,     2*y,     zoom + 1, max_zoom) == 0) ||
+		   (nedgen_sgnode(&node->tr, 2*x + 1, 2*y,     zoom + 1, max_zoom) == 0) ||
+		   (nedgen_sgnode(&node->bl, 2*x,     2*y + 1, zoom + 1, max_zoom) == 0) ||
+		   (nedgen_sgnode(&node->br, 2*x + 1, 2*y + 1, zoom + 1, max_zoom) == 0))
+		{
+			nedgz_scene_delete(&node);
+			return 0;
+		}
+
+		nedgen_sgchild(node, node->tl);
+		nedgen_sgchild(node, node->tr);
+		nedgen_sgchild(node, node->bl);
+		nedgen_sgchild(node, node->br);
+	}
+
+	// like the ned pyramid, tiles which only contain the
+	// ocean do not exist
+	if(node->min == NEDGZ_NODATA)
+	{
+		nedgz_scene_delete(&node);
+		return 1;
+	}
+
+	// the file size grows with the relief
+	node->exists = (zoom >= NEDGEN_ZOOM_MIN) ? 1 : 0;
+	node->fsize  = node->exists ? 2048 + 8*(node->max - node->min) : 0;
+
+	*_node = node;
+	return 1;
+}
+
+static int nedgen_sg(int zoom, const char* sname)
+{
+	assert(sname);
+	LOGD("debug zoom=%i, sname=%s", zoom, sname);
+
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+	int count = nedgen_range(zoom, &x0, &y0, &x1, &y1);
+
+	int z;
+	for(z = 0; z <= zoom; ++z)
+	{
+		nedgz_coord2tile(region_latT, region_lonL, z,
+		                 &sg_x0[z], &sg_y0[z]);
+		nedgz_coord2tile(region_latB, region_lonR, z,
+		                 &sg_x1[z], &sg_y1[z]);
+	}
+
+	sg_progress = nedgz_progress_new("nedgen", count);
+	if(sg_progress == NULL)
+	{
+		return 0;
+	}
+	int stage_build  = nedgz_progress_stage(sg_progress, "build");
+	int stage_export = nedgz_progress_stage(sg_progress, "export");
+
+	// the root is the same as the nedsg root
+	nedgz_scene_t* scene = NULL;
+	double         t0    = nedgz_progress_begin(sg_progress);
+	if(nedgen_sgnode(&scene, 0, 0, 0, zoom) == 0)
+	{
+		goto fail_build;
+	}
+	nedgz_progress_end(sg_progress, stage_build, t0);
+
+	if(scene == NULL)
+	{
+		LOGE("empty scene");
+		goto fail_empty;
+	}
+
+	t0 = nedgz_progress_begin(sg_progress);
+	if(nedgz_scene_export(scene, sname) == 0)
+	{
+		goto fail_export;
+	}
+	nedgz_progress_writefile(sg_progress, sname);
+	nedgz_progress_end(sg_progress, stage_export, t0);
+
+	nedgz_scene_delete(&scene);
+	nedgz_progress_delete(&sg_progress);
+
+	// success
+	return 1;
+
+	// failure
+	fail_export:
+		nedgz_scene_delete(&scene);
+	fail_empty:
+	fail_build:
+		nedgz_progress_delete(&sg_progress);
+	return 0;
+}
+
+static void usage(const char* argv0)
+{
+	assert(argv0);
+
+	LOGE("usage: %s [-seed seed] flt [arcs] [latT] [lonL] [latB] [lonR]", argv0);
+	LOGE("usage: %s [-seed seed] ned [zoom0] [zoom1] [latT] [lonL] [latB] [lonR]", argv0);
+	LOGE("usage: %s [-seed seed] sg [zoom] [latT] [lonL] [latB] [lonR] out.sg", argv0);
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int main(int argc, char** argv)
+{
+	// nedgen generates deterministic fractal terrain so that
+	// the tools may be benchmarked without the source data
+	// where the region is given by the names of the flt tiles
+	// (e.g. 40 -106 40 -106 covers the flt tile n40w106)
+	//
+	// 1. to create the flt tiles for flt2ned
+	//     <path>/nedgen flt 1 40 -106 40 -106
+	// 2. to create a nedgz pyramid for zoom 9 to 15
+	//    including ned/ned.list for nedsg/nedpak/nedbench
+	//     <path>/nedgen ned 9 15 40 -106 40 -106
+	// 3. to create a scene graph for zoom 15 without tiles
+	//     <path>/nedgen sg 15 50 -125 25 -67 ned.sg
+	const char* argv0 = argv[0];
+	if((argc >= 3) && (strcmp(argv[1], "-seed") == 0))
+	{
+		seed  = (unsigned int) strtoul(argv[2], NULL, 0);
+		argc -= 2;
+		argv += 2;
+	}
+
+	if(argc < 2)
+	{
+		usage(argv0);
+		return EXIT_FAILURE;
+	}
+
+	const char* mode   = argv[1];
+	int         nargs  = 5;
+	if(strcmp(mode, "flt") == 0)
+	{
+		nargs = 5;
+	}
+	else if((strcmp(mode, "ned") == 0) || (strcmp(mode, "sg") == 0))
+	{
+		nargs = 6;
+	}
+	else
+	{
+		usage(argv0);
+		return EXIT_FAILURE;
+	}
+
+	if(argc != nargs + 2)
+	{
+		usage(argv0);
+		return EXIT_FAILURE;
+	}
+
+	// the region follows the first argument(s)
+	int a0   = (strcmp(mode, "ned") == 0) ? 4 : 3;
+	int latT = (int) strtol(argv[a0 + 0], NULL, 0);
+	int lonL = (int) strtol(argv[a0 + 1], NULL, 0);
+	int latB = (int) strtol(argv[a0 + 2], NULL, 0);
+	int lonR = (int) strtol(argv[a0 + 3], NULL, 0);
+	if((latT < latB) || (lonR < lonL))
+	{
+		LOGE("invalid latT=%i, lonL=%i, latB=%i, lonR=%i",
+		     latT, lonL, latB, lonR);
+		return EXIT_FAILURE;
+	}
+	region_latT = (double) latT;
+	region_lonL = (double) lonL;
+	region_latB = (double) (latB - 1);
+	region_lonR = (double) (lonR + 1);
+
+	LOGI("mode=%s, seed=%u, latT=%i, lonL=%i, latB=%i, lonR=%i",
+	     mode, seed, latT, lonL, latB, lonR);
+
+	if(strcmp(mode, "flt") == 0)
+	{
+		int arcs = (int) strtol(argv[2], NULL, 0);
+		if((arcs <= 0) || ((arcs != 13) && (3600%arcs != 0)))
+		{
+			LOGE("invalid arcs=%i", arcs);
+			return EXIT_FAILURE;
+		}
+
+		nedgz_progress_t* progress;
+		progress = nedgz_progress_new("nedgen",
+		                              (latT - latB + 1)*(lonR - lonL + 1));
+		if(progress == NULL)
+		{
+			return EXIT_FAILURE;
+		}
+
+		int lati;
+		int lonj;
+		for(lati = latB; lati <= latT; ++lati)
+		{
+			for(lonj = lonL; lonj <= lonR; ++lonj)
+			{
+				if(nedgen_flt(arcs, lati, lonj) == 0)
+				{
+					nedgz_progress_delete(&progress);
+					return EXIT_FAILURE;
+				}
+				nedgz_progress_done(progress, 1);
+			}
+		}
+		nedgz_progress_delete(&progress);
+	}
+	else if(strcmp(mode, "ned") == 0)
+	{
+		int zoom0 = (int) strtol(argv[2], NULL, 0);
+		int zoom1 = (int) strtol(argv[3], NULL, 0);
+		if((zoom0 < NEDGEN_ZOOM_MIN) || (zoom1 > NEDGEN_ZOOM_MAX) ||
+		   (zoom0 > zoom1))
+		{
+			LOGE("invalid zoom0=%i, zoom1=%i", zoom0, zoom1);
+			return EXIT_FAILURE;
+		}
+
+		if(nedgen_ned(zoom0, zoom1) == 0)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	else
+	{
+		int zoom = (int) strtol(argv[2], NULL, 0);
+		if((zoom < NEDGEN_ZOOM_MIN) || (zoom > NEDGEN_ZOOM_MAX))
+		{
+			LOGE("invalid zoom=%i", zoom);
+			return EXIT_FAILURE;
+		}
+
+		if(nedgen_sg(zoom, argv[7]) == 0)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
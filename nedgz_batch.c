@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "nedgz_batch.h"
+#include "nedgz_profile.h"
+
+#define LOG_TAG "nedgz"
+#include "nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static int nedgz_batch_fsync(const char* fname, int flags)
+{
+	assert(fname);
+	LOGD("debug fname=%s, flags=0x%X", fname, flags);
+
+	int fd = open(fname, flags);
+	if(fd == -1)
+	{
+		if(errno == ENOENT)
+		{
+			// empty tiles are not written
+			return -1;
+		}
+
+		LOGE("open %s failed", fname);
+		return 0;
+	}
+
+	if(fsync(fd) != 0)
+	{
+		LOGE("fsync %s failed", fname);
+		goto fail_fsync;
+	}
+	close(fd);
+
+	// success
+	return 1;
+
+	// failure
+	fail_fsync:
+		close(fd);
+	return 0;
+}
+
+static void nedgz_batch_dname(const char* fname, char* dname)
+{
+	assert(fname);
+	assert(dname);
+	LOGD("debug fname=%s", fname);
+
+	snprintf(dname, 256, "%s", fname);
+	char* s = strrchr(dname, '/');
+	if(s)
+	{
+		*s = '\0';
+	}
+	else
+	{
+		snprintf(dname, 256, ".");
+	}
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+nedgz_batch_t* nedgz_batch_new(void)
+{
+	LOGD("debug");
+
+	nedgz_batch_t* self = (nedgz_batch_t*)
+	                      malloc(sizeof(nedgz_batch_t));
+	if(self == NULL)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->count     = 0;
+	self->max_count = 0;
+	self->fname     = NULL;
+	self->progress  = NULL;
+
+	return self;
+}
+
+void nedgz_batch_delete(nedgz_batch_t** _self)
+{
+	assert(_self);
+
+	nedgz_batch_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug count=%i", self->count);
+
+		// remove tiles which were not committed
+		char pname[256];
+		int  i;
+		for(i = 0; i < self->count; ++i)
+		{
+			snprintf(pname, 256, "%s.part", self->fname[i]);
+			unlink(pname);
+		}
+
+		free(self->fname);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+int nedgz_batch_export(nedgz_batch_t* self,
+                       nedgz_tile_t* tile,
+                       const char* base,
+                       int flags)
+{
+	assert(self);
+	assert(tile);
+	assert(base);
+	LOGD("debug base=%s, flags=0x%X", base, flags);
+
+	// grow the file list
+	if(self->count == self->max_count)
+	{
+		int max_count = 2*self->max_count;
+		if(max_count == 0)
+		{
+			max_count = 64;
+		}
+
+		char (*fname)[256] = (char (*)[256])
+		                     realloc(self->fname,
+		                             256*max_count);
+		if(fname == NULL)
+		{
+			LOGE("realloc failed");
+			return 0;
+		}
+		self->fname     = fname;
+		self->max_count = max_count;
+	}
+
+	// the sync is deferred to nedgz_batch_commit
+	flags &= ~NEDGZ_FLAG_FSYNC;
+	if(nedgz_tile_exportflags(tile, base,
+	                          flags | NEDGZ_FLAG_DEFER) == 0)
+	{
+		return 0;
+	}
+
+	snprintf(self->fname[self->count], 256, "%s/%i/%i_%i.nedgz",
+	         base, tile->zoom, tile->x, tile->y);
+	++self->count;
+
+	return 1;
+}
+
+int nedgz_batch_commit(nedgz_batch_t* self)
+{
+	assert(self);
+	LOGD("debug count=%i", self->count);
+
+	// sync the tiles together so the filesystem may
+	// coalesce the writes
+	NEDGZ_PROFILE_BEGIN(batch_commit);
+	char pname[256];
+	int  i;
+	int  j;
+	for(i = 0; i < self->count; ++i)
+	{
+		snprintf(pname, 256, "%s.part", self->fname[i]);
+		int ret = nedgz_batch_fsync(pname, O_RDONLY);
+		if(ret == 0)
+		{
+			goto fail_commit;
+		}
+		else if(ret == -1)
+		{
+			// mark the empty tile
+			self->fname[i][0] = '\0';
+		}
+	}
+
+	// rename the tiles in place
+	for(i = 0; i < self->count; ++i)
+	{
+		if(self->fname[i][0] == '\0')
+		{
+			continue;
+		}
+
+		snprintf(pname, 256, "%s.part", self->fname[i]);
+		if(rename(pname, self->fname[i]) != 0)
+		{
+			LOGE("rename %s failed", pname);
+			goto fail_commit;
+		}
+
+		if(self->progress)
+		{
+			nedgz_progress_writefile(self->progress,
+			                         self->fname[i]);
+		}
+	}
+
+	// sync each directory once so the renames are durable
+	char dname[256];
+	char dprev[256];
+	for(i = 0; i < self->count; ++i)
+	{
+		if(self->fname[i][0] == '\0')
+		{
+			continue;
+		}
+
+		nedgz_batch_dname(self->fname[i], dname);
+
+		// skip directories that were already synced
+		int synced = 0;
+		for(j = 0; j < i; ++j)
+		{
+			if(self->fname[j][0] == '\0')
+			{
+				continue;
+			}
+
+			nedgz_batch_dname(self->fname[j], dprev);
+			if(strcmp(dname, dprev) == 0)
+			{
+				synced = 1;
+				break;
+			}
+		}
+
+		if(synced == 0)
+		{
+			if(nedgz_batch_fsync(dname, O_RDONLY) != 1)
+			{
+				goto fail_commit;
+			}
+		}
+	}
+
+	NEDGZ_PROFILE_END(batch_commit);
+
+	self->count = 0;
+	return 1;
+
+	// failure
+	fail_commit:
+		NEDGZ_PROFILE_END(batch_commit);
+	return 0;
+}
+
+void nedgz_batch_progress(nedgz_batch_t* self,
+                          nedgz_progress_t* progress)
+{
+	assert(self);
+	LOGD("debug");
+
+	self->progress = progress;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef nedgz_batch_H
+#define nedgz_batch_H
+
+#include "nedgz_tile.h"
+#include "nedgz_progress.h"
+
+// The batch defers the rename of exported tiles so that the
+// cost of syncing to disk is shared across many tiles.
+// Tiles are written to fname.part and nedgz_batch_commit
+// syncs every file, renames them in place and finally syncs
+// each directory once. Tiles that were not committed are
+// removed by nedgz_batch_delete. The bytes written by
+// committed tiles are added to the optional progress. The
+// batch is not thread safe.
+typedef struct
+{
+	int  count;
+	int  max_count;
+	char (*fname)[256];
+
+	nedgz_progress_t* progress;
+} nedgz_batch_t;
+
+nedgz_batch_t* nedgz_batch_new(void);
+void           nedgz_batch_delete(nedgz_batch_t** _self);
+int            nedgz_batch_export(nedgz_batch_t* self,
+                                  nedgz_tile_t* tile,
+                                  const char* base,
+                                  int flags);
+int            nedgz_batch_commit(nedgz_batch_t* self);
+void           nedgz_batch_progress(nedgz_batch_t* self,
+                                    nedgz_progress_t* progress);
+
+#endif
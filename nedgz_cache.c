@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "nedgz_cache.h"
+
+#define LOG_TAG "nedgz"
+#include "nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+// id for tiles added by nedgz_cache_import
+#define NEDGZ_CACHE_TILE -1
+
+static int nedgz_cache_hash(int zoom, int x, int y, int id)
+{
+	LOGD("debug zoom=%i, x=%i, y=%i, id=%i", zoom, x, y, id);
+
+	unsigned int h = ((unsigned int) zoom)*2654435761U;
+	h ^= ((unsigned int) x)*73856093U;
+	h ^= ((unsigned int) y)*19349663U;
+	h ^= ((unsigned int) id)*83492791U;
+	return (int) (h%NEDGZ_CACHE_BUCKETS);
+}
+
+static void nedgz_cache_freedata(nedgz_cache_t* self, void* data)
+{
+	assert(self);
+	assert(data);
+	LOGD("debug");
+
+	if(self->free_fn)
+	{
+		self->free_fn(data);
+	}
+	else
+	{
+		nedgz_tile_t* tile = (nedgz_tile_t*) data;
+		nedgz_tile_delete(&tile);
+	}
+}
+
+static nedgz_cacheitem_t* nedgz_cache_find(nedgz_cache_t* self,
+                                           int zoom, int x, int y,
+                                           int id)
+{
+	assert(self);
+	LOGD("debug zoom=%i, x=%i, y=%i, id=%i", zoom, x, y, id);
+
+	nedgz_cacheitem_t* item;
+	item = self->bucket[nedgz_cache_hash(zoom, x, y, id)];
+	while(item)
+	{
+		if((item->zoom == zoom) && (item->x == x) &&
+		   (item->y == y) && (item->id == id))
+		{
+			return item;
+		}
+		item = item->chain;
+	}
+	return NULL;
+}
+
+static void nedgz_cache_unlink(nedgz_cache_t* self,
+                               nedgz_cacheitem_t* item)
+{
+	assert(self);
+	assert(item);
+	LOGD("debug");
+
+	if(item->prev)
+	{
+		item->prev->next = item->next;
+	}
+	else
+	{
+		self->head = item->next;
+	}
+
+	if(item->next)
+	{
+		item->next->prev = item->prev;
+	}
+	else
+	{
+		self->tail = item->prev;
+	}
+
+	item->prev = NULL;
+	item->next = NULL;
+}
+
+static void nedgz_cache_pushfront(nedgz_cache_t* self,
+                                  nedgz_cacheitem_t* item)
+{
+	assert(self);
+	assert(item);
+	LOGD("debug");
+
+	item->prev = NULL;
+	item->next = self->head;
+	if(self->head)
+	{
+		self->head->prev = item;
+	}
+	else
+	{
+		self->tail = item;
+	}
+	self->head = item;
+}
+
+static void nedgz_cache_remove(nedgz_cache_t* self,
+                               nedgz_cacheitem_t* item)
+{
+	assert(self);
+	assert(item);
+	LOGD("debug zoom=%i, x=%i, y=%i, id=%i",
+	     item->zoom, item->x, item->y, item->id);
+
+	// remove from the bucket chain
+	nedgz_cacheitem_t** _chain;
+	_chain = &self->bucket[nedgz_cache_hash(item->zoom, item->x,
+	                                        item->y, item->id)];
+	while(*_chain != item)
+	{
+		_chain = &(*_chain)->chain;
+	}
+	*_chain = item->chain;
+
+	nedgz_cache_unlink(self, item);
+	self->size -= item->size;
+	nedgz_cache_freedata(self, item->data);
+	free(item);
+}
+
+static void nedgz_cache_trim(nedgz_cache_t* self)
+{
+	assert(self);
+	LOGD("debug size=%i, max_size=%i",
+	     (int) self->size, (int) self->max_size);
+
+	// evict unreferenced items from the tail
+	nedgz_cacheitem_t* item = self->tail;
+	while(item && (self->size > self->max_size))
+	{
+		nedgz_cacheitem_t* prev = item->prev;
+		if(item->refcount == 0)
+		{
+			nedgz_cache_remove(self, item);
+		}
+		item = prev;
+	}
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+nedgz_cache_t* nedgz_cache_new(size_t max_size,
+                               nedgz_cache_free_fn free_fn)
+{
+	// free_fn may be NULL
+	LOGD("debug max_size=%i", (int) max_size);
+
+	nedgz_cache_t* self = (nedgz_cache_t*)
+	                      calloc(1, sizeof(nedgz_cache_t));
+	if(self == NULL)
+	{
+		LOGE("calloc failed");
+		return NULL;
+	}
+
+	if(pthread_mutex_init(&self->mutex, NULL) != 0)
+	{
+		LOGE("pthread_mutex_init failed");
+		goto fail_mutex;
+	}
+
+	self->max_size = max_size;
+	self->free_fn  = free_fn;
+
+	// success
+	return self;
+
+	// failure
+	fail_mutex:
+		free(self);
+	return NULL;
+}
+
+void nedgz_cache_delete(nedgz_cache_t** _self)
+{
+	assert(_self);
+
+	nedgz_cache_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug hits=%i, misses=%i", self->hits, self->misses);
+
+		while(self->head)
+		{
+			if(self->head->refcount)
+			{
+				LOGW("item is still referenced");
+			}
+			nedgz_cache_remove(self, self->head);
+		}
+
+		pthread_mutex_destroy(&self->mutex);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+nedgz_cacheitem_t* nedgz_cache_get(nedgz_cache_t* self,
+                                   int zoom, int x, int y,
+                                   int id)
+{
+	assert(self);
+	LOGD("debug zoom=%i, x=%i, y=%i, id=%i", zoom, x, y, id);
+
+	pthread_mutex_lock(&self->mutex);
+	nedgz_cacheitem_t* item = nedgz_cache_find(self, zoom, x, y, id);
+	if(item)
+	{
+		++item->refcount;
+		nedgz_cache_unlink(self, item);
+		nedgz_cache_pushfront(self, item);
+		++self->hits;
+	}
+	else
+	{
+		++self->misses;
+	}
+	pthread_mutex_unlock(&self->mutex);
+
+	return item;
+}
+
+nedgz_cacheitem_t* nedgz_cache_put(nedgz_cache_t* self,
+                                   int zoom, int x, int y,
+                                   int id, void* data,
+                                   int size)
+{
+	assert(self);
+	assert(data);
+	LOGD("debug zoom=%i, x=%i, y=%i, id=%i, size=%i",
+	     zoom, x, y, id, size);
+
+	// the cache takes ownership of data
+	pthread_mutex_lock(&self->mutex);
+
+	// another thread may have added the same key
+	nedgz_cacheitem_t* item = nedgz_cache_find(self, zoom, x, y, id);
+	if(item)
+	{
+		++item->refcount;
+		nedgz_cache_unlink(self, item);
+		nedgz_cache_pushfront(self, item);
+		pthread_mutex_unlock(&self->mutex);
+
+		nedgz_cache_freedata(self, data);
+		return item;
+	}
+
+	item = (nedgz_cacheitem_t*) malloc(sizeof(nedgz_cacheitem_t));
+	if(item == NULL)
+	{
+		LOGE("malloc failed");
+		goto fail_malloc;
+	}
+
+	item->zoom     = zoom;
+	item->x        = x;
+	item->y        = y;
+	item->id       = id;
+	item->size     = size;
+	item->refcount = 1;
+	item->data     = data;
+
+	int idx = nedgz_cache_hash(zoom, x, y, id);
+	item->chain       = self->bucket[idx];
+	self->bucket[idx] = item;
+	nedgz_cache_pushfront(self, item);
+	self->size += size;
+	nedgz_cache_trim(self);
+	pthread_mutex_unlock(&self->mutex);
+
+	// success
+	return item;
+
+	// failure
+	fail_malloc:
+		pthread_mutex_unlock(&self->mutex);
+		nedgz_cache_freedata(self, data);
+	return NULL;
+}
+
+nedgz_cacheitem_t* nedgz_cache_import(nedgz_cache_t* self,
+                                      const char* base,
+                                      int x, int y, int zoom)
+{
+	assert(self);
+	assert(self->free_fn == NULL);
+	assert(base);
+	LOGD("debug base=%s, x=%i, y=%i, zoom=%i", base, x, y, zoom);
+
+	nedgz_cacheitem_t* item;
+	item = nedgz_cache_get(self, zoom, x, y, NEDGZ_CACHE_TILE);
+	if(item)
+	{
+		return item;
+	}
+
+	nedgz_tile_t* tile = nedgz_tile_import(base, x, y, zoom);
+	if(tile == NULL)
+	{
+		return NULL;
+	}
+
+	// estimate the size of the tile
+	int size = (int) sizeof(nedgz_tile_t);
+	int idx;
+	for(idx = 0; idx < NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT; ++idx)
+	{
+		if(tile->subtile[idx])
+		{
+			size += (int) sizeof(nedgz_subtile_t);
+		}
+	}
+
+	return nedgz_cache_put(self, zoom, x, y, NEDGZ_CACHE_TILE,
+	                       (void*) tile, size);
+}
+
+void nedgz_cache_release(nedgz_cache_t* self,
+                         nedgz_cacheitem_t** _item)
+{
+	assert(self);
+	assert(_item);
+
+	nedgz_cacheitem_t* item = *_item;
+	if(item)
+	{
+		LOGD("debug zoom=%i, x=%i, y=%i, id=%i",
+		     item->zoom, item->x, item->y, item->id);
+
+		pthread_mutex_lock(&self->mutex);
+		assert(item->refcount > 0);
+		--item->refcount;
+		if(item->refcount == 0)
+		{
+			nedgz_cache_trim(self);
+		}
+		pthread_mutex_unlock(&self->mutex);
+		*_item = NULL;
+	}
+}
+
+void nedgz_cache_stats(nedgz_cache_t* self,
+                       int* hits, int* misses,
+                       size_t* size)
+{
+	assert(self);
+	assert(hits);
+	assert(misses);
+	assert(size);
+	LOGD("debug");
+
+	pthread_mutex_lock(&self->mutex);
+	*hits   = self->hits;
+	*misses = self->misses;
+	*size   = self->size;
+	pthread_mutex_unlock(&self->mutex);
+}
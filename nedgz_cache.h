@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef nedgz_cache_H
+#define nedgz_cache_H
+
+#include <pthread.h>
+#include "nedgz_tile.h"
+
+// the cache is a thread safe LRU of decoded data keyed by
+// zoom, x, y and a caller defined id (e.g. the subtile
+// index) which evicts the least recently used
+// unreferenced items once the total size exceeds max_size
+//
+// items returned by get/put/import are referenced and
+// must be released with nedgz_cache_release
+//
+// free_fn deletes the cached data and when NULL the data
+// is assumed to be a nedgz_tile_t
+
+#define NEDGZ_CACHE_BUCKETS 4096
+
+typedef void (*nedgz_cache_free_fn)(void* data);
+
+typedef struct nedgz_cacheitem_s
+{
+	int   zoom;
+	int   x;
+	int   y;
+	int   id;
+	int   size;
+	int   refcount;
+	void* data;
+
+	// hash bucket chain
+	struct nedgz_cacheitem_s* chain;
+
+	// LRU list where the head is the most recently used
+	struct nedgz_cacheitem_s* prev;
+	struct nedgz_cacheitem_s* next;
+} nedgz_cacheitem_t;
+
+typedef struct
+{
+	size_t              size;
+	size_t              max_size;
+	int                 hits;
+	int                 misses;
+	nedgz_cache_free_fn free_fn;
+	nedgz_cacheitem_t*  head;
+	nedgz_cacheitem_t*  tail;
+	nedgz_cacheitem_t*  bucket[NEDGZ_CACHE_BUCKETS];
+	pthread_mutex_t     mutex;
+} nedgz_cache_t;
+
+nedgz_cache_t*     nedgz_cache_new(size_t max_size,
+                                   nedgz_cache_free_fn free_fn);
+void               nedgz_cache_delete(nedgz_cache_t** _self);
+nedgz_cacheitem_t* nedgz_cache_get(nedgz_cache_t* self,
+                                   int zoom, int x, int y,
+                                   int id);
+nedgz_cacheitem_t* nedgz_cache_put(nedgz_cache_t* self,
+                                   int zoom, int x, int y,
+                                   int id, void* data,
+                                   int size);
+nedgz_cacheitem_t* nedgz_cache_import(nedgz_cache_t* self,
+                                      const char* base,
+                                      int x, int y, int zoom);
+void               nedgz_cache_release(nedgz_cache_t* self,
+                                       nedgz_cacheitem_t** _item);
+void               nedgz_cache_stats(nedgz_cache_t* self,
+                                     int* hits, int* misses,
+                                     size_t* size);
+
+#endif
@@ -0,0 +1,456 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <zlib.h>
+#include "nedgz_codec.h"
+
+#define LOG_TAG "nedgz"
+#include "nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+// the tag is not a valid zlib CMF byte (CM != 8) so
+// predicted blocks can be distinguished from zlib blocks
+#define NEDGZ_CODEC_TAG 0x50
+
+// rows of zero residuals are not stored
+#define NEDGZ_CODEC_KZERO 15
+
+// residuals whose quotient exceeds the limit are escaped
+// and stored as 16 raw bits
+#define NEDGZ_CODEC_LIMIT 24
+
+#define NEDGZ_CODEC_KBYTES (NEDGZ_SUBTILE_SIZE/2)
+
+typedef struct
+{
+	unsigned char* buf;
+	int            size;
+	int            used;
+	unsigned int   acc;
+	int            bits;
+} nedgz_bitw_t;
+
+static int nedgz_bitw_put(nedgz_bitw_t* self, unsigned int v, int n)
+{
+	assert(self);
+	assert(n <= 16);
+
+	self->acc   = (self->acc << n) | (v & ((1 << n) - 1));
+	self->bits += n;
+	while(self->bits >= 8)
+	{
+		if(self->used >= self->size)
+		{
+			return 0;
+		}
+		self->bits -= 8;
+		self->buf[self->used++] = (unsigned char) (self->acc >> self->bits);
+	}
+	return 1;
+}
+
+static int nedgz_bitw_flush(nedgz_bitw_t* self)
+{
+	assert(self);
+
+	if(self->bits > 0)
+	{
+		return nedgz_bitw_put(self, 0, 8 - self->bits);
+	}
+	return 1;
+}
+
+// leading ones in the left aligned bit buffer
+// limited to the escape limit
+static int nedgz_codec_ones(unsigned long long acc)
+{
+	acc = ~acc | (1ULL << (63 - NEDGZ_CODEC_LIMIT));
+	#ifdef __GNUC__
+		return __builtin_clzll(acc);
+	#else
+		int q = 0;
+		while((acc & (1ULL << 63)) == 0)
+		{
+			acc <<= 1;
+			++q;
+		}
+		return q;
+	#endif
+}
+
+static short nedgz_codec_predict(const short* data, int m, int n)
+{
+	assert(data);
+
+	const short* row = &data[m*NEDGZ_SUBTILE_SIZE];
+	if(m == 0)
+	{
+		return (n == 0) ? 0 : row[n - 1];
+	}
+	else if(n == 0)
+	{
+		return row[n - NEDGZ_SUBTILE_SIZE];
+	}
+
+	// the median edge detector is equivalent to the
+	// median of a, b and a + b - c which avoids branches
+	int a  = row[n - 1];
+	int b  = row[n - NEDGZ_SUBTILE_SIZE];
+	int c  = row[n - NEDGZ_SUBTILE_SIZE - 1];
+	int g  = a + b - c;
+	int mn = (a < b) ? a : b;
+	int mx = (a < b) ? b : a;
+	int t  = (mx < g) ? mx : g;
+	return (short) ((mn > t) ? mn : t);
+}
+
+static unsigned int nedgz_codec_zigzag(short r)
+{
+	int v = (int) r;
+	return (((unsigned int) v << 1) ^ (unsigned int) (v >> 15)) & 0xFFFF;
+}
+
+static short nedgz_codec_unzigzag(unsigned int u)
+{
+	return (short) ((u >> 1) ^ (0 - (u & 1)));
+}
+
+static int nedgz_codec_rowk(const unsigned int* u)
+{
+	assert(u);
+
+	int n;
+	int sum = 0;
+	for(n = 0; n < NEDGZ_SUBTILE_SIZE; ++n)
+	{
+		sum += u[n];
+	}
+
+	if(sum == 0)
+	{
+		return NEDGZ_CODEC_KZERO;
+	}
+
+	// choose the Rice parameter which minimizes the bits
+	int k;
+	int best_k    = 0;
+	int best_bits = 0;
+	for(k = 0; k < NEDGZ_CODEC_KZERO; ++k)
+	{
+		int bits = 0;
+		for(n = 0; n < NEDGZ_SUBTILE_SIZE; ++n)
+		{
+			unsigned int q = u[n] >> k;
+			bits += (q < NEDGZ_CODEC_LIMIT) ? (q + 1 + k) :
+			                                  (NEDGZ_CODEC_LIMIT + 16);
+		}
+
+		if((k == 0) || (bits < best_bits))
+		{
+			best_k    = k;
+			best_bits = bits;
+		}
+	}
+	return best_k;
+}
+
+static int nedgz_codec_encodep(nedgz_subtile_t* subtile,
+                               unsigned char* buf, int size)
+{
+	assert(subtile);
+	assert(buf);
+	LOGD("debug size=%i", size);
+
+	// tag and per-row k nibbles
+	int header = 1 + NEDGZ_CODEC_KBYTES;
+	if(size < header)
+	{
+		return 0;
+	}
+	buf[0] = NEDGZ_CODEC_TAG;
+
+	nedgz_bitw_t bitw;
+	bitw.buf  = buf;
+	bitw.size = size;
+	bitw.used = header;
+	bitw.acc  = 0;
+	bitw.bits = 0;
+
+	int m;
+	int n;
+	unsigned int u[NEDGZ_SUBTILE_SIZE];
+	short*       data = subtile->data;
+	for(m = 0; m < NEDGZ_SUBTILE_SIZE; ++m)
+	{
+		for(n = 0; n < NEDGZ_SUBTILE_SIZE; ++n)
+		{
+			short p = nedgz_codec_predict(data, m, n);
+			short r = (short) (data[m*NEDGZ_SUBTILE_SIZE + n] - p);
+			u[n] = nedgz_codec_zigzag(r);
+		}
+
+		int k = nedgz_codec_rowk(u);
+		if(m & 1)
+		{
+			buf[1 + m/2] |= (unsigned char) k;
+		}
+		else
+		{
+			buf[1 + m/2] = (unsigned char) (k << 4);
+		}
+
+		if(k == NEDGZ_CODEC_KZERO)
+		{
+			continue;
+		}
+
+		for(n = 0; n < NEDGZ_SUBTILE_SIZE; ++n)
+		{
+			unsigned int q = u[n] >> k;
+			if(q < NEDGZ_CODEC_LIMIT)
+			{
+				// unary quotient and k-bit remainder
+				for(; q >= 16; q -= 16)
+				{
+					if(nedgz_bitw_put(&bitw, 0xFFFF, 16) == 0)
+					{
+						return 0;
+					}
+				}
+
+				if((nedgz_bitw_put(&bitw, ((1 << q) - 1) << 1, q + 1) == 0) ||
+				   ((k > 0) && (nedgz_bitw_put(&bitw, u[n], k) == 0)))
+				{
+					return 0;
+				}
+			}
+			else
+			{
+				// escape
+				if((nedgz_bitw_put(&bitw, 0xFFFF, 16) == 0) ||
+				   (nedgz_bitw_put(&bitw, 0xFF, NEDGZ_CODEC_LIMIT - 16) == 0) ||
+				   (nedgz_bitw_put(&bitw, u[n], 16) == 0))
+				{
+					return 0;
+				}
+			}
+		}
+	}
+
+	if(nedgz_bitw_flush(&bitw) == 0)
+	{
+		return 0;
+	}
+
+	return bitw.used;
+}
+
+static int nedgz_codec_decodep(nedgz_subtile_t* subtile,
+                               const unsigned char* buf, int size)
+{
+	assert(subtile);
+	assert(buf);
+	LOGD("debug size=%i", size);
+
+	int header = 1 + NEDGZ_CODEC_KBYTES;
+	if((size < header) || (size > NEDGZ_CODEC_BOUND))
+	{
+		LOGE("invalid size=%i", size);
+		return 0;
+	}
+
+	// pad the block so the bit buffer may be refilled
+	// without checking the size for every sample
+	unsigned char pad[NEDGZ_CODEC_BOUND + 8];
+	memcpy(pad, buf, size);
+	memset(&pad[size], 0, 8);
+
+	// the bit buffer is left aligned
+	unsigned long long acc  = 0;
+	int                bits = 0;
+	int                used = header;
+
+	int          m;
+	int          n;
+	unsigned int u[NEDGZ_SUBTILE_SIZE];
+	short*       data = subtile->data;
+	for(m = 0; m < NEDGZ_SUBTILE_SIZE; ++m)
+	{
+		// decode the residuals for the row before
+		// reconstructing the heights to separate the
+		// bit buffer and predictor dependency chains
+		unsigned char kk = pad[1 + m/2];
+		int k = (m & 1) ? (kk & 0x0F) : (kk >> 4);
+		if(k == NEDGZ_CODEC_KZERO)
+		{
+			memset(u, 0, sizeof(u));
+		}
+		else
+		{
+			for(n = 0; n < NEDGZ_SUBTILE_SIZE; ++n)
+			{
+				// a sample requires at most LIMIT + 16 bits
+				while(bits <= 56)
+				{
+					if(used >= size + 8)
+					{
+						goto fail_decode;
+					}
+					acc  |= ((unsigned long long) pad[used++]) << (56 - bits);
+					bits += 8;
+				}
+
+				int q = nedgz_codec_ones(acc);
+				if(q < NEDGZ_CODEC_LIMIT)
+				{
+					acc <<= q + 1;
+					u[n] = (unsigned int) q << k;
+					if(k > 0)
+					{
+						u[n] |= (unsigned int) (acc >> (64 - k));
+						acc <<= k;
+					}
+					bits -= q + 1 + k;
+				}
+				else
+				{
+					acc <<= NEDGZ_CODEC_LIMIT;
+					u[n]  = (unsigned int) (acc >> 48);
+					acc <<= 16;
+					bits -= NEDGZ_CODEC_LIMIT + 16;
+				}
+			}
+		}
+
+		for(n = 0; n < NEDGZ_SUBTILE_SIZE; ++n)
+		{
+			short p = nedgz_codec_predict(data, m, n);
+			data[m*NEDGZ_SUBTILE_SIZE + n] = (short) (p + nedgz_codec_unzigzag(u[n]));
+		}
+	}
+
+	// verify the bits consumed were within the block
+	if(8*used - bits > 8*size)
+	{
+		goto fail_decode;
+	}
+
+	// success
+	return 1;
+
+	// failure
+	fail_decode:
+		LOGE("invalid block");
+	return 0;
+}
+
+static int nedgz_codec_encodez(nedgz_subtile_t* subtile,
+                               unsigned char* buf, int size)
+{
+	assert(subtile);
+	assert(buf);
+	LOGD("debug size=%i", size);
+
+	uLongf dst_size = (uLongf) size;
+	uLong  src_size = (uLong) sizeof(subtile->data);
+	assert(compressBound(src_size) <= NEDGZ_CODEC_BOUND);
+
+	if(compress2((Bytef*) buf, &dst_size,
+	             (const Bytef*) subtile->data, src_size,
+	             Z_DEFAULT_COMPRESSION) != Z_OK)
+	{
+		LOGE("compress2 failed");
+		return 0;
+	}
+
+	return (int) dst_size;
+}
+
+static int nedgz_codec_decodez(nedgz_subtile_t* subtile,
+                               const unsigned char* buf, int size)
+{
+	assert(subtile);
+	assert(buf);
+	LOGD("debug size=%i", size);
+
+	uLongf dst_size = (uLongf) sizeof(subtile->data);
+	if(uncompress((Bytef*) subtile->data, &dst_size,
+	              (const Bytef*) buf, (uLong) size) != Z_OK)
+	{
+		LOGE("uncompress failed");
+		return 0;
+	}
+
+	if(dst_size != sizeof(subtile->data))
+	{
+		LOGE("invalid dst_size=%i", (int) dst_size);
+		return 0;
+	}
+
+	return 1;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int nedgz_codec_encode(nedgz_subtile_t* subtile, int codec,
+                       unsigned char* buf, int size)
+{
+	assert(subtile);
+	assert(buf);
+	LOGD("debug codec=%i, size=%i", codec, size);
+
+	if(codec == NEDGZ_CODEC_PREDICT)
+	{
+		// fall back to zlib for blocks that exceed the bound
+		int bound = (size < NEDGZ_CODEC_BOUND) ? size : NEDGZ_CODEC_BOUND;
+		int bytes = nedgz_codec_encodep(subtile, buf, bound);
+		if(bytes > 0)
+		{
+			return bytes;
+		}
+	}
+
+	return nedgz_codec_encodez(subtile, buf, size);
+}
+
+int nedgz_codec_decode(nedgz_subtile_t* subtile,
+                       const unsigned char* buf, int size)
+{
+	assert(subtile);
+	assert(buf);
+	LOGD("debug size=%i", size);
+
+	if((size > 0) && (buf[0] == NEDGZ_CODEC_TAG))
+	{
+		return nedgz_codec_decodep(subtile, buf, size);
+	}
+	return nedgz_codec_decodez(subtile, buf, size);
+}
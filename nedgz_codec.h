@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef nedgz_codec_H
+#define nedgz_codec_H
+
+#include "nedgz_tile.h"
+
+// upper bound on the size of an encoded subtile
+#define NEDGZ_CODEC_BOUND 2112
+
+// NEDGZ_CODEC_ZLIB compresses the raw heights with zlib
+// NEDGZ_CODEC_PREDICT predicts each height from its
+// neighbors with the LOCO-I median edge detector and
+// Rice codes the residuals one row at a time
+#define NEDGZ_CODEC_ZLIB    0
+#define NEDGZ_CODEC_PREDICT 1
+
+// encode/decode individual subtiles so that they may be
+// stored as independent blocks and accessed randomly
+// the codec is detected automatically when decoding
+int nedgz_codec_encode(nedgz_subtile_t* subtile, int codec,
+                       unsigned char* buf, int size);
+int nedgz_codec_decode(nedgz_subtile_t* subtile,
+                       const unsigned char* buf, int size);
+
+#endif
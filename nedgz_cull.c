@@ -0,0 +1,492 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include <math.h>
+#include "nedgz_cull.h"
+#include "nedgz_profile.h"
+#include "nedgz_scene.h"
+#include "nedgz_tile.h"
+#include "nedgz_util.h"
+
+#define LOG_TAG "nedgz"
+#include "nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static double nedgz_cull_dot(const double* a, const double* b)
+{
+	assert(a);
+	assert(b);
+
+	return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+static void nedgz_cull_unit(double lat, double lon, double* u)
+{
+	assert(u);
+
+	double rlat = lat*M_PI/180.0;
+	double rlon = lon*M_PI/180.0;
+	u[0] = cos(rlat)*cos(rlon);
+	u[1] = cos(rlat)*sin(rlon);
+	u[2] = sin(rlat);
+}
+
+static void nedgz_cull_plane(double* plane, const double* n,
+                             const double* pos)
+{
+	assert(plane);
+	assert(n);
+	assert(pos);
+
+	double len = sqrt(nedgz_cull_dot(n, n));
+	plane[0] = n[0]/len;
+	plane[1] = n[1]/len;
+	plane[2] = n[2]/len;
+	plane[3] = -nedgz_cull_dot(plane, pos);
+}
+
+// bounds the tile x,y,zoom at heights min/max (meters) with
+// a sphere which includes the curvature between samples
+static void nedgz_cull_bound(int layout,
+                             int x, int y, int zoom,
+                             double hmin, double hmax,
+                             double* center, double* radius)
+{
+	assert(center);
+	assert(radius);
+
+	if(zoom < NEDGZ_CULL_ZOOM_MIN)
+	{
+		center[0] = 0.0;
+		center[1] = 0.0;
+		center[2] = 0.0;
+		*radius   = NEDGZ_CULL_RADIUS + hmax;
+		return;
+	}
+
+	// sample a 3x3 grid of the tile at min/max heights
+	double u[9][3];
+	double lat;
+	double lon;
+	int    m;
+	int    n;
+	int    k;
+	for(m = 0; m < 3; ++m)
+	{
+		for(n = 0; n < 3; ++n)
+		{
+			nedgz_scene_tile2coord(layout,
+			                       (float) x + 0.5f*((float) n),
+			                       (float) y + 0.5f*((float) m),
+			                       zoom, &lat, &lon);
+			nedgz_cull_unit(lat, lon, u[3*m + n]);
+		}
+	}
+
+	double rmin = NEDGZ_CULL_RADIUS + hmin;
+	double rmax = NEDGZ_CULL_RADIUS + hmax;
+	center[0] = 0.0;
+	center[1] = 0.0;
+	center[2] = 0.0;
+	for(k = 0; k < 9; ++k)
+	{
+		center[0] += 0.5*(rmin + rmax)*u[k][0]/9.0;
+		center[1] += 0.5*(rmin + rmax)*u[k][1]/9.0;
+		center[2] += 0.5*(rmin + rmax)*u[k][2]/9.0;
+	}
+
+	double r2 = 0.0;
+	for(k = 0; k < 9; ++k)
+	{
+		double lo[3] =
+		{
+			rmin*u[k][0] - center[0],
+			rmin*u[k][1] - center[1],
+			rmin*u[k][2] - center[2],
+		};
+		double hi[3] =
+		{
+			rmax*u[k][0] - center[0],
+			rmax*u[k][1] - center[1],
+			rmax*u[k][2] - center[2],
+		};
+
+		double d2 = nedgz_cull_dot(lo, lo);
+		if(d2 > r2)
+		{
+			r2 = d2;
+		}
+
+		d2 = nedgz_cull_dot(hi, hi);
+		if(d2 > r2)
+		{
+			r2 = d2;
+		}
+	}
+
+	// the surface between samples bulges by at most the
+	// sagitta of the angle between the center and a corner
+	double cmin = 1.0;
+	for(k = 0; k < 9; k += 2)
+	{
+		double c = nedgz_cull_dot(u[4], u[k]);
+		if(c < cmin)
+		{
+			cmin = c;
+		}
+	}
+	double psi = acos((cmin > 1.0) ? 1.0 : cmin);
+
+	*radius = sqrt(r2) + rmax*(1.0 - cos(0.5*psi));
+}
+
+static int nedgz_cull_frustum(nedgz_cullcamera_t* camera,
+                              const double* center,
+                              double radius)
+{
+	assert(camera);
+	assert(center);
+
+	int i;
+	for(i = 0; i < 6; ++i)
+	{
+		const double* p = camera->plane[i];
+		if(nedgz_cull_dot(p, center) + p[3] < -radius)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+// returns 1 when the sphere is beyond the horizon plane
+// and inside the shadow cone of the earth
+static int nedgz_cull_horizon(nedgz_cullcamera_t* camera,
+                              const double* center,
+                              double radius)
+{
+	assert(camera);
+	assert(center);
+
+	double r0 = NEDGZ_CULL_RADIUS_MIN;
+	double dc = sqrt(nedgz_cull_dot(camera->pos, camera->pos));
+	if(dc <= r0)
+	{
+		return 0;
+	}
+
+	double c[3] =
+	{
+		camera->pos[0]/dc,
+		camera->pos[1]/dc,
+		camera->pos[2]/dc,
+	};
+
+	if(nedgz_cull_dot(center, c) + radius > r0*r0/dc)
+	{
+		return 0;
+	}
+
+	double v[3] =
+	{
+		center[0] - camera->pos[0],
+		center[1] - camera->pos[1],
+		center[2] - camera->pos[2],
+	};
+
+	double dv = sqrt(nedgz_cull_dot(v, v));
+	if(dv <= radius)
+	{
+		return 0;
+	}
+
+	double cosb  = -nedgz_cull_dot(v, c)/dv;
+	double beta  = acos((cosb > 1.0) ? 1.0 : ((cosb < -1.0) ? -1.0 : cosb));
+	double gamma = asin(radius/dv);
+	double alpha = asin(r0/dc);
+
+	return (beta + gamma <= alpha) ? 1 : 0;
+}
+
+static int nedgz_cull_add(nedgz_cull_t* self, int x, int y, int zoom)
+{
+	assert(self);
+
+	if(self->count == self->max_count)
+	{
+		int max_count = self->max_count ? 2*self->max_count : 256;
+
+		nedgz_culltile_t* tiles;
+		tiles = (nedgz_culltile_t*)
+		        realloc(self->tiles, max_count*sizeof(nedgz_culltile_t));
+		if(tiles == NULL)
+		{
+			LOGE("realloc failed");
+			return 0;
+		}
+		self->tiles     = tiles;
+		self->max_count = max_count;
+	}
+
+	nedgz_culltile_t* tile = &self->tiles[self->count++];
+	tile->x    = x;
+	tile->y    = y;
+	tile->zoom = zoom;
+
+	return 1;
+}
+
+static int nedgz_cull_visit(void* priv,
+                            const nedgz_scenenode_t* node,
+                            int x, int y, int zoom)
+{
+	assert(priv);
+	assert(node);
+
+	nedgz_cull_t*       self   = (nedgz_cull_t*) priv;
+	nedgz_cullcamera_t* camera = &self->camera;
+	++self->visited;
+
+	double hmin = 0.0;
+	double hmax = 0.0;
+	if((node->min != NEDGZ_NODATA) && (node->max != NEDGZ_NODATA))
+	{
+		hmin = (double) nedgz_feet2meters((float) node->min);
+		hmax = (double) nedgz_feet2meters((float) node->max);
+	}
+
+	double center[3];
+	double radius;
+	nedgz_cull_bound(self->layout, x, y, zoom,
+	                 hmin, hmax, center, &radius);
+	if(nedgz_cull_frustum(camera, center, radius) == 0)
+	{
+		++self->culled_frustum;
+		return 0;
+	}
+
+	if(nedgz_cull_horizon(camera, center, radius))
+	{
+		++self->culled_horizon;
+		return 0;
+	}
+
+	// the geometric error is the sample spacing at the
+	// equator which is the largest for each zoom level
+	int    tiles = nedgz_scene_tiles(self->layout, zoom);
+	double error = 2.0*M_PI*NEDGZ_CULL_RADIUS/
+	               ((double) tiles*NEDGZ_TILE_SIZE);
+	double v[3] =
+	{
+		center[0] - camera->pos[0],
+		center[1] - camera->pos[1],
+		center[2] - camera->pos[2],
+	};
+	double d = sqrt(nedgz_cull_dot(v, v)) - radius;
+
+	int children = (node->mask & 0xF) ? 1 : 0;
+	int exists   = (node->mask & NEDGZ_SCENENODE_EXISTS) ? 1 : 0;
+	int refine   = (d <= 1.0) ||
+	               (error*camera->sse_scale/d > camera->sse_max);
+	if(children && (zoom < self->max_zoom) && (refine || (exists == 0)))
+	{
+		++self->refined;
+		return 1;
+	}
+
+	if(exists && (nedgz_cull_add(self, x, y, zoom) == 0))
+	{
+		self->error = 1;
+	}
+	return 0;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+void nedgz_cull_coord(double lat, double lon,
+                      double alt, double* pos)
+{
+	assert(pos);
+	LOGD("debug lat=%lf, lon=%lf, alt=%lf", lat, lon, alt);
+
+	double u[3];
+	nedgz_cull_unit(lat, lon, u);
+	pos[0] = (NEDGZ_CULL_RADIUS + alt)*u[0];
+	pos[1] = (NEDGZ_CULL_RADIUS + alt)*u[1];
+	pos[2] = (NEDGZ_CULL_RADIUS + alt)*u[2];
+}
+
+void nedgz_cull_camera(nedgz_cullcamera_t* camera,
+                       double lat, double lon,
+                       double alt, double heading,
+                       double pitch, double fovy,
+                       double aspect, double znear,
+                       double zfar, int height,
+                       double sse_max)
+{
+	assert(camera);
+	LOGD("debug lat=%lf, lon=%lf, alt=%lf, heading=%lf, pitch=%lf",
+	     lat, lon, alt, heading, pitch);
+
+	nedgz_cull_coord(lat, lon, alt, camera->pos);
+
+	// local east/north/up frame
+	double rlat = lat*M_PI/180.0;
+	double rlon = lon*M_PI/180.0;
+	double e[3] = { -sin(rlon), cos(rlon), 0.0 };
+	double n[3] =
+	{
+		-sin(rlat)*cos(rlon),
+		-sin(rlat)*sin(rlon),
+		cos(rlat),
+	};
+	double up[3];
+	nedgz_cull_unit(lat, lon, up);
+
+	// forward, up and right vectors of the camera
+	double rh = heading*M_PI/180.0;
+	double rp = pitch*M_PI/180.0;
+	double f[3];
+	double u[3];
+	double r[3];
+	int    i;
+	for(i = 0; i < 3; ++i)
+	{
+		double h = cos(rh)*n[i] + sin(rh)*e[i];
+		f[i] = cos(rp)*h + sin(rp)*up[i];
+		u[i] = -sin(rp)*h + cos(rp)*up[i];
+	}
+	r[0] = f[1]*u[2] - f[2]*u[1];
+	r[1] = f[2]*u[0] - f[0]*u[2];
+	r[2] = f[0]*u[1] - f[1]*u[0];
+
+	double tan_v = tan(0.5*fovy*M_PI/180.0);
+	double tan_h = tan_v*aspect;
+	double p[3];
+
+	// left, right, bottom, top
+	for(i = 0; i < 3; ++i)
+	{
+		p[i] = tan_h*f[i] + r[i];
+	}
+	nedgz_cull_plane(camera->plane[0], p, camera->pos);
+	for(i = 0; i < 3; ++i)
+	{
+		p[i] = tan_h*f[i] - r[i];
+	}
+	nedgz_cull_plane(camera->plane[1], p, camera->pos);
+	for(i = 0; i < 3; ++i)
+	{
+		p[i] = tan_v*f[i] + u[i];
+	}
+	nedgz_cull_plane(camera->plane[2], p, camera->pos);
+	for(i = 0; i < 3; ++i)
+	{
+		p[i] = tan_v*f[i] - u[i];
+	}
+	nedgz_cull_plane(camera->plane[3], p, camera->pos);
+
+	// near, far
+	nedgz_cull_plane(camera->plane[4], f, camera->pos);
+	camera->plane[4][3] -= znear;
+	for(i = 0; i < 3; ++i)
+	{
+		p[i] = -f[i];
+	}
+	nedgz_cull_plane(camera->plane[5], p, camera->pos);
+	camera->plane[5][3] += zfar;
+
+	camera->sse_scale = (double) height/(2.0*tan_v);
+	camera->sse_max   = sse_max;
+}
+
+nedgz_cull_t* nedgz_cull_new(void)
+{
+	LOGD("debug");
+
+	nedgz_cull_t* self = (nedgz_cull_t*) calloc(1, sizeof(nedgz_cull_t));
+	if(self == NULL)
+	{
+		LOGE("calloc failed");
+		return NULL;
+	}
+
+	return self;
+}
+
+void nedgz_cull_delete(nedgz_cull_t** _self)
+{
+	assert(_self);
+
+	nedgz_cull_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug");
+
+		free(self->tiles);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+int nedgz_cull_update(nedgz_cull_t* self,
+                      nedgz_scenearray_t* scene,
+                      int layout,
+                      nedgz_cullcamera_t* camera,
+                      int max_zoom)
+{
+	assert(self);
+	assert(scene);
+	assert(camera);
+	LOGD("debug layout=%i, max_zoom=%i", layout, max_zoom);
+
+	NEDGZ_PROFILE_BEGIN(cull_update);
+	self->layout         = layout;
+	self->camera         = *camera;
+	self->max_zoom       = max_zoom;
+	self->count          = 0;
+	self->visited        = 0;
+	self->culled_frustum = 0;
+	self->culled_horizon = 0;
+	self->refined        = 0;
+	self->error          = 0;
+
+	int ret = 1;
+	if((nedgz_scenearray_traverse(scene, nedgz_cull_visit,
+	                              (void*) self) == 0) ||
+	   self->error)
+	{
+		ret = 0;
+	}
+	NEDGZ_PROFILE_END(cull_update);
+
+	return ret;
+}
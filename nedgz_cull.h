@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef nedgz_cull_H
+#define nedgz_cull_H
+
+#include "nedgz_scenearray.h"
+
+// The cull selects the tiles of a scene array to load for a
+// camera. Each node is bounded by a sphere built from the
+// tile corners at the scene min/max heights which is tested
+// against the frustum planes and the horizon of the earth.
+// Visible nodes are refined while their screen-space error
+// exceeds the budget and the deepest existing nodes which
+// satisfy the budget are selected.
+//
+// Positions are earth centered coordinates in meters where
+// the earth is modeled as a sphere of NEDGZ_CULL_RADIUS and
+// the horizon is tested against the smaller sphere of
+// NEDGZ_CULL_RADIUS_MIN so that culling is conservative.
+//
+// The layout (e.g. NEDGZ_SCENE_NED) gives the tile size of
+// the scene array as for the nedgz_scene queries.
+//
+// Nodes above NEDGZ_CULL_ZOOM_MIN are bounded by the entire
+// earth because their tiles are too large to be bounded by
+// the corners.
+
+#define NEDGZ_CULL_RADIUS     6378137.0
+#define NEDGZ_CULL_RADIUS_MIN 6356752.0
+#define NEDGZ_CULL_ZOOM_MIN   6
+
+// planes are a*x + b*y + c*z + d >= 0 for points inside
+// and sse_scale converts the ratio of the geometric error
+// to the distance into pixels
+typedef struct
+{
+	double pos[3];
+	double plane[6][4];
+	double sse_scale;
+	double sse_max;
+} nedgz_cullcamera_t;
+
+typedef struct
+{
+	int x;
+	int y;
+	int zoom;
+} nedgz_culltile_t;
+
+typedef struct
+{
+	int                layout;
+	nedgz_cullcamera_t camera;
+	int                max_zoom;
+
+	// selected tiles
+	int               count;
+	int               max_count;
+	nedgz_culltile_t* tiles;
+
+	// statistics of the last update
+	int visited;
+	int culled_frustum;
+	int culled_horizon;
+	int refined;
+
+	// error of the last visit
+	int error;
+} nedgz_cull_t;
+
+// heading is clockwise from north and pitch is negative
+// below the horizon where fovy is the vertical field of
+// view and height is the viewport height (in degrees and
+// pixels respectively)
+void          nedgz_cull_camera(nedgz_cullcamera_t* camera,
+                                double lat, double lon,
+                                double alt, double heading,
+                                double pitch, double fovy,
+                                double aspect, double znear,
+                                double zfar, int height,
+                                double sse_max);
+void          nedgz_cull_coord(double lat, double lon,
+                               double alt, double* pos);
+nedgz_cull_t* nedgz_cull_new(void);
+void          nedgz_cull_delete(nedgz_cull_t** _self);
+int           nedgz_cull_update(nedgz_cull_t* self,
+                                nedgz_scenearray_t* scene,
+                                int layout,
+                                nedgz_cullcamera_t* camera,
+                                int max_zoom);
+
+#endif
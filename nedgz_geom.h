@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef nedgz_geom_H
+#define nedgz_geom_H
+
+#include "nedgz_tile.h"
+#include "nedgz_util.h"
+
+// NEDGZ_GEOM_DEFINE generates inlined accessors and coordinate
+// functions for a tile of count x count subtiles of size x size
+// samples of type. The generated functions are named after the
+// geometry (e.g. nedgz_geom32_coord) and the constants fold
+// at compile time so that each configuration shares the same
+// code without runtime parameters.
+//
+// NAME_index(m, n)
+//     index of sample m,n in a row-major subtile
+// NAME_coord(x, y, zoom, i, j, m, n, &lat, &lon)
+//     lat/lon of sample m,n in subtile i,j
+// NAME_coordv(x, y, zoom, i, j, lat, lon)
+//     lat[m] and lon[n] for every sample in subtile i,j
+// NAME_interpolate(src, u, v)
+//     bilinear sample of a subtile where u,v are in [0,1]
+// NAME_subsample(dst, stride, src, qi, qj)
+//     samples src into quadrant qi,qj (0 or 1) of the dst
+//     subtile where each dst row is stride samples apart
+
+#define NEDGZ_GEOM_DEFINE(NAME, COUNT, SIZE, TYPE)                 \
+                                                                   \
+static inline int NAME##_index(int m, int n)                       \
+{                                                                  \
+	return m*(SIZE) + n;                                           \
+}                                                                  \
+                                                                   \
+static inline void NAME##_coord(int x, int y, int zoom,            \
+                                int i, int j, int m, int n,        \
+                                double* lat, double* lon)          \
+{                                                                  \
+	float s  = (float) (SIZE);                                     \
+	float c  = (float) (COUNT);                                    \
+	float nn = (float) n/(s - 1.0f);                               \
+	float mm = (float) m/(s - 1.0f);                               \
+	nedgz_tile2coord((float) x + ((float) j + nn)/c,               \
+	                 (float) y + ((float) i + mm)/c,               \
+	                 zoom, lat, lon);                              \
+}                                                                  \
+                                                                   \
+static inline void NAME##_coordv(int x, int y, int zoom,           \
+                                 int i, int j,                     \
+                                 double* lat, double* lon)         \
+{                                                                  \
+	nedgz_subtile2coordv(x, y, zoom, i, j, (SIZE), lat, lon);      \
+}                                                                  \
+                                                                   \
+static inline TYPE NAME##_interpolate(const TYPE* src,             \
+                                      float u, float v)            \
+{                                                                  \
+	/* "float indices" */                                          \
+	float pu = u*((SIZE) - 1);                                     \
+	float pv = v*((SIZE) - 1);                                     \
+                                                                   \
+	/* determine indices to sample */                              \
+	int u0 = (int) pu;                                             \
+	int v0 = (int) pv;                                             \
+	int u1 = u0 + 1;                                               \
+	int v1 = v0 + 1;                                               \
+	if(u0 < 0)                                                     \
+	{                                                              \
+		u0 = 0;                                                    \
+	}                                                              \
+	if(u1 >= (SIZE))                                               \
+	{                                                              \
+		u1 = (SIZE) - 1;                                           \
+	}                                                              \
+	if(v0 < 0)                                                     \
+	{                                                              \
+		v0 = 0;                                                    \
+	}                                                              \
+	if(v1 >= (SIZE))                                               \
+	{                                                              \
+		v1 = (SIZE) - 1;                                           \
+	}                                                              \
+                                                                   \
+	/* compute interpolation coordinates */                        \
+	float uf = pu - (float) u0;                                    \
+	float vf = pv - (float) v0;                                    \
+                                                                   \
+	/* sample interpolation values */                              \
+	float h00 = (float) src[v0*(SIZE) + u0];                       \
+	float h01 = (float) src[v1*(SIZE) + u0];                       \
+	float h10 = (float) src[v0*(SIZE) + u1];                       \
+	float h11 = (float) src[v1*(SIZE) + u1];                       \
+                                                                   \
+	/* interpolate u then v */                                     \
+	float h0010 = h00 + uf*(h10 - h00);                            \
+	float h0111 = h01 + uf*(h11 - h01);                            \
+	return (TYPE) (h0010 + vf*(h0111 - h0010) + 0.5f);             \
+}                                                                  \
+                                                                   \
+static inline void NAME##_subsample(TYPE* dst, int stride,         \
+                                    const TYPE* src,               \
+                                    int qi, int qj)                \
+{                                                                  \
+	int   half = (SIZE)/2;                                         \
+	int   m0   = qi*half;                                          \
+	int   n0   = qj*half;                                          \
+	float s    = (float) (SIZE) - 1.0f;                            \
+	int   m;                                                       \
+	int   n;                                                       \
+	for(m = m0; m < m0 + half; ++m)                                \
+	{                                                              \
+		float v = 2.0f*((float) m)/s - (float) qi;                 \
+		for(n = n0; n < n0 + half; ++n)                            \
+		{                                                          \
+			float u = 2.0f*((float) n)/s - (float) qj;             \
+			dst[m*stride + n] = NAME##_interpolate(src, u, v);     \
+		}                                                          \
+	}                                                              \
+}
+
+// nedgz tiles
+NEDGZ_GEOM_DEFINE(nedgz_geom32, NEDGZ_SUBTILE_COUNT,
+                  NEDGZ_SUBTILE_SIZE, short)
+
+// heightmap and hillshade textures
+#define NEDGZ_GEOM256_SIZE 256
+
+NEDGZ_GEOM_DEFINE(nedgz_geom256, NEDGZ_SUBTILE_COUNT,
+                  NEDGZ_GEOM256_SIZE, short)
+
+#endif
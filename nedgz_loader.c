@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include "nedgz_loader.h"
+
+#define LOG_TAG "nedgz"
+#include "nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static void nedgz_loaderitem_push(nedgz_loaderitem_t** _head,
+                                  nedgz_loaderitem_t** _tail,
+                                  nedgz_loaderitem_t* item)
+{
+	assert(_head);
+	assert(_tail);
+	assert(item);
+	LOGD("debug x=%i, y=%i, zoom=%i", item->x, item->y, item->zoom);
+
+	item->next = NULL;
+	if(*_tail)
+	{
+		(*_tail)->next = item;
+	}
+	else
+	{
+		*_head = item;
+	}
+	*_tail = item;
+}
+
+static nedgz_loaderitem_t*
+nedgz_loaderitem_pop(nedgz_loaderitem_t** _head,
+                     nedgz_loaderitem_t** _tail)
+{
+	assert(_head);
+	assert(_tail);
+	LOGD("debug");
+
+	nedgz_loaderitem_t* item = *_head;
+	if(item)
+	{
+		*_head = item->next;
+		if(*_head == NULL)
+		{
+			*_tail = NULL;
+		}
+		item->next = NULL;
+	}
+	return item;
+}
+
+static void nedgz_loaderitem_free(nedgz_loaderitem_t** _head,
+                                  nedgz_loaderitem_t** _tail)
+{
+	assert(_head);
+	assert(_tail);
+	LOGD("debug");
+
+	nedgz_loaderitem_t* item;
+	while((item = nedgz_loaderitem_pop(_head, _tail)))
+	{
+		nedgz_tile_delete(&item->tile);
+		free(item);
+	}
+}
+
+static void* nedgz_loader_thread(void* arg)
+{
+	assert(arg);
+	LOGD("debug");
+
+	nedgz_loader_t* self = (nedgz_loader_t*) arg;
+
+	pthread_mutex_lock(&self->mutex);
+	while(1)
+	{
+		nedgz_loaderitem_t* item;
+		item = nedgz_loaderitem_pop(&self->request_head,
+		                            &self->request_tail);
+		if(item == NULL)
+		{
+			if(self->running == 0)
+			{
+				break;
+			}
+			pthread_cond_wait(&self->cond_request, &self->mutex);
+			continue;
+		}
+
+		// read and decode the tile without the lock
+		pthread_mutex_unlock(&self->mutex);
+		item->tile = nedgz_tile_import(self->base, item->x,
+		                               item->y, item->zoom);
+		pthread_mutex_lock(&self->mutex);
+
+		nedgz_loaderitem_push(&self->complete_head,
+		                      &self->complete_tail, item);
+		pthread_cond_signal(&self->cond_complete);
+	}
+	pthread_mutex_unlock(&self->mutex);
+
+	return NULL;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+nedgz_loader_t* nedgz_loader_new(const char* base,
+                                 int thread_count)
+{
+	assert(base);
+	assert(thread_count > 0);
+	LOGD("debug base=%s, thread_count=%i", base, thread_count);
+
+	nedgz_loader_t* self = (nedgz_loader_t*)
+	                       calloc(1, sizeof(nedgz_loader_t));
+	if(self == NULL)
+	{
+		LOGE("calloc failed");
+		return NULL;
+	}
+
+	snprintf(self->base, 256, "%s", base);
+	self->running = 1;
+
+	self->threads = (pthread_t*)
+	                calloc(thread_count, sizeof(pthread_t));
+	if(self->threads == NULL)
+	{
+		LOGE("calloc failed");
+		goto fail_threads;
+	}
+
+	if(pthread_mutex_init(&self->mutex, NULL) != 0)
+	{
+		LOGE("pthread_mutex_init failed");
+		goto fail_mutex;
+	}
+
+	if(pthread_cond_init(&self->cond_request, NULL) != 0)
+	{
+		LOGE("pthread_cond_init failed");
+		goto fail_cond_request;
+	}
+
+	if(pthread_cond_init(&self->cond_complete, NULL) != 0)
+	{
+		LOGE("pthread_cond_init failed");
+		goto fail_cond_complete;
+	}
+
+	int i;
+	for(i = 0; i < thread_count; ++i)
+	{
+		if(pthread_create(&self->threads[i], NULL,
+		                  nedgz_loader_thread, (void*) self) != 0)
+		{
+			LOGE("pthread_create failed");
+			goto fail_create;
+		}
+		++self->thread_count;
+	}
+
+	// success
+	return self;
+
+	// failure
+	fail_create:
+		pthread_mutex_lock(&self->mutex);
+		self->running = 0;
+		pthread_cond_broadcast(&self->cond_request);
+		pthread_mutex_unlock(&self->mutex);
+		for(i = 0; i < self->thread_count; ++i)
+		{
+			pthread_join(self->threads[i], NULL);
+		}
+		pthread_cond_destroy(&self->cond_complete);
+	fail_cond_complete:
+		pthread_cond_destroy(&self->cond_request);
+	fail_cond_request:
+		pthread_mutex_destroy(&self->mutex);
+	fail_mutex:
+		free(self->threads);
+	fail_threads:
+		free(self);
+	return NULL;
+}
+
+void nedgz_loader_delete(nedgz_loader_t** _self)
+{
+	assert(_self);
+
+	nedgz_loader_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug");
+
+		// discard outstanding requests and stop the threads
+		pthread_mutex_lock(&self->mutex);
+		nedgz_loaderitem_free(&self->request_head,
+		                      &self->request_tail);
+		self->running = 0;
+		pthread_cond_broadcast(&self->cond_request);
+		pthread_mutex_unlock(&self->mutex);
+
+		int i;
+		for(i = 0; i < self->thread_count; ++i)
+		{
+			pthread_join(self->threads[i], NULL);
+		}
+
+		nedgz_loaderitem_free(&self->complete_head,
+		                      &self->complete_tail);
+		pthread_cond_destroy(&self->cond_complete);
+		pthread_cond_destroy(&self->cond_request);
+		pthread_mutex_destroy(&self->mutex);
+		free(self->threads);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+int nedgz_loader_request(nedgz_loader_t* self,
+                         int x, int y, int zoom)
+{
+	assert(self);
+	LOGD("debug x=%i, y=%i, zoom=%i", x, y, zoom);
+
+	nedgz_loaderitem_t* item = (nedgz_loaderitem_t*)
+	                           malloc(sizeof(nedgz_loaderitem_t));
+	if(item == NULL)
+	{
+		LOGE("malloc failed");
+		return 0;
+	}
+
+	item->x    = x;
+	item->y    = y;
+	item->zoom = zoom;
+	item->tile = NULL;
+
+	pthread_mutex_lock(&self->mutex);
+	nedgz_loaderitem_push(&self->request_head,
+	                      &self->request_tail, item);
+	pthread_cond_signal(&self->cond_request);
+	pthread_mutex_unlock(&self->mutex);
+
+	++self->pending;
+	return 1;
+}
+
+int nedgz_loader_pending(nedgz_loader_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	return self->pending;
+}
+
+int nedgz_loader_next(nedgz_loader_t* self,
+                      int* x, int* y, int* zoom,
+                      nedgz_tile_t** _tile)
+{
+	assert(self);
+	assert(x);
+	assert(y);
+	assert(zoom);
+	assert(_tile);
+	LOGD("debug");
+
+	// tile is NULL when the import failed
+	*_tile = NULL;
+	if(self->pending == 0)
+	{
+		return 0;
+	}
+
+	pthread_mutex_lock(&self->mutex);
+	nedgz_loaderitem_t* item;
+	while((item = nedgz_loaderitem_pop(&self->complete_head,
+	                                   &self->complete_tail)) == NULL)
+	{
+		pthread_cond_wait(&self->cond_complete, &self->mutex);
+	}
+	pthread_mutex_unlock(&self->mutex);
+
+	*x     = item->x;
+	*y     = item->y;
+	*zoom  = item->zoom;
+	*_tile = item->tile;
+	free(item);
+
+	--self->pending;
+	return 1;
+}
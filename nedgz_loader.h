@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef nedgz_loader_H
+#define nedgz_loader_H
+
+#include <pthread.h>
+#include "nedgz_tile.h"
+
+// the loader imports batches of tiles on a pool of worker
+// threads so that reads and decoding overlap with the
+// caller which collects the completed requests in the
+// order that they finish
+//
+// nedgz_loader_request/nedgz_loader_next must be called
+// from a single thread
+
+typedef struct nedgz_loaderitem_s
+{
+	int                        x;
+	int                        y;
+	int                        zoom;
+	nedgz_tile_t*              tile;
+	struct nedgz_loaderitem_s* next;
+} nedgz_loaderitem_t;
+
+typedef struct
+{
+	char base[256];
+
+	// requests which have not been collected
+	int pending;
+
+	// request/complete queues are protected by mutex
+	int                 running;
+	nedgz_loaderitem_t* request_head;
+	nedgz_loaderitem_t* request_tail;
+	nedgz_loaderitem_t* complete_head;
+	nedgz_loaderitem_t* complete_tail;
+	pthread_mutex_t     mutex;
+	pthread_cond_t      cond_request;
+	pthread_cond_t      cond_complete;
+
+	int        thread_count;
+	pthread_t* threads;
+} nedgz_loader_t;
+
+nedgz_loader_t* nedgz_loader_new(const char* base,
+                                 int thread_count);
+void            nedgz_loader_delete(nedgz_loader_t** _self);
+int             nedgz_loader_request(nedgz_loader_t* self,
+                                     int x, int y, int zoom);
+int             nedgz_loader_pending(nedgz_loader_t* self);
+int             nedgz_loader_next(nedgz_loader_t* self,
+                                  int* x, int* y, int* zoom,
+                                  nedgz_tile_t** _tile);
+
+#endif
@@ -27,6 +27,347 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdarg.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <time.h>
+
+#define NEDGZ_LOG_LINESIZE 256
+#define NEDGZ_LOG_BUFSIZE  65536
+#define NEDGZ_LOG_SITES    256
+#define NEDGZ_LOG_INTERVAL 100000000
+
+typedef struct
+{
+	const char* func;
+	int         line;
+	int         count;
+	int         dropped;
+	double      t0;
+} nedgz_logsite_t;
+
+// the mutex protects the configuration, call sites and
+// front buffer while the io mutex serializes writes of
+// the back buffer (lock order is mutex then io)
+static pthread_once_t  nedgz_log_once  = PTHREAD_ONCE_INIT;
+static pthread_mutex_t nedgz_log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t nedgz_log_io    = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  nedgz_log_cond  = PTHREAD_COND_INITIALIZER;
+static pthread_t       nedgz_log_thread;
+
+static int  nedgz_log_minlevel = ANDROID_LOG_DEBUG;
+static int  nedgz_log_fmt      = NEDGZ_LOG_FORMAT_TEXT;
+static int  nedgz_log_maxrate  = 0;
+static int  nedgz_log_running  = 0;
+static int  nedgz_log_size     = 0;
+static char nedgz_log_buf0[NEDGZ_LOG_BUFSIZE];
+static char nedgz_log_buf1[NEDGZ_LOG_BUFSIZE];
+static char* nedgz_log_front = nedgz_log_buf0;
+static char* nedgz_log_back  = nedgz_log_buf1;
+
+static nedgz_logsite_t nedgz_log_sites[NEDGZ_LOG_SITES];
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static const char* NEDGZ_LOG_TYPE = "DIWE";
+
+static double nedgz_log_time(clockid_t clk)
+{
+	struct timespec ts;
+	clock_gettime(clk, &ts);
+	return (double) ts.tv_sec + ((double) ts.tv_nsec)/1.0E9;
+}
+
+static int nedgz_log_parselevel(const char* s)
+{
+	assert(s);
+
+	const char* c = strchr(NEDGZ_LOG_TYPE, toupper(s[0]));
+	if(c && (s[0] != '\0'))
+	{
+		return (int) (c - NEDGZ_LOG_TYPE);
+	}
+	else if((s[0] >= '0') && (s[0] <= '3'))
+	{
+		return s[0] - '0';
+	}
+	return ANDROID_LOG_DEBUG;
+}
+
+// call with the mutex locked, returns with the mutex locked
+static void nedgz_log_flushlocked(void)
+{
+	if(nedgz_log_size == 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&nedgz_log_io);
+	char* buf  = nedgz_log_front;
+	int   size = nedgz_log_size;
+	nedgz_log_front = nedgz_log_back;
+	nedgz_log_back  = buf;
+	nedgz_log_size  = 0;
+	pthread_mutex_unlock(&nedgz_log_mutex);
+
+	fwrite(buf, 1, (size_t) size, stdout);
+	fflush(stdout);
+
+	pthread_mutex_unlock(&nedgz_log_io);
+	pthread_mutex_lock(&nedgz_log_mutex);
+}
+
+static void* nedgz_log_run(void* arg)
+{
+	pthread_mutex_lock(&nedgz_log_mutex);
+	while(nedgz_log_running)
+	{
+		if(nedgz_log_size == 0)
+		{
+			pthread_cond_wait(&nedgz_log_cond, &nedgz_log_mutex);
+			continue;
+		}
+
+		// allow messages to accumulate before flushing
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += NEDGZ_LOG_INTERVAL;
+		if(ts.tv_nsec >= 1000000000)
+		{
+			ts.tv_sec  += 1;
+			ts.tv_nsec -= 1000000000;
+		}
+		pthread_cond_timedwait(&nedgz_log_cond, &nedgz_log_mutex, &ts);
+		nedgz_log_flushlocked();
+	}
+	pthread_mutex_unlock(&nedgz_log_mutex);
+	return NULL;
+}
+
+// call with the mutex locked
+static void nedgz_log_start(void)
+{
+	if(nedgz_log_running)
+	{
+		return;
+	}
+
+	nedgz_log_running = 1;
+	if(pthread_create(&nedgz_log_thread, NULL, nedgz_log_run, NULL) != 0)
+	{
+		// fall back to synchronous flushing
+		nedgz_log_running = 0;
+	}
+}
+
+// call with the mutex locked, returns with the mutex locked
+static void nedgz_log_stop(void)
+{
+	if(nedgz_log_running == 0)
+	{
+		return;
+	}
+
+	nedgz_log_running = 0;
+	pthread_cond_signal(&nedgz_log_cond);
+	pthread_mutex_unlock(&nedgz_log_mutex);
+	pthread_join(nedgz_log_thread, NULL);
+	pthread_mutex_lock(&nedgz_log_mutex);
+	nedgz_log_flushlocked();
+}
+
+static void nedgz_log_exit(void)
+{
+	pthread_mutex_lock(&nedgz_log_mutex);
+	nedgz_log_stop();
+	nedgz_log_flushlocked();
+	pthread_mutex_unlock(&nedgz_log_mutex);
+}
+
+static void nedgz_log_init(void)
+{
+	const char* s;
+	if((s = getenv("NEDGZ_LOG_LEVEL")))
+	{
+		nedgz_log_minlevel = nedgz_log_parselevel(s);
+	}
+
+	if((s = getenv("NEDGZ_LOG_FORMAT")) && (strcmp(s, "json") == 0))
+	{
+		nedgz_log_fmt = NEDGZ_LOG_FORMAT_JSON;
+	}
+
+	if((s = getenv("NEDGZ_LOG_RATE")))
+	{
+		nedgz_log_maxrate = (int) strtol(s, NULL, 0);
+	}
+
+	atexit(nedgz_log_exit);
+
+	#ifndef ANDROID
+		s = getenv("NEDGZ_LOG_ASYNC");
+		if((s == NULL) || (strcmp(s, "0") != 0))
+		{
+			nedgz_log_start();
+		}
+	#endif
+}
+
+// returns the number of suppressed messages to report or
+// -1 if this message should be dropped
+// call with the mutex locked
+static int nedgz_log_ratelimit(const char* func, int line)
+{
+	assert(func);
+
+	if(nedgz_log_maxrate <= 0)
+	{
+		return 0;
+	}
+
+	// find the call site
+	unsigned int h = (unsigned int) (((size_t) func) >> 3);
+	h = h*31 + (unsigned int) line;
+	int i;
+	nedgz_logsite_t* site = NULL;
+	for(i = 0; i < NEDGZ_LOG_SITES; ++i)
+	{
+		nedgz_logsite_t* s = &nedgz_log_sites[(h + i)%NEDGZ_LOG_SITES];
+		if(s->func == NULL)
+		{
+			s->func = func;
+			s->line = line;
+			site    = s;
+			break;
+		}
+		else if((s->func == func) && (s->line == line))
+		{
+			site = s;
+			break;
+		}
+	}
+
+	// table is full
+	if(site == NULL)
+	{
+		return 0;
+	}
+
+	double t = nedgz_log_time(CLOCK_MONOTONIC);
+	if(t - site->t0 >= 1.0)
+	{
+		int dropped   = site->dropped;
+		site->t0      = t;
+		site->count   = 1;
+		site->dropped = 0;
+		return dropped;
+	}
+	else if(site->count < nedgz_log_maxrate)
+	{
+		++site->count;
+		return 0;
+	}
+
+	++site->dropped;
+	return -1;
+}
+
+static int nedgz_log_escape(char* dst, int size, const char* src)
+{
+	assert(dst);
+	assert(src);
+
+	int n = 0;
+	while(*src && (n + 7 < size))
+	{
+		unsigned char c = (unsigned char) *src++;
+		if((c == '"') || (c == '\\'))
+		{
+			dst[n++] = '\\';
+			dst[n++] = (char) c;
+		}
+		else if(c == '\n')
+		{
+			dst[n++] = '\\';
+			dst[n++] = 'n';
+		}
+		else if(c < 0x20)
+		{
+			n += snprintf(&dst[n], (size_t) (size - n), "\\u%04x", c);
+		}
+		else
+		{
+			dst[n++] = (char) c;
+		}
+	}
+	dst[n] = '\0';
+	return n;
+}
+
+// call with the mutex locked
+static void nedgz_log_append(const char* func, int line, int type, const char* tag, const char* msg)
+{
+	assert(func);
+	assert(tag);
+	assert(msg);
+
+	char buf[4*NEDGZ_LOG_LINESIZE];
+	int  size;
+	if(nedgz_log_fmt == NEDGZ_LOG_FORMAT_JSON)
+	{
+		char etag[NEDGZ_LOG_LINESIZE];
+		char emsg[2*NEDGZ_LOG_LINESIZE];
+		nedgz_log_escape(etag, NEDGZ_LOG_LINESIZE, tag);
+		nedgz_log_escape(emsg, 2*NEDGZ_LOG_LINESIZE, msg);
+		size = snprintf(buf, sizeof(buf),
+		                "{\"time\":%.3lf,\"level\":\"%c\",\"tag\":\"%s\","
+		                "\"func\":\"%s\",\"line\":%i,\"msg\":\"%s\"}\n",
+		                nedgz_log_time(CLOCK_REALTIME),
+		                NEDGZ_LOG_TYPE[type & 3], etag, func, line, emsg);
+	}
+	else
+	{
+		size = snprintf(buf, NEDGZ_LOG_LINESIZE, "%c/%s: %s@%i %s",
+		                NEDGZ_LOG_TYPE[type & 3], tag, func, line, msg);
+		if(size >= NEDGZ_LOG_LINESIZE)
+		{
+			size = NEDGZ_LOG_LINESIZE - 1;
+		}
+		buf[size++] = '\n';
+	}
+
+	if(size >= (int) sizeof(buf))
+	{
+		size = (int) sizeof(buf) - 1;
+		buf[size - 1] = '\n';
+	}
+
+	// other threads may append while the flush has dropped
+	// the mutex so check the space again after each flush
+	while(nedgz_log_size + size > NEDGZ_LOG_BUFSIZE)
+	{
+		nedgz_log_flushlocked();
+	}
+
+	if(nedgz_log_size == 0)
+	{
+		pthread_cond_signal(&nedgz_log_cond);
+	}
+	memcpy(&nedgz_log_front[nedgz_log_size], buf, (size_t) size);
+	nedgz_log_size += size;
+
+	// warnings and errors are written immediately in case
+	// the process is about to fail
+	if((nedgz_log_running == 0) || (type >= ANDROID_LOG_WARN))
+	{
+		nedgz_log_flushlocked();
+	}
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
 
 void nedgz_log(const char* func, int line, int type, const char* tag, const char* fmt, ...)
 {
@@ -34,32 +375,93 @@ void nedgz_log(const char* func, int line, int type, const char* tag, const char
 	assert(tag);
 	assert(fmt);
 
-	char buf[256];
-	#ifdef ANDROID
-		snprintf(buf, 256, "%s@%i ", func, line);
-	#else
-		if(type == ANDROID_LOG_DEBUG)
-			snprintf(buf, 256, "D/%s: %s@%i ", tag, func, line);
-		else if(type == ANDROID_LOG_INFO)
-			snprintf(buf, 256, "I/%s: %s@%i ", tag, func, line);
-		else if(type == ANDROID_LOG_WARN)
-			snprintf(buf, 256, "W/%s: %s@%i ", tag, func, line);
-		else if(type == ANDROID_LOG_ERROR)
-			snprintf(buf, 256, "E/%s: %s@%i ", tag, func, line);
-	#endif
+	pthread_once(&nedgz_log_once, nedgz_log_init);
+	if(type < __atomic_load_n(&nedgz_log_minlevel, __ATOMIC_RELAXED))
+	{
+		return;
+	}
+
+	char msg[NEDGZ_LOG_LINESIZE];
+	va_list argptr;
+	va_start(argptr, fmt);
+	vsnprintf(msg, NEDGZ_LOG_LINESIZE, fmt, argptr);
+	va_end(argptr);
 
-	int size = (int) strlen(buf);
-	if(size < 256)
+	pthread_mutex_lock(&nedgz_log_mutex);
+	int dropped = nedgz_log_ratelimit(func, line);
+	if(dropped < 0)
 	{
-		va_list argptr;
-		va_start(argptr, fmt);
-		vsnprintf(&buf[size], 256 - size, fmt, argptr);
-		va_end(argptr);
+		pthread_mutex_unlock(&nedgz_log_mutex);
+		return;
 	}
+
 	#ifdef ANDROID
-		__android_log_print(type, tag, "%s", buf);
+		pthread_mutex_unlock(&nedgz_log_mutex);
+		if(dropped > 0)
+		{
+			__android_log_print(ANDROID_LOG_WARN, tag, "%s@%i suppressed %i messages",
+			                    func, line, dropped);
+		}
+		__android_log_print(type, tag, "%s@%i %s", func, line, msg);
 	#else
-		printf("%s\n", buf);
-		fflush(stdout);
+		if(dropped > 0)
+		{
+			char note[64];
+			snprintf(note, 64, "suppressed %i messages", dropped);
+			nedgz_log_append(func, line, ANDROID_LOG_WARN, tag, note);
+		}
+		nedgz_log_append(func, line, type, tag, msg);
+		pthread_mutex_unlock(&nedgz_log_mutex);
+	#endif
+}
+
+void nedgz_log_level(int level)
+{
+	pthread_once(&nedgz_log_once, nedgz_log_init);
+	__atomic_store_n(&nedgz_log_minlevel, level, __ATOMIC_RELAXED);
+}
+
+void nedgz_log_format(int format)
+{
+	pthread_once(&nedgz_log_once, nedgz_log_init);
+
+	pthread_mutex_lock(&nedgz_log_mutex);
+	nedgz_log_fmt = format;
+	pthread_mutex_unlock(&nedgz_log_mutex);
+}
+
+void nedgz_log_rate(int rate)
+{
+	pthread_once(&nedgz_log_once, nedgz_log_init);
+
+	pthread_mutex_lock(&nedgz_log_mutex);
+	nedgz_log_maxrate = rate;
+	pthread_mutex_unlock(&nedgz_log_mutex);
+}
+
+void nedgz_log_async(int async)
+{
+	pthread_once(&nedgz_log_once, nedgz_log_init);
+
+	pthread_mutex_lock(&nedgz_log_mutex);
+	#ifndef ANDROID
+		if(async)
+		{
+			nedgz_log_start();
+		}
+		else
+		{
+			nedgz_log_stop();
+		}
 	#endif
+	pthread_mutex_unlock(&nedgz_log_mutex);
+}
+
+void nedgz_log_flush(void)
+{
+	pthread_once(&nedgz_log_once, nedgz_log_init);
+
+	pthread_mutex_lock(&nedgz_log_mutex);
+	nedgz_log_flushlocked();
+	pthread_mutex_unlock(&nedgz_log_mutex);
 }
@@ -35,6 +35,13 @@
 * debugging.                                               *
 *                                                          *
 * LOG{DIWE}("") will output func@line with no message      *
+*                                                          *
+* Non-Android output is buffered and may be configured at  *
+* runtime with the following environment variables         *
+* NEDGZ_LOG_LEVEL=D|I|W|E  minimum level to output         *
+* NEDGZ_LOG_FORMAT=text|json                               *
+* NEDGZ_LOG_RATE=n  max messages per call site per second  *
+* NEDGZ_LOG_ASYNC=0 disable the background flush thread    *
 ***********************************************************/
 
 // support non-Android environments
@@ -51,9 +58,23 @@
 	#define LOG_TAG NULL
 #endif
 
+#define NEDGZ_LOG_FORMAT_TEXT 0
+#define NEDGZ_LOG_FORMAT_JSON 1
+
 // logging using Android "standard" macros
 void nedgz_log(const char* func, int line, int type, const char* tag, const char* fmt, ...);
 
+// runtime configuration
+// level:  messages below level are discarded
+// format: NEDGZ_LOG_FORMAT_TEXT or NEDGZ_LOG_FORMAT_JSON
+// rate:   max messages per call site per second (0 for unlimited)
+// async:  flush buffered messages on a background thread
+void nedgz_log_level(int level);
+void nedgz_log_format(int format);
+void nedgz_log_rate(int rate);
+void nedgz_log_async(int async);
+void nedgz_log_flush(void);
+
 #ifndef LOGD
 	#ifdef LOG_DEBUG
 		#define LOGD(...) (nedgz_log(__func__, __LINE__, ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__))
@@ -0,0 +1,573 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "nedgz_codec.h"
+#include "nedgz_pack.h"
+
+#define LOG_TAG "nedgz"
+#include "nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+#define NEDGZ_PACK_HEADER_SIZE 32
+#define NEDGZ_PACK_TABLE_COUNT (NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT)
+#define NEDGZ_PACK_TABLE_SIZE  ((int) (2*NEDGZ_PACK_TABLE_COUNT*sizeof(int)))
+
+// the range may come from an untrusted header so the count
+// and index are computed in 64 bits
+static long long nedgz_pack_count(nedgz_pack_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	return ((long long) self->x1 - self->x0 + 1)*
+	       ((long long) self->y1 - self->y0 + 1);
+}
+
+static int nedgz_pack_valid(nedgz_pack_t* self, int x, int y)
+{
+	assert(self);
+	LOGD("debug x=%i, y=%i", x, y);
+
+	return (x >= self->x0) && (x <= self->x1) &&
+	       (y >= self->y0) && (y <= self->y1);
+}
+
+static long long nedgz_pack_idx(nedgz_pack_t* self, int x, int y)
+{
+	assert(self);
+	LOGD("debug x=%i, y=%i", x, y);
+
+	return ((long long) y - self->y0)*
+	       ((long long) self->x1 - self->x0 + 1) +
+	       ((long long) x - self->x0);
+}
+
+static const unsigned char*
+nedgz_pack_table(nedgz_pack_t* self, int x, int y)
+{
+	assert(self);
+	assert(self->map);
+	LOGD("debug x=%i, y=%i", x, y);
+
+	if(nedgz_pack_valid(self, x, y) == 0)
+	{
+		return NULL;
+	}
+
+	long long offset;
+	size_t    ioffset = NEDGZ_PACK_HEADER_SIZE +
+	                    (size_t) nedgz_pack_idx(self, x, y)*
+	                    sizeof(long long);
+	memcpy((void*) &offset, (const void*) &self->map[ioffset],
+	       sizeof(long long));
+	if(offset == 0)
+	{
+		return NULL;
+	}
+
+	if((offset < 0) ||
+	   ((size_t) offset + NEDGZ_PACK_TABLE_SIZE > self->size))
+	{
+		LOGE("invalid offset=%lli", offset);
+		return NULL;
+	}
+
+	return &self->map[offset];
+}
+
+static int nedgz_pack_hasij(const unsigned char* table,
+                            int i, int j)
+{
+	assert(table);
+	LOGD("debug i=%i, j=%i", i, j);
+
+	int size;
+	int idx = i*NEDGZ_SUBTILE_COUNT + j;
+	memcpy((void*) &size, (const void*) &table[(2*idx + 1)*sizeof(int)],
+	       sizeof(int));
+	return size ? 1 : 0;
+}
+
+static int nedgz_pack_decode(nedgz_pack_t* self,
+                             const unsigned char* table,
+                             int i, int j,
+                             nedgz_subtile_t* subtile)
+{
+	assert(self);
+	assert(table);
+	assert(subtile);
+	LOGD("debug i=%i, j=%i", i, j);
+
+	int entry[2];
+	int idx = i*NEDGZ_SUBTILE_COUNT + j;
+	memcpy((void*) entry, (const void*) &table[2*idx*sizeof(int)],
+	       sizeof(entry));
+	if(entry[1] == 0)
+	{
+		// subtile does not exist
+		return 0;
+	}
+
+	size_t offset = (size_t) (table - self->map);
+	if((entry[0] < NEDGZ_PACK_TABLE_SIZE) || (entry[1] < 0) ||
+	   (offset + entry[0] + entry[1] > self->size))
+	{
+		LOGE("invalid offset=%i, size=%i", entry[0], entry[1]);
+		return 0;
+	}
+
+	return nedgz_codec_decode(subtile, &table[entry[0]], entry[1]);
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+nedgz_pack_t* nedgz_pack_create(const char* fname, int zoom,
+                                int x0, int y0, int x1, int y1)
+{
+	assert(fname);
+	assert(zoom >= 0);
+	assert(x0 >= 0);
+	assert(y0 >= 0);
+	assert(x0 <= x1);
+	assert(y0 <= y1);
+	LOGD("debug fname=%s, zoom=%i, x0=%i, y0=%i, x1=%i, y1=%i",
+	     fname, zoom, x0, y0, x1, y1);
+
+	nedgz_pack_t* self = (nedgz_pack_t*) malloc(sizeof(nedgz_pack_t));
+	if(self == NULL)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->zoom = zoom;
+	self->x0   = x0;
+	self->y0   = y0;
+	self->x1   = x1;
+	self->y1   = y1;
+	self->fd    = -1;
+	self->size  = 0;
+	self->map   = NULL;
+	self->error = 0;
+	snprintf(self->fname, 256, "%s", fname);
+
+	size_t count = (size_t) nedgz_pack_count(self);
+	self->index  = (long long*) calloc(count, sizeof(long long));
+	if(self->index == NULL)
+	{
+		LOGE("calloc failed");
+		goto fail_index;
+	}
+
+	char pname[256];
+	snprintf(pname, 256, "%s.part", fname);
+	self->f = fopen(pname, "w");
+	if(self->f == NULL)
+	{
+		LOGE("fopen %s failed", pname);
+		goto fail_fopen;
+	}
+
+	// write the header and reserve the index
+	int header[8] =
+	{
+		NEDGZ_PACK_MAGIC, NEDGZ_PACK_VERSION,
+		zoom, x0, y0, x1, y1, 0
+	};
+	if(fwrite((const void*) header, sizeof(header), 1, self->f) != 1)
+	{
+		LOGE("fwrite failed");
+		goto fail_header;
+	}
+
+	if(fwrite((const void*) self->index, sizeof(long long),
+	          count, self->f) != count)
+	{
+		LOGE("fwrite failed");
+		goto fail_header;
+	}
+
+	// success
+	return self;
+
+	// failure
+	fail_header:
+		fclose(self->f);
+		unlink(pname);
+	fail_fopen:
+		free(self->index);
+	fail_index:
+		free(self);
+	return NULL;
+}
+
+nedgz_pack_t* nedgz_pack_open(const char* fname)
+{
+	assert(fname);
+	LOGD("debug fname=%s", fname);
+
+	nedgz_pack_t* self = (nedgz_pack_t*) malloc(sizeof(nedgz_pack_t));
+	if(self == NULL)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->fname[0] = '\0';
+	self->f        = NULL;
+	self->index    = NULL;
+	self->error    = 0;
+
+	self->fd = open(fname, O_RDONLY);
+	if(self->fd == -1)
+	{
+		LOGE("open %s failed", fname);
+		goto fail_open;
+	}
+
+	struct stat st;
+	if((fstat(self->fd, &st) == -1) ||
+	   (st.st_size < NEDGZ_PACK_HEADER_SIZE))
+	{
+		LOGE("invalid %s", fname);
+		goto fail_stat;
+	}
+	self->size = (size_t) st.st_size;
+
+	void* map = mmap(NULL, self->size, PROT_READ, MAP_SHARED,
+	                 self->fd, 0);
+	if(map == MAP_FAILED)
+	{
+		LOGE("mmap %s failed", fname);
+		goto fail_mmap;
+	}
+	self->map = (const unsigned char*) map;
+
+	int header[8];
+	memcpy((void*) header, (const void*) self->map, sizeof(header));
+	if((header[0] != NEDGZ_PACK_MAGIC) ||
+	   (header[1] != NEDGZ_PACK_VERSION))
+	{
+		LOGE("invalid magic=0x%X, version=%i", header[0], header[1]);
+		goto fail_header;
+	}
+
+	self->zoom = header[2];
+	self->x0   = header[3];
+	self->y0   = header[4];
+	self->x1   = header[5];
+	self->y1   = header[6];
+	// compare the count to the index entries which fit in
+	// the file since the index size may overflow
+	long long max_count = (long long)
+	                      ((self->size - NEDGZ_PACK_HEADER_SIZE)/
+	                       sizeof(long long));
+	if((self->zoom < 0) ||
+	   (self->x0 < 0) || (self->y0 < 0) ||
+	   (self->x0 > self->x1) || (self->y0 > self->y1) ||
+	   (nedgz_pack_count(self) > max_count))
+	{
+		LOGE("invalid %s", fname);
+		goto fail_header;
+	}
+
+	// success
+	return self;
+
+	// failure
+	fail_header:
+		munmap((void*) self->map, self->size);
+	fail_mmap:
+	fail_stat:
+		close(self->fd);
+	fail_open:
+		free(self);
+	return NULL;
+}
+
+int nedgz_pack_close(nedgz_pack_t** _self)
+{
+	assert(_self);
+
+	int ret = 1;
+	nedgz_pack_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug");
+
+		if(self->f)
+		{
+			// write the index
+			size_t count = (size_t) nedgz_pack_count(self);
+			if(self->error)
+			{
+				LOGE("incomplete %s", self->fname);
+				ret = 0;
+			}
+			else if((fseeko(self->f, NEDGZ_PACK_HEADER_SIZE,
+			                SEEK_SET) == -1) ||
+			        (fwrite((const void*) self->index,
+			                sizeof(long long),
+			                count, self->f) != count))
+			{
+				LOGE("failed to write index");
+				ret = 0;
+			}
+
+			if(fclose(self->f) != 0)
+			{
+				LOGE("fclose failed");
+				ret = 0;
+			}
+
+			// only a complete pack replaces fname
+			char pname[256];
+			snprintf(pname, 256, "%s.part", self->fname);
+			if(ret && (rename(pname, self->fname) != 0))
+			{
+				LOGE("rename %s failed", pname);
+				ret = 0;
+			}
+
+			if(ret == 0)
+			{
+				unlink(pname);
+			}
+			free(self->index);
+		}
+
+		if(self->map)
+		{
+			munmap((void*) self->map, self->size);
+			close(self->fd);
+		}
+
+		free(self);
+		*_self = NULL;
+	}
+	return ret;
+}
+
+int nedgz_pack_add(nedgz_pack_t* self, nedgz_tile_t* tile)
+{
+	assert(self);
+	assert(self->f);
+	assert(tile);
+	LOGD("debug x=%i, y=%i, zoom=%i", tile->x, tile->y, tile->zoom);
+
+	if((tile->zoom != self->zoom) ||
+	   (nedgz_pack_valid(self, tile->x, tile->y) == 0))
+	{
+		LOGE("invalid x=%i, y=%i, zoom=%i",
+		     tile->x, tile->y, tile->zoom);
+		return 0;
+	}
+
+	long long idx = nedgz_pack_idx(self, tile->x, tile->y);
+	if(self->index[idx])
+	{
+		LOGE("exists x=%i, y=%i", tile->x, tile->y);
+		return 0;
+	}
+
+	// encode the subtiles
+	int   table[2*NEDGZ_PACK_TABLE_COUNT];
+	int   size  = NEDGZ_PACK_TABLE_COUNT*NEDGZ_CODEC_BOUND;
+	int   count = 0;
+	int   used  = 0;
+	unsigned char* blocks = (unsigned char*) malloc(size);
+	if(blocks == NULL)
+	{
+		LOGE("malloc failed");
+		return 0;
+	}
+
+	int i;
+	int j;
+	for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+	{
+		for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+		{
+			int k = i*NEDGZ_SUBTILE_COUNT + j;
+			nedgz_subtile_t* subtile = nedgz_tile_getij(tile, i, j);
+			if(subtile == NULL)
+			{
+				table[2*k]     = 0;
+				table[2*k + 1] = 0;
+				continue;
+			}
+
+			int bytes = nedgz_codec_encode(subtile, NEDGZ_CODEC_ZLIB,
+			                               &blocks[used], size - used);
+			if(bytes == 0)
+			{
+				goto fail_encode;
+			}
+			table[2*k]     = NEDGZ_PACK_TABLE_SIZE + used;
+			table[2*k + 1] = bytes;
+			used += bytes;
+			++count;
+		}
+	}
+
+	if(count == 0)
+	{
+		// silently succeed
+		free(blocks);
+		return 1;
+	}
+
+	// append the table and blocks
+	if(fseeko(self->f, 0, SEEK_END) == -1)
+	{
+		LOGE("fseeko failed");
+		goto fail_write;
+	}
+
+	long long offset = (long long) ftello(self->f);
+	if((offset <= 0) ||
+	   (fwrite((const void*) table, sizeof(table), 1, self->f) != 1) ||
+	   (fwrite((const void*) blocks, used, 1, self->f) != 1))
+	{
+		LOGE("fwrite failed");
+		goto fail_write;
+	}
+	self->index[idx] = offset;
+
+	free(blocks);
+
+	// success
+	return 1;
+
+	// failure
+	fail_write:
+	fail_encode:
+		self->error = 1;
+		free(blocks);
+	return 0;
+}
+
+int nedgz_pack_exists(nedgz_pack_t* self, int x, int y)
+{
+	assert(self);
+	LOGD("debug x=%i, y=%i", x, y);
+
+	if(self->map)
+	{
+		return nedgz_pack_table(self, x, y) ? 1 : 0;
+	}
+
+	if(nedgz_pack_valid(self, x, y) == 0)
+	{
+		return 0;
+	}
+	return self->index[nedgz_pack_idx(self, x, y)] ? 1 : 0;
+}
+
+nedgz_tile_t* nedgz_pack_import(nedgz_pack_t* self, int x, int y)
+{
+	assert(self);
+	assert(self->map);
+	LOGD("debug x=%i, y=%i", x, y);
+
+	const unsigned char* table = nedgz_pack_table(self, x, y);
+	if(table == NULL)
+	{
+		return NULL;
+	}
+
+	nedgz_tile_t* tile = nedgz_tile_new(x, y, self->zoom);
+	if(tile == NULL)
+	{
+		return NULL;
+	}
+
+	int i;
+	int j;
+	for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+	{
+		for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+		{
+			if(nedgz_pack_hasij(table, i, j) == 0)
+			{
+				continue;
+			}
+
+			nedgz_subtile_t* subtile = nedgz_tile_newij(tile, i, j);
+			if(subtile == NULL)
+			{
+				goto fail_subtile;
+			}
+
+			if(nedgz_pack_decode(self, table, i, j, subtile) == 0)
+			{
+				goto fail_decode;
+			}
+		}
+	}
+
+	// success
+	return tile;
+
+	// failure
+	fail_decode:
+	fail_subtile:
+		nedgz_tile_delete(&tile);
+	return NULL;
+}
+
+int nedgz_pack_importij(nedgz_pack_t* self,
+                        int x, int y,
+                        int i, int j,
+                        nedgz_subtile_t* subtile)
+{
+	assert(self);
+	assert(self->map);
+	assert(i >= 0);
+	assert(i < NEDGZ_SUBTILE_COUNT);
+	assert(j >= 0);
+	assert(j < NEDGZ_SUBTILE_COUNT);
+	assert(subtile);
+	LOGD("debug x=%i, y=%i, i=%i, j=%i", x, y, i, j);
+
+	const unsigned char* table = nedgz_pack_table(self, x, y);
+	if(table == NULL)
+	{
+		return 0;
+	}
+
+	return nedgz_pack_decode(self, table, i, j, subtile);
+}
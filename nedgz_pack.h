@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef nedgz_pack_H
+#define nedgz_pack_H
+
+#include <stdio.h>
+#include "nedgz_tile.h"
+
+/***********************************************************
+* A pack stores the tiles for a range x0,y0 to x1,y1 of a  *
+* single zoom level in one file. The file consists of a    *
+* header, a fixed index with one offset for each x,y in    *
+* the range and a subtile table for each existing tile.    *
+* Subtiles are compressed as independent blocks so that a  *
+* single subtile may be decoded without inflating the      *
+* entire tile.                                             *
+*                                                          *
+* header:  magic, version, zoom, x0, y0, x1, y1            *
+* index:   long long offset[(x1-x0+1)*(y1-y0+1)]           *
+* table:   {int offset, int size}[64] (relative to table)  *
+* blocks:  compressed subtiles                             *
+*                                                          *
+* An index offset of 0 indicates the tile does not exist   *
+* and a table size of 0 indicates the subtile does not     *
+* exist.                                                   *
+*                                                          *
+* A pack is created as fname.part and renamed to fname by  *
+* nedgz_pack_close once the index has been written so a    *
+* failed build never leaves a valid looking pack.          *
+***********************************************************/
+
+#define NEDGZ_PACK_MAGIC   0x5044454E
+#define NEDGZ_PACK_VERSION 1
+
+typedef struct
+{
+	// tile range
+	int zoom;
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+
+	// write mode
+	char       fname[256];
+	FILE*      f;
+	long long* index;
+	int        error;
+
+	// read mode
+	int                  fd;
+	size_t               size;
+	const unsigned char* map;
+} nedgz_pack_t;
+
+nedgz_pack_t* nedgz_pack_create(const char* fname, int zoom,
+                                int x0, int y0, int x1, int y1);
+nedgz_pack_t* nedgz_pack_open(const char* fname);
+int           nedgz_pack_close(nedgz_pack_t** _self);
+int           nedgz_pack_add(nedgz_pack_t* self,
+                             nedgz_tile_t* tile);
+int           nedgz_pack_exists(nedgz_pack_t* self,
+                                int x, int y);
+nedgz_tile_t* nedgz_pack_import(nedgz_pack_t* self,
+                                int x, int y);
+int           nedgz_pack_importij(nedgz_pack_t* self,
+                                  int x, int y,
+                                  int i, int j,
+                                  nedgz_subtile_t* subtile);
+
+#endif
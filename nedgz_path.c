@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "nedgz_path.h"
+
+#define LOG_TAG "nedgz"
+#include "nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+typedef struct nedgz_pathitem_s
+{
+	char dname[256];
+	struct nedgz_pathitem_s* chain;
+} nedgz_pathitem_t;
+
+static pthread_mutex_t   nedgz_path_mutex = PTHREAD_MUTEX_INITIALIZER;
+static nedgz_pathitem_t* nedgz_path_bucket[NEDGZ_PATH_BUCKETS];
+
+static unsigned int nedgz_path_hash(const char* dname)
+{
+	assert(dname);
+
+	// djb2
+	unsigned int hash = 5381;
+	while(*dname)
+	{
+		hash = 33*hash + (unsigned char) *dname;
+		++dname;
+	}
+
+	return hash%NEDGZ_PATH_BUCKETS;
+}
+
+static int nedgz_path_find(const char* dname)
+{
+	assert(dname);
+
+	nedgz_pathitem_t* item;
+	item = nedgz_path_bucket[nedgz_path_hash(dname)];
+	while(item)
+	{
+		if(strcmp(item->dname, dname) == 0)
+		{
+			return 1;
+		}
+		item = item->chain;
+	}
+
+	return 0;
+}
+
+static void nedgz_path_add(const char* dname)
+{
+	assert(dname);
+
+	nedgz_pathitem_t* item = (nedgz_pathitem_t*)
+	                         malloc(sizeof(nedgz_pathitem_t));
+	if(item == NULL)
+	{
+		// the directory will be checked again next time
+		LOGE("malloc failed");
+		return;
+	}
+
+	unsigned int hash = nedgz_path_hash(dname);
+	snprintf(item->dname, 256, "%s", dname);
+	item->chain             = nedgz_path_bucket[hash];
+	nedgz_path_bucket[hash] = item;
+}
+
+static void nedgz_path_remove(const char* dname)
+{
+	assert(dname);
+
+	nedgz_pathitem_t** _item;
+	_item = &nedgz_path_bucket[nedgz_path_hash(dname)];
+	while(*_item)
+	{
+		nedgz_pathitem_t* item = *_item;
+		if(strcmp(item->dname, dname) == 0)
+		{
+			*_item = item->chain;
+			free(item);
+			return;
+		}
+		_item = &item->chain;
+	}
+}
+
+// forgets each directory of fname
+// call with the mutex locked
+static void nedgz_path_forget(const char* fname)
+{
+	assert(fname);
+
+	int  len = strnlen(fname, 255);
+	int  i;
+	char dname[256];
+	for(i = 1; i < len; ++i)
+	{
+		if(fname[i] == '/')
+		{
+			snprintf(dname, 256, "%.*s", i + 1, fname);
+			nedgz_path_remove(dname);
+		}
+	}
+}
+
+// created is incremented for each directory which
+// did not exist
+static int nedgz_path_make(const char* fname, int* created)
+{
+	assert(fname);
+	assert(created);
+
+	// find the last directory
+	int len = strnlen(fname, 255);
+	while((len > 0) && (fname[len - 1] != '/'))
+	{
+		--len;
+	}
+
+	if(len == 0)
+	{
+		// no directories
+		return 1;
+	}
+
+	pthread_mutex_lock(&nedgz_path_mutex);
+
+	char dname[256];
+	snprintf(dname, 256, "%.*s", len, fname);
+	if(nedgz_path_find(dname))
+	{
+		// the common case
+		pthread_mutex_unlock(&nedgz_path_mutex);
+		return 1;
+	}
+
+	// create each directory in turn
+	int i;
+	int stale = 0;
+	for(i = 0; i < len; ++i)
+	{
+		if((fname[i] != '/') || (i == 0))
+		{
+			continue;
+		}
+
+		snprintf(dname, 256, "%.*s", i + 1, fname);
+		if(nedgz_path_find(dname))
+		{
+			continue;
+		}
+
+		if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+		{
+			if(errno == EEXIST)
+			{
+				// already exists
+			}
+			else if((errno == ENOENT) && (stale == 0))
+			{
+				// a remembered parent was removed so
+				// start again from the first directory
+				nedgz_path_forget(fname);
+				stale = 1;
+				i     = 0;
+				continue;
+			}
+			else
+			{
+				LOGE("mkdir %s failed", dname);
+				goto fail_mkdir;
+			}
+		}
+		else
+		{
+			++(*created);
+		}
+		nedgz_path_add(dname);
+	}
+
+	pthread_mutex_unlock(&nedgz_path_mutex);
+
+	// success
+	return 1;
+
+	// failure
+	fail_mkdir:
+		pthread_mutex_unlock(&nedgz_path_mutex);
+	return 0;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int nedgz_path_mkdir(const char* fname)
+{
+	assert(fname);
+	LOGD("debug fname=%s", fname);
+
+	int created = 0;
+	return nedgz_path_make(fname, &created);
+}
+
+int nedgz_path_retry(const char* fname)
+{
+	assert(fname);
+	LOGD("debug fname=%s", fname);
+
+	pthread_mutex_lock(&nedgz_path_mutex);
+	nedgz_path_forget(fname);
+	pthread_mutex_unlock(&nedgz_path_mutex);
+
+	// the write is only retried when a directory
+	// was removed since it was remembered
+	int created = 0;
+	if(nedgz_path_make(fname, &created) == 0)
+	{
+		return 0;
+	}
+
+	if(created)
+	{
+		LOGW("recreated directories for %s", fname);
+	}
+	return created ? 1 : 0;
+}
+
+FILE* nedgz_path_fopen(const char* fname, const char* mode)
+{
+	assert(fname);
+	assert(mode);
+	LOGD("debug fname=%s, mode=%s", fname, mode);
+
+	if(nedgz_path_mkdir(fname) == 0)
+	{
+		return NULL;
+	}
+
+	FILE* f = fopen(fname, mode);
+	if((f == NULL) && (errno == ENOENT) &&
+	   nedgz_path_retry(fname))
+	{
+		f = fopen(fname, mode);
+	}
+
+	return f;
+}
+
+void nedgz_path_reset(void)
+{
+	LOGD("debug");
+
+	pthread_mutex_lock(&nedgz_path_mutex);
+
+	int i;
+	for(i = 0; i < NEDGZ_PATH_BUCKETS; ++i)
+	{
+		nedgz_pathitem_t* item = nedgz_path_bucket[i];
+		while(item)
+		{
+			nedgz_pathitem_t* chain = item->chain;
+			free(item);
+			item = chain;
+		}
+		nedgz_path_bucket[i] = NULL;
+	}
+
+	pthread_mutex_unlock(&nedgz_path_mutex);
+}
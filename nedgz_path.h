@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef nedgz_path_H
+#define nedgz_path_H
+
+#include <stdio.h>
+
+// nedgz_path_mkdir creates each directory in fname which is
+// followed by a '/' (e.g. "ned/15/1_2.nedgz" creates ned and
+// ned/15 while "ned/15/" creates the same directories)
+//
+// directories which were created or found to exist are
+// remembered by a thread safe set so that repeated calls for
+// the same directory do not require a syscall
+//
+// a directory which is removed externally is still remembered
+// so writers which fail after nedgz_path_mkdir should call
+// nedgz_path_retry which forgets the directories of fname and
+// creates them again and returns 1 if any were missing (i.e.
+// the write should be retried once)
+//
+// nedgz_path_fopen creates the directories and opens fname
+// with a retry when fopen fails with ENOENT
+//
+// nedgz_path_reset forgets all of the remembered directories
+
+#define NEDGZ_PATH_BUCKETS 256
+
+int   nedgz_path_mkdir(const char* fname);
+int   nedgz_path_retry(const char* fname);
+FILE* nedgz_path_fopen(const char* fname, const char* mode);
+void  nedgz_path_reset(void);
+
+#endif
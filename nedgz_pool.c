@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include "nedgz_pool.h"
+
+#define LOG_TAG "nedgz"
+#include "nedgz_log.h"
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+nedgz_pool_t* nedgz_pool_new(int max_count)
+{
+	assert(max_count > 0);
+	LOGD("debug max_count=%i", max_count);
+
+	nedgz_pool_t* self = (nedgz_pool_t*) malloc(sizeof(nedgz_pool_t));
+	if(self == NULL)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->tiles = (nedgz_tile_t**)
+	              calloc(max_count, sizeof(nedgz_tile_t*));
+	if(self->tiles == NULL)
+	{
+		LOGE("calloc failed");
+		goto fail_tiles;
+	}
+
+	self->count     = 0;
+	self->max_count = max_count;
+
+	// success
+	return self;
+
+	// failure
+	fail_tiles:
+		free(self);
+	return NULL;
+}
+
+void nedgz_pool_delete(nedgz_pool_t** _self)
+{
+	assert(_self);
+
+	nedgz_pool_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug");
+
+		int i;
+		for(i = 0; i < self->count; ++i)
+		{
+			nedgz_tile_delete(&self->tiles[i]);
+		}
+		free(self->tiles);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+nedgz_tile_t* nedgz_pool_get(nedgz_pool_t* self,
+                             int x, int y, int zoom)
+{
+	assert(self);
+	LOGD("debug x=%i, y=%i, zoom=%i", x, y, zoom);
+
+	if(self->count == 0)
+	{
+		return nedgz_tile_newslab(x, y, zoom);
+	}
+
+	--self->count;
+	nedgz_tile_t* tile = self->tiles[self->count];
+	self->tiles[self->count] = NULL;
+	nedgz_tile_reset(tile, x, y, zoom);
+	return tile;
+}
+
+nedgz_tile_t* nedgz_pool_import(nedgz_pool_t* self,
+                                const char* base,
+                                int x, int y, int zoom)
+{
+	assert(self);
+	assert(base);
+	LOGD("debug base=%s, x=%i, y=%i, zoom=%i", base, x, y, zoom);
+
+	nedgz_tile_t* tile = nedgz_pool_get(self, x, y, zoom);
+	if(tile == NULL)
+	{
+		return NULL;
+	}
+
+	if(nedgz_tile_load(tile, base) == 0)
+	{
+		nedgz_pool_put(self, &tile);
+		return NULL;
+	}
+
+	return tile;
+}
+
+void nedgz_pool_put(nedgz_pool_t* self, nedgz_tile_t** _tile)
+{
+	assert(self);
+	assert(_tile);
+
+	nedgz_tile_t* tile = *_tile;
+	if(tile)
+	{
+		LOGD("debug");
+
+		if((tile->slab == NULL) ||
+		   (self->count == self->max_count))
+		{
+			nedgz_tile_delete(_tile);
+			return;
+		}
+
+		self->tiles[self->count] = tile;
+		++self->count;
+		*_tile = NULL;
+	}
+}
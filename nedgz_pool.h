@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef nedgz_pool_H
+#define nedgz_pool_H
+
+#include "nedgz_tile.h"
+
+// The pool recycles slab tiles so that batch tools may
+// process many tiles without allocating subtiles for each
+// one. Tiles returned by the pool must be returned with
+// nedgz_pool_put rather than nedgz_tile_delete. The pool
+// is not thread safe.
+typedef struct
+{
+	int            count;
+	int            max_count;
+	nedgz_tile_t** tiles;
+} nedgz_pool_t;
+
+nedgz_pool_t* nedgz_pool_new(int max_count);
+void          nedgz_pool_delete(nedgz_pool_t** _self);
+nedgz_tile_t* nedgz_pool_get(nedgz_pool_t* self,
+                             int x, int y, int zoom);
+nedgz_tile_t* nedgz_pool_import(nedgz_pool_t* self,
+                                const char* base,
+                                int x, int y, int zoom);
+void          nedgz_pool_put(nedgz_pool_t* self,
+                             nedgz_tile_t** _tile);
+
+#endif
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <pthread.h>
+#include "nedgz_profile.h"
+
+#define LOG_TAG "nedgz"
+#include "nedgz_log.h"
+
+#define NEDGZ_PROFILE_TYPE_TIMER   0
+#define NEDGZ_PROFILE_TYPE_COUNTER 1
+
+typedef struct
+{
+	char name[32];
+	int  type;
+
+	// updated atomically
+	unsigned long long count;
+	unsigned long long total;
+	unsigned long long min;
+	unsigned long long max;
+	unsigned long long hist[NEDGZ_PROFILE_BUCKETS];
+} nedgz_profiletimer_t;
+
+// the mutex protects registration while the timers are
+// updated with atomics so that the hot path is lock free
+static pthread_mutex_t      nedgz_profile_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int                  nedgz_profile_timer_count = 0;
+static nedgz_profiletimer_t nedgz_profile_timer[NEDGZ_PROFILE_TIMERS];
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static unsigned long long nedgz_profile_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return 1000000000ULL*((unsigned long long) ts.tv_sec) +
+	       (unsigned long long) ts.tv_nsec;
+}
+
+static void nedgz_profile_exit(void)
+{
+	nedgz_profile_report();
+}
+
+static int nedgz_profile_register(int* id, const char* name, int type)
+{
+	assert(id);
+	assert(name);
+
+	int i = __atomic_load_n(id, __ATOMIC_ACQUIRE);
+	if(i >= 0)
+	{
+		return i;
+	}
+
+	pthread_mutex_lock(&nedgz_profile_mutex);
+
+	// another call site may share the name
+	for(i = 0; i < nedgz_profile_timer_count; ++i)
+	{
+		if(strncmp(nedgz_profile_timer[i].name, name, 32) == 0)
+		{
+			goto done;
+		}
+	}
+
+	if(nedgz_profile_timer_count >= NEDGZ_PROFILE_TIMERS)
+	{
+		pthread_mutex_unlock(&nedgz_profile_mutex);
+		return -1;
+	}
+
+	if(nedgz_profile_timer_count == 0)
+	{
+		atexit(nedgz_profile_exit);
+	}
+
+	nedgz_profiletimer_t* timer = &nedgz_profile_timer[i];
+	memset(timer, 0, sizeof(nedgz_profiletimer_t));
+	snprintf(timer->name, 32, "%s", name);
+	timer->type = type;
+	timer->min  = (unsigned long long) -1;
+	__atomic_store_n(&nedgz_profile_timer_count, i + 1,
+	                 __ATOMIC_RELEASE);
+
+	done:
+	__atomic_store_n(id, i, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&nedgz_profile_mutex);
+	return i;
+}
+
+// upper bound of the bucket containing the percentile p
+static unsigned long long
+nedgz_profile_percentile(nedgz_profiletimer_t* timer,
+                         unsigned long long count, double p)
+{
+	assert(timer);
+
+	unsigned long long target = (unsigned long long)
+	                            (p*((double) count));
+	unsigned long long sum    = 0;
+	int b;
+	for(b = 0; b < NEDGZ_PROFILE_BUCKETS; ++b)
+	{
+		sum += __atomic_load_n(&timer->hist[b], __ATOMIC_RELAXED);
+		if(sum > target)
+		{
+			break;
+		}
+	}
+
+	if(b >= NEDGZ_PROFILE_BUCKETS)
+	{
+		b = NEDGZ_PROFILE_BUCKETS - 1;
+	}
+	return 1ULL << b;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+unsigned long long nedgz_profile_begin(int* id, const char* name)
+{
+	assert(id);
+	assert(name);
+
+	nedgz_profile_register(id, name, NEDGZ_PROFILE_TYPE_TIMER);
+	return nedgz_profile_time();
+}
+
+void nedgz_profile_end(int id, unsigned long long t0)
+{
+	if((id < 0) || (id >= NEDGZ_PROFILE_TIMERS))
+	{
+		return;
+	}
+
+	unsigned long long dt = nedgz_profile_time() - t0;
+
+	// bucket b contains latencies in [2^(b-1), 2^b) ns
+	int b = (dt == 0) ? 0 : 64 - __builtin_clzll(dt);
+	if(b >= NEDGZ_PROFILE_BUCKETS)
+	{
+		b = NEDGZ_PROFILE_BUCKETS - 1;
+	}
+
+	nedgz_profiletimer_t* timer = &nedgz_profile_timer[id];
+	__atomic_fetch_add(&timer->count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&timer->total, dt, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&timer->hist[b], 1, __ATOMIC_RELAXED);
+
+	unsigned long long v = __atomic_load_n(&timer->min, __ATOMIC_RELAXED);
+	while((dt < v) &&
+	      (__atomic_compare_exchange_n(&timer->min, &v, dt, 1,
+	                                   __ATOMIC_RELAXED,
+	                                   __ATOMIC_RELAXED) == 0))
+	{
+		// v was updated by the failed exchange
+	}
+
+	v = __atomic_load_n(&timer->max, __ATOMIC_RELAXED);
+	while((dt > v) &&
+	      (__atomic_compare_exchange_n(&timer->max, &v, dt, 1,
+	                                   __ATOMIC_RELAXED,
+	                                   __ATOMIC_RELAXED) == 0))
+	{
+		// v was updated by the failed exchange
+	}
+}
+
+void nedgz_profile_count(int* id, const char* name, long long n)
+{
+	assert(id);
+	assert(name);
+
+	int i = nedgz_profile_register(id, name,
+	                               NEDGZ_PROFILE_TYPE_COUNTER);
+	if(i < 0)
+	{
+		return;
+	}
+
+	nedgz_profiletimer_t* timer = &nedgz_profile_timer[i];
+	__atomic_fetch_add(&timer->count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&timer->total, (unsigned long long) n,
+	                   __ATOMIC_RELAXED);
+}
+
+void nedgz_profile_report(void)
+{
+	int count = __atomic_load_n(&nedgz_profile_timer_count,
+	                            __ATOMIC_ACQUIRE);
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		nedgz_profiletimer_t* timer = &nedgz_profile_timer[i];
+
+		unsigned long long n;
+		unsigned long long total;
+		n     = __atomic_load_n(&timer->count, __ATOMIC_RELAXED);
+		total = __atomic_load_n(&timer->total, __ATOMIC_RELAXED);
+		if(timer->type == NEDGZ_PROFILE_TYPE_COUNTER)
+		{
+			LOGI("profile %s: calls=%llu, total=%llu",
+			     timer->name, n, total);
+			continue;
+		}
+		else if(n == 0)
+		{
+			continue;
+		}
+
+		unsigned long long min;
+		unsigned long long max;
+		min = __atomic_load_n(&timer->min, __ATOMIC_RELAXED);
+		max = __atomic_load_n(&timer->max, __ATOMIC_RELAXED);
+		LOGI("profile %s: count=%llu, total=%0.3lfms, mean=%0.3lfus, "
+		     "min=%0.3lfus, p50<%0.3lfus, p90<%0.3lfus, p99<%0.3lfus, "
+		     "max=%0.3lfus",
+		     timer->name, n, ((double) total)/1.0E6,
+		     ((double) total)/((double) n)/1.0E3,
+		     ((double) min)/1.0E3,
+		     ((double) nedgz_profile_percentile(timer, n, 0.50))/1.0E3,
+		     ((double) nedgz_profile_percentile(timer, n, 0.90))/1.0E3,
+		     ((double) nedgz_profile_percentile(timer, n, 0.99))/1.0E3,
+		     ((double) max)/1.0E3);
+	}
+}
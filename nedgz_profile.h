@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef nedgz_profile_H
+#define nedgz_profile_H
+
+/***********************************************************
+* Profiling is compiled in when NEDGZ_PROFILE is defined   *
+* (e.g. make PROFILE=1) and otherwise the macros expand to *
+* nothing.                                                 *
+*                                                          *
+* NEDGZ_PROFILE_BEGIN(name) and NEDGZ_PROFILE_END(name)    *
+* must be paired in the same scope and record the latency  *
+* of the enclosed code in a log2 histogram. Every return,  *
+* goto or continue which leaves the enclosed code must     *
+* call NEDGZ_PROFILE_END first. Call sites which share a   *
+* name share a timer.                                      *
+*                                                          *
+* NEDGZ_PROFILE_COUNT(name, n) adds n to a counter.        *
+*                                                          *
+* The timers and counters are logged at exit.              *
+***********************************************************/
+
+#define NEDGZ_PROFILE_TIMERS  64
+#define NEDGZ_PROFILE_BUCKETS 48
+
+#ifdef NEDGZ_PROFILE
+	#define NEDGZ_PROFILE_BEGIN(name) \
+		static int nedgz_profile_id_##name = -1; \
+		unsigned long long nedgz_profile_t0_##name = \
+			nedgz_profile_begin(&nedgz_profile_id_##name, #name)
+	#define NEDGZ_PROFILE_END(name) \
+		nedgz_profile_end(nedgz_profile_id_##name, \
+		                  nedgz_profile_t0_##name)
+	#define NEDGZ_PROFILE_COUNT(name, n) \
+		do \
+		{ \
+			static int nedgz_profile_id = -1; \
+			nedgz_profile_count(&nedgz_profile_id, #name, n); \
+		} while(0)
+#else
+	#define NEDGZ_PROFILE_BEGIN(name)
+	#define NEDGZ_PROFILE_END(name)
+	#define NEDGZ_PROFILE_COUNT(name, n)
+#endif
+
+unsigned long long nedgz_profile_begin(int* id, const char* name);
+void               nedgz_profile_end(int id, unsigned long long t0);
+void               nedgz_profile_count(int* id, const char* name,
+                                       long long n);
+void               nedgz_profile_report(void);
+
+#endif
@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "nedgz_progress.h"
+
+#define LOG_TAG "nedgz"
+#include "nedgz_log.h"
+
+// weight of the newest sample in the moving average rate
+#define NEDGZ_PROGRESS_ALPHA 0.25
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static double nedgz_progress_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + ((double) ts.tv_nsec)/1.0E9;
+}
+
+static void nedgz_progress_hms(double t, char* s)
+{
+	assert(s);
+
+	if(t < 0.0)
+	{
+		snprintf(s, 32, "?");
+		return;
+	}
+
+	long long sec = (long long) t;
+	snprintf(s, 32, "%lli:%02i:%02i",
+	         sec/3600, (int) ((sec/60)%60), (int) (sec%60));
+}
+
+static void nedgz_progress_filesize(const char* fname, long long* bytes)
+{
+	assert(fname);
+	assert(bytes);
+
+	struct stat st;
+	if(stat(fname, &st) == 0)
+	{
+		*bytes += (long long) st.st_size;
+	}
+}
+
+// call with the mutex locked
+static void nedgz_progress_summary(nedgz_progress_t* self, double t)
+{
+	assert(self);
+
+	// update the moving average rate
+	int    items = self->done + self->skipped + self->failed;
+	double dt    = t - self->report_t;
+	if(dt > 0.0)
+	{
+		double rate = (double) (items - self->report_items)/dt;
+		if(self->report_items == 0)
+		{
+			self->rate = rate;
+		}
+		else
+		{
+			self->rate = NEDGZ_PROGRESS_ALPHA*rate +
+			             (1.0 - NEDGZ_PROGRESS_ALPHA)*self->rate;
+		}
+	}
+	self->report_t     = t;
+	self->report_items = items;
+
+	// the total may be an estimate
+	int remaining = self->total - items;
+	if(remaining < 0)
+	{
+		remaining = 0;
+	}
+
+	double eta = -1.0;
+	if((self->total > 0) && (remaining == 0))
+	{
+		eta = 0.0;
+	}
+	else if((self->total > 0) && (self->rate > 0.0))
+	{
+		eta = (double) remaining/self->rate;
+	}
+
+	char   elapsed[32];
+	char   remain[32];
+	double pct = 0.0;
+	if(self->total > 0)
+	{
+		pct = 100.0*((double) (self->total - remaining))/
+		      ((double) self->total);
+	}
+	nedgz_progress_hms(t - self->t0, elapsed);
+	nedgz_progress_hms(eta, remain);
+	LOGI("%s: %i/%i %0.1f%% skip=%i fail=%i rate=%0.1f/s "
+	     "read=%0.1fMB write=%0.1fMB elapsed=%s eta=%s",
+	     self->name, items, self->total, pct,
+	     self->skipped, self->failed, self->rate,
+	     ((double) self->bytes_read)/(1024.0*1024.0),
+	     ((double) self->bytes_written)/(1024.0*1024.0),
+	     elapsed, remain);
+
+	int i;
+	for(i = 0; i < self->stage_count; ++i)
+	{
+		nedgz_progressstage_t* stage = &self->stage[i];
+		LOGI("%s: stage=%s count=%i time=%0.3lfs",
+		     self->name, stage->name, stage->count, stage->elapsed);
+	}
+}
+
+// call with the mutex locked
+static void nedgz_progress_update(nedgz_progress_t* self)
+{
+	assert(self);
+
+	double t = nedgz_progress_time();
+	if(t - self->report_t >= self->interval)
+	{
+		nedgz_progress_summary(self, t);
+	}
+}
+
+static void nedgz_progress_export(nedgz_progress_t* self, double t)
+{
+	assert(self);
+	LOGD("debug stats=%s", self->stats);
+
+	FILE* f = fopen(self->stats, "w");
+	if(f == NULL)
+	{
+		LOGE("fopen %s failed", self->stats);
+		return;
+	}
+
+	fprintf(f, "{\n");
+	fprintf(f, "\t\"name\": \"%s\",\n", self->name);
+	fprintf(f, "\t\"total\": %i,\n", self->total);
+	fprintf(f, "\t\"done\": %i,\n", self->done);
+	fprintf(f, "\t\"skipped\": %i,\n", self->skipped);
+	fprintf(f, "\t\"failed\": %i,\n", self->failed);
+	fprintf(f, "\t\"bytes_read\": %lli,\n", self->bytes_read);
+	fprintf(f, "\t\"bytes_written\": %lli,\n", self->bytes_written);
+	fprintf(f, "\t\"elapsed\": %0.3lf,\n", t - self->t0);
+	fprintf(f, "\t\"stages\": [");
+	int i;
+	for(i = 0; i < self->stage_count; ++i)
+	{
+		nedgz_progressstage_t* stage = &self->stage[i];
+		fprintf(f, "%s\n\t\t{ \"name\": \"%s\", \"count\": %i, \"elapsed\": %0.3lf }",
+		        (i == 0) ? "" : ",",
+		        stage->name, stage->count, stage->elapsed);
+	}
+	fprintf(f, "%s]\n", (self->stage_count == 0) ? "" : "\n\t");
+	fprintf(f, "}\n");
+	fclose(f);
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+nedgz_progress_t* nedgz_progress_new(const char* name, int total)
+{
+	assert(name);
+	LOGD("debug name=%s, total=%i", name, total);
+
+	nedgz_progress_t* self = (nedgz_progress_t*)
+	                         malloc(sizeof(nedgz_progress_t));
+	if(self == NULL)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	if(pthread_mutex_init(&self->mutex, NULL) != 0)
+	{
+		LOGE("pthread_mutex_init failed");
+		goto fail_mutex;
+	}
+
+	snprintf(self->name, 64, "%s", name);
+	self->stats[0]      = '\0';
+	self->total         = total;
+	self->done          = 0;
+	self->skipped       = 0;
+	self->failed        = 0;
+	self->bytes_read    = 0;
+	self->bytes_written = 0;
+	self->t0            = nedgz_progress_time();
+	self->interval      = NEDGZ_PROGRESS_INTERVAL;
+	self->report_t      = self->t0;
+	self->report_items  = 0;
+	self->rate          = 0.0;
+	self->stage_count   = 0;
+
+	const char* s;
+	if((s = getenv("NEDGZ_PROGRESS_INTERVAL")))
+	{
+		self->interval = strtod(s, NULL);
+	}
+	if((s = getenv("NEDGZ_PROGRESS_STATS")))
+	{
+		snprintf(self->stats, 256, "%s", s);
+	}
+
+	// success
+	return self;
+
+	// failure
+	fail_mutex:
+		free(self);
+	return NULL;
+}
+
+void nedgz_progress_delete(nedgz_progress_t** _self)
+{
+	assert(_self);
+
+	nedgz_progress_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug");
+
+		double t = nedgz_progress_time();
+		nedgz_progress_summary(self, t);
+		if(self->stats[0] != '\0')
+		{
+			nedgz_progress_export(self, t);
+		}
+
+		pthread_mutex_destroy(&self->mutex);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+void nedgz_progress_total(nedgz_progress_t* self, int total)
+{
+	assert(self);
+	LOGD("debug total=%i", total);
+
+	pthread_mutex_lock(&self->mutex);
+	self->total = total;
+	pthread_mutex_unlock(&self->mutex);
+}
+
+void nedgz_progress_statsfile(nedgz_progress_t* self,
+                              const char* fname)
+{
+	assert(self);
+	assert(fname);
+	LOGD("debug fname=%s", fname);
+
+	pthread_mutex_lock(&self->mutex);
+	snprintf(self->stats, 256, "%s", fname);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+void nedgz_progress_done(nedgz_progress_t* self, int count)
+{
+	assert(self);
+	LOGD("debug count=%i", count);
+
+	pthread_mutex_lock(&self->mutex);
+	self->done += count;
+	nedgz_progress_update(self);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+void nedgz_progress_skip(nedgz_progress_t* self, int count)
+{
+	assert(self);
+	LOGD("debug count=%i", count);
+
+	pthread_mutex_lock(&self->mutex);
+	self->skipped += count;
+	nedgz_progress_update(self);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+void nedgz_progress_fail(nedgz_progress_t* self, int count)
+{
+	assert(self);
+	LOGD("debug count=%i", count);
+
+	pthread_mutex_lock(&self->mutex);
+	self->failed += count;
+	nedgz_progress_update(self);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+void nedgz_progress_read(nedgz_progress_t* self, long long bytes)
+{
+	assert(self);
+	LOGD("debug bytes=%lli", bytes);
+
+	pthread_mutex_lock(&self->mutex);
+	self->bytes_read += bytes;
+	pthread_mutex_unlock(&self->mutex);
+}
+
+void nedgz_progress_write(nedgz_progress_t* self, long long bytes)
+{
+	assert(self);
+	LOGD("debug bytes=%lli", bytes);
+
+	pthread_mutex_lock(&self->mutex);
+	self->bytes_written += bytes;
+	pthread_mutex_unlock(&self->mutex);
+}
+
+void nedgz_progress_readfile(nedgz_progress_t* self,
+                             const char* fname)
+{
+	assert(self);
+	assert(fname);
+	LOGD("debug fname=%s", fname);
+
+	long long bytes = 0;
+	nedgz_progress_filesize(fname, &bytes);
+	nedgz_progress_read(self, bytes);
+}
+
+void nedgz_progress_writefile(nedgz_progress_t* self,
+                              const char* fname)
+{
+	assert(self);
+	assert(fname);
+	LOGD("debug fname=%s", fname);
+
+	long long bytes = 0;
+	nedgz_progress_filesize(fname, &bytes);
+	nedgz_progress_write(self, bytes);
+}
+
+int nedgz_progress_stage(nedgz_progress_t* self, const char* name)
+{
+	assert(self);
+	assert(name);
+	LOGD("debug name=%s", name);
+
+	pthread_mutex_lock(&self->mutex);
+
+	// find an existing stage
+	int i;
+	for(i = 0; i < self->stage_count; ++i)
+	{
+		if(strncmp(self->stage[i].name, name, 32) == 0)
+		{
+			pthread_mutex_unlock(&self->mutex);
+			return i;
+		}
+	}
+
+	if(self->stage_count >= NEDGZ_PROGRESS_STAGES)
+	{
+		pthread_mutex_unlock(&self->mutex);
+		LOGE("invalid stage_count=%i", self->stage_count);
+		return -1;
+	}
+
+	nedgz_progressstage_t* stage = &self->stage[i];
+	snprintf(stage->name, 32, "%s", name);
+	stage->count   = 0;
+	stage->elapsed = 0.0;
+	++self->stage_count;
+
+	pthread_mutex_unlock(&self->mutex);
+	return i;
+}
+
+double nedgz_progress_begin(nedgz_progress_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	return nedgz_progress_time();
+}
+
+void nedgz_progress_end(nedgz_progress_t* self, int stage, double t0)
+{
+	assert(self);
+	LOGD("debug stage=%i, t0=%lf", stage, t0);
+
+	if((stage < 0) || (stage >= NEDGZ_PROGRESS_STAGES))
+	{
+		return;
+	}
+
+	double t = nedgz_progress_time();
+	pthread_mutex_lock(&self->mutex);
+	self->stage[stage].count   += 1;
+	self->stage[stage].elapsed += t - t0;
+	pthread_mutex_unlock(&self->mutex);
+}
+
+void nedgz_progress_report(nedgz_progress_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	pthread_mutex_lock(&self->mutex);
+	nedgz_progress_summary(self, nedgz_progress_time());
+	pthread_mutex_unlock(&self->mutex);
+}
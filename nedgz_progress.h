@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef nedgz_progress_H
+#define nedgz_progress_H
+
+#include <pthread.h>
+
+#define NEDGZ_PROGRESS_STAGES   8
+#define NEDGZ_PROGRESS_INTERVAL 10.0
+
+typedef struct
+{
+	char   name[32];
+	int    count;
+	double elapsed;
+} nedgz_progressstage_t;
+
+// The progress tracks items, bytes and the time spent in
+// each stage of a batch job. A summary with the throughput
+// and a moving average ETA is logged every interval seconds
+// and the totals are written as JSON to the stats file
+// (if any) by nedgz_progress_delete. The interval and stats
+// file default to the NEDGZ_PROGRESS_INTERVAL and
+// NEDGZ_PROGRESS_STATS environment variables. The progress
+// is thread safe.
+typedef struct
+{
+	char   name[64];
+	char   stats[256];
+	int    total;
+	int    done;
+	int    skipped;
+	int    failed;
+	long long bytes_read;
+	long long bytes_written;
+
+	// timing
+	double t0;
+	double interval;
+	double report_t;
+	int    report_items;
+	double rate;
+
+	int                   stage_count;
+	nedgz_progressstage_t stage[NEDGZ_PROGRESS_STAGES];
+
+	pthread_mutex_t mutex;
+} nedgz_progress_t;
+
+nedgz_progress_t* nedgz_progress_new(const char* name, int total);
+void              nedgz_progress_delete(nedgz_progress_t** _self);
+void              nedgz_progress_total(nedgz_progress_t* self,
+                                       int total);
+void              nedgz_progress_statsfile(nedgz_progress_t* self,
+                                           const char* fname);
+void              nedgz_progress_done(nedgz_progress_t* self,
+                                      int count);
+void              nedgz_progress_skip(nedgz_progress_t* self,
+                                      int count);
+void              nedgz_progress_fail(nedgz_progress_t* self,
+                                      int count);
+void              nedgz_progress_read(nedgz_progress_t* self,
+                                      long long bytes);
+void              nedgz_progress_write(nedgz_progress_t* self,
+                                       long long bytes);
+void              nedgz_progress_readfile(nedgz_progress_t* self,
+                                          const char* fname);
+void              nedgz_progress_writefile(nedgz_progress_t* self,
+                                           const char* fname);
+int               nedgz_progress_stage(nedgz_progress_t* self,
+                                       const char* name);
+double            nedgz_progress_begin(nedgz_progress_t* self);
+void              nedgz_progress_end(nedgz_progress_t* self,
+                                     int stage, double t0);
+void              nedgz_progress_report(nedgz_progress_t* self);
+
+#endif
@@ -24,8 +24,12 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
+#include <math.h>
 #include "nedgz_tile.h"
+#include "nedgz_util.h"
+#include "nedgz_profile.h"
 #include "nedgz_scene.h"
+#include "nedgz_scenearray.h"
 
 #define LOG_TAG "nedgz"
 #include "nedgz_log.h"
@@ -187,6 +191,218 @@ static int nedgz_scene_importf(nedgz_scene_t** _self, FILE* f)
 	return 1;
 }
 
+static nedgz_scene_t* nedgz_scene_child(nedgz_scene_t* self, int q)
+{
+	assert(self);
+
+	if(q == 0)
+	{
+		return self->tl;
+	}
+	else if(q == 1)
+	{
+		return self->tr;
+	}
+	else if(q == 2)
+	{
+		return self->bl;
+	}
+	return self->br;
+}
+
+// the number of nedgz tile units per tile of the layout
+static float nedgz_scene_scale(int layout)
+{
+	assert((layout == NEDGZ_SCENE_NED) ||
+	       (layout == NEDGZ_SCENE_OSM));
+
+	if(layout == NEDGZ_SCENE_OSM)
+	{
+		return 1.0f/((float) NEDGZ_SUBTILE_COUNT);
+	}
+	return 1.0f;
+}
+
+// range is the inclusive tile range x0, y0, x1, y1 at zoom
+// which intersects the box or returns 0 if the box is empty
+static int nedgz_scene_range(int layout, int zoom,
+                             double latT, double lonL,
+                             double latB, double lonR,
+                             int* range)
+{
+	assert(range);
+	LOGD("debug zoom=%i, latT=%lf, lonL=%lf, latB=%lf, lonR=%lf",
+	     zoom, latT, lonL, latB, lonR);
+
+	if((zoom < 0) || (zoom > NEDGZ_SCENE_MAXZOOM) ||
+	   (latT < latB) || (lonR < lonL))
+	{
+		return 0;
+	}
+
+	float x0f;
+	float y0f;
+	float x1f;
+	float y1f;
+	nedgz_scene_coord2tile(layout, latT, lonL, zoom, &x0f, &y0f);
+	nedgz_scene_coord2tile(layout, latB, lonR, zoom, &x1f, &y1f);
+
+	// boxes which end on a tile edge do not intersect
+	// the next tile
+	int n = nedgz_scene_tiles(layout, zoom);
+	range[0] = (int) floor(x0f);
+	range[1] = (int) floor(y0f);
+	range[2] = (int) ceil(x1f) - 1;
+	range[3] = (int) ceil(y1f) - 1;
+	if(range[2] < range[0])
+	{
+		range[2] = range[0];
+	}
+	if(range[3] < range[1])
+	{
+		range[3] = range[1];
+	}
+
+	if((range[0] >= n) || (range[1] >= n) ||
+	   (range[2] < 0)  || (range[3] < 0))
+	{
+		return 0;
+	}
+
+	range[0] = (range[0] < 0) ? 0 : range[0];
+	range[1] = (range[1] < 0) ? 0 : range[1];
+	range[2] = (range[2] >= n) ? n - 1 : range[2];
+	range[3] = (range[3] >= n) ? n - 1 : range[3];
+
+	return 1;
+}
+
+// 0 when x,y,zoom does not intersect the range at qzoom,
+// 1 when it intersects and 2 when it is covered
+static int nedgz_scene_overlap(int x, int y, int zoom,
+                               int qzoom, const int* range)
+{
+	assert(range);
+
+	int s  = qzoom - zoom;
+	int x0 = x << s;
+	int y0 = y << s;
+	int x1 = ((x + 1) << s) - 1;
+	int y1 = ((y + 1) << s) - 1;
+	if((x0 > range[2]) || (x1 < range[0]) ||
+	   (y0 > range[3]) || (y1 < range[1]))
+	{
+		return 0;
+	}
+
+	if((x0 >= range[0]) && (x1 <= range[2]) &&
+	   (y0 >= range[1]) && (y1 <= range[3]))
+	{
+		return 2;
+	}
+
+	return 1;
+}
+
+static int nedgz_scene_boxnode(nedgz_scene_t* self,
+                               int x, int y, int zoom,
+                               int qzoom, const int* range,
+                               nedgz_scene_query_fn query_fn,
+                               void* priv, int* count)
+{
+	// self may be NULL
+	assert(range);
+	assert(query_fn);
+	assert(count);
+
+	if((self == NULL) ||
+	   (nedgz_scene_overlap(x, y, zoom, qzoom, range) == 0))
+	{
+		return 1;
+	}
+
+	if(zoom == qzoom)
+	{
+		if(self->exists)
+		{
+			if(query_fn(priv, self, x, y, zoom) == 0)
+			{
+				return 0;
+			}
+			++(*count);
+		}
+		return 1;
+	}
+
+	int q;
+	for(q = 0; q < 4; ++q)
+	{
+		if(nedgz_scene_boxnode(nedgz_scene_child(self, q),
+		                       2*x + (q & 1), 2*y + (q >> 1),
+		                       zoom + 1, qzoom, range,
+		                       query_fn, priv, count) == 0)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static void nedgz_scene_boundsnode(nedgz_scene_t* self,
+                                   int x, int y, int zoom,
+                                   int qzoom, const int* range,
+                                   short* min, short* max)
+{
+	// self may be NULL
+	assert(range);
+	assert(min);
+	assert(max);
+
+	if(self == NULL)
+	{
+		return;
+	}
+
+	int overlap = nedgz_scene_overlap(x, y, zoom, qzoom, range);
+	if(overlap == 0)
+	{
+		return;
+	}
+
+	// the node min/max includes the higher LOD nodes so
+	// covered nodes and leaves are not traversed further
+	if((overlap == 2) || (zoom == qzoom) ||
+	   ((self->tl == NULL) && (self->tr == NULL) &&
+	    (self->bl == NULL) && (self->br == NULL)))
+	{
+		if((self->min == NEDGZ_NODATA) ||
+		   (self->max == NEDGZ_NODATA))
+		{
+			return;
+		}
+
+		if((*min == NEDGZ_NODATA) || (self->min < *min))
+		{
+			*min = self->min;
+		}
+
+		if((*max == NEDGZ_NODATA) || (self->max > *max))
+		{
+			*max = self->max;
+		}
+		return;
+	}
+
+	int q;
+	for(q = 0; q < 4; ++q)
+	{
+		nedgz_scene_boundsnode(nedgz_scene_child(self, q),
+		                       2*x + (q & 1), 2*y + (q >> 1),
+		                       zoom + 1, qzoom, range, min, max);
+	}
+}
+
 /***********************************************************
 * public                                                   *
 ***********************************************************/
@@ -237,12 +453,33 @@ nedgz_scene_t* nedgz_scene_import(const char* fname)
 	assert(fname);
 	LOGD("debug fname=%s", fname);
 
+	NEDGZ_PROFILE_BEGIN(scene_import);
 	FILE* f = fopen(fname, "r");
 	if(f == NULL)
 	{
 		LOGE("fopen %s failed", fname);
-		return NULL;
+		goto fail_fopen;
+	}
+
+	// v2 files are converted from the scene array
+	int magic = 0;
+	if((fread((void*) &magic, sizeof(int), 1, f) == 1) &&
+	   (magic == NEDGZ_SCENEARRAY_MAGIC))
+	{
+		fclose(f);
+
+		nedgz_scenearray_t* array = nedgz_scenearray_import(fname);
+		if(array == NULL)
+		{
+			goto fail_array;
+		}
+
+		nedgz_scene_t* self = nedgz_scenearray_tree(array);
+		nedgz_scenearray_delete(&array);
+		NEDGZ_PROFILE_END(scene_import);
+		return self;
 	}
+	rewind(f);
 
 	nedgz_scene_t* self = NULL;
 	if(nedgz_scene_importf(&self, f) == 0)
@@ -251,6 +488,7 @@ nedgz_scene_t* nedgz_scene_import(const char* fname)
 	}
 
 	fclose(f);
+	NEDGZ_PROFILE_END(scene_import);
 
 	// success
 	return self;
@@ -259,19 +497,209 @@ nedgz_scene_t* nedgz_scene_import(const char* fname)
 	fail_importf:
 		nedgz_scene_delete(&self);
 		fclose(f);
+	fail_array:
+	fail_fopen:
+		NEDGZ_PROFILE_END(scene_import);
 	return NULL;
 }
 
 int nedgz_scene_export(nedgz_scene_t* self, const char* fname)
 {
+	NEDGZ_PROFILE_BEGIN(scene_export);
 	FILE* f = fopen(fname, "w");
 	if(f == NULL)
 	{
 		LOGE("fopen %s failed", fname);
+		NEDGZ_PROFILE_END(scene_export);
 		return 0;
 	}
 
 	int ret = nedgz_scene_exportf(self, f);
 	fclose(f);
+	NEDGZ_PROFILE_END(scene_export);
 	return ret;
 }
+
+int nedgz_scene_tiles(int layout, int zoom)
+{
+	assert((layout == NEDGZ_SCENE_NED) ||
+	       (layout == NEDGZ_SCENE_OSM));
+	LOGD("debug layout=%i, zoom=%i", layout, zoom);
+
+	if(layout == NEDGZ_SCENE_OSM)
+	{
+		return 1 << zoom;
+	}
+
+	int n = (1 << zoom)/NEDGZ_SUBTILE_COUNT;
+	return (n > 0) ? n : 1;
+}
+
+void nedgz_scene_tile2coord(int layout,
+                            float x, float y, int zoom,
+                            double* lat, double* lon)
+{
+	assert(lat);
+	assert(lon);
+	LOGD("debug layout=%i, x=%f, y=%f, zoom=%i", layout, x, y, zoom);
+
+	float s = nedgz_scene_scale(layout);
+	nedgz_tile2coord(s*x, s*y, zoom, lat, lon);
+}
+
+void nedgz_scene_coord2tile(int layout,
+                            double lat, double lon,
+                            int zoom,
+                            float* x, float* y)
+{
+	assert(x);
+	assert(y);
+	LOGD("debug layout=%i, lat=%lf, lon=%lf, zoom=%i",
+	     layout, lat, lon, zoom);
+
+	float s = nedgz_scene_scale(layout);
+	nedgz_coord2tile(lat, lon, zoom, x, y);
+	*x /= s;
+	*y /= s;
+}
+
+nedgz_scene_t* nedgz_scene_find(nedgz_scene_t* self,
+                                int x, int y, int zoom)
+{
+	assert(self);
+	LOGD("debug x=%i, y=%i, zoom=%i", x, y, zoom);
+
+	// the osm layout has the most tiles and tiles beyond
+	// the ned layout have no path in a ned scene graph
+	if((zoom < 0) || (zoom > NEDGZ_SCENE_MAXZOOM) ||
+	   (x < 0) || (y < 0) ||
+	   (x >= nedgz_scene_tiles(NEDGZ_SCENE_OSM, zoom)) ||
+	   (y >= nedgz_scene_tiles(NEDGZ_SCENE_OSM, zoom)))
+	{
+		return NULL;
+	}
+
+	// bit l of x,y selects the child at zoom - l
+	nedgz_scene_t* node = self;
+	int            l;
+	for(l = zoom - 1; node && (l >= 0); --l)
+	{
+		node = nedgz_scene_child(node, ((x >> l) & 1) |
+		                               (((y >> l) & 1) << 1));
+	}
+
+	return node;
+}
+
+int nedgz_scene_exists(nedgz_scene_t* self,
+                       int x, int y, int zoom)
+{
+	assert(self);
+	LOGD("debug x=%i, y=%i, zoom=%i", x, y, zoom);
+
+	nedgz_scene_t* node = nedgz_scene_find(self, x, y, zoom);
+	return node ? node->exists : 0;
+}
+
+int nedgz_scene_lod(nedgz_scene_t* self, int layout,
+                    double lat, double lon,
+                    int max_zoom,
+                    int* x, int* y)
+{
+	assert(self);
+	assert(x);
+	assert(y);
+	LOGD("debug lat=%lf, lon=%lf, max_zoom=%i", lat, lon, max_zoom);
+
+	int range[4];
+	if(nedgz_scene_range(layout, max_zoom,
+	                     lat, lon, lat, lon, range) == 0)
+	{
+		return -1;
+	}
+
+	// descend along the path to the tile at max_zoom
+	int            lod  = -1;
+	int            zoom = 0;
+	nedgz_scene_t* node = self;
+	while(node)
+	{
+		if(node->exists)
+		{
+			lod = zoom;
+		}
+
+		if(zoom == max_zoom)
+		{
+			break;
+		}
+
+		int l = max_zoom - zoom - 1;
+		node = nedgz_scene_child(node, ((range[0] >> l) & 1) |
+		                               (((range[1] >> l) & 1) << 1));
+		++zoom;
+	}
+
+	if(lod >= 0)
+	{
+		*x = range[0] >> (max_zoom - lod);
+		*y = range[1] >> (max_zoom - lod);
+	}
+
+	return lod;
+}
+
+int nedgz_scene_box(nedgz_scene_t* self, int layout, int zoom,
+                    double latT, double lonL,
+                    double latB, double lonR,
+                    nedgz_scene_query_fn query_fn,
+                    void* priv)
+{
+	// priv may be NULL
+	assert(self);
+	assert(query_fn);
+	LOGD("debug zoom=%i, latT=%lf, lonL=%lf, latB=%lf, lonR=%lf",
+	     zoom, latT, lonL, latB, lonR);
+
+	int range[4];
+	if(nedgz_scene_range(layout, zoom,
+	                     latT, lonL, latB, lonR, range) == 0)
+	{
+		return 0;
+	}
+
+	int count = 0;
+	if(nedgz_scene_boxnode(self, 0, 0, 0, zoom, range,
+	                       query_fn, priv, &count) == 0)
+	{
+		return -1;
+	}
+
+	return count;
+}
+
+int nedgz_scene_bounds(nedgz_scene_t* self, int layout, int zoom,
+                       double latT, double lonL,
+                       double latB, double lonR,
+                       short* min, short* max)
+{
+	assert(self);
+	assert(min);
+	assert(max);
+	LOGD("debug zoom=%i, latT=%lf, lonL=%lf, latB=%lf, lonR=%lf",
+	     zoom, latT, lonL, latB, lonR);
+
+	*min = NEDGZ_NODATA;
+	*max = NEDGZ_NODATA;
+
+	int range[4];
+	if(nedgz_scene_range(layout, zoom,
+	                     latT, lonL, latB, lonR, range) == 0)
+	{
+		return 0;
+	}
+
+	nedgz_scene_boundsnode(self, 0, 0, 0, zoom, range, min, max);
+
+	return (*min == NEDGZ_NODATA) ? 0 : 1;
+}
@@ -42,9 +42,69 @@ typedef struct nedgz_scene_s
 	short max;
 } nedgz_scene_t;
 
+// the root of the scene graph is tile 0,0 at zoom 0 and
+// the children of x,y,zoom are 2*x + (0|1), 2*y + (0|1) at
+// zoom + 1 so that the path to a tile is given by the bits
+// of x,y and queries descend without floating point math
+//
+// the layout gives the size of the tiles in a scene graph
+// which nedsg builds for ned and osm/bluemarble tiles
+// NEDGZ_SCENE_NED: nedgz tiles where 2^zoom/8 tiles span
+//                  the world (i.e. 8x8 osm tiles)
+// NEDGZ_SCENE_OSM: osm/bluemarble tiles where 2^zoom tiles
+//                  span the world
+//
+// nedgz_scene_find returns the node for a tile (or NULL)
+// which may exist or be an interior node of the path and
+// does not depend on the layout
+//
+// nedgz_scene_lod returns the deepest zoom <= max_zoom of an
+// existing tile which contains lat,lon (or -1)
+//
+// nedgz_scene_box calls query_fn for each existing tile at
+// zoom which intersects the box and returns the number of
+// tiles or -1 if query_fn returned 0
+//
+// nedgz_scene_bounds returns the min/max height of the box
+// from the coarsest nodes at or above zoom which cover it
+#define NEDGZ_SCENE_MAXZOOM 24
+#define NEDGZ_SCENE_NED     0
+#define NEDGZ_SCENE_OSM     1
+
+typedef int (*nedgz_scene_query_fn)(void* priv,
+                                    nedgz_scene_t* node,
+                                    int x, int y, int zoom);
+
 nedgz_scene_t* nedgz_scene_new(void);
 void           nedgz_scene_delete(nedgz_scene_t** _self);
 nedgz_scene_t* nedgz_scene_import(const char* fname);
 int            nedgz_scene_export(nedgz_scene_t* self, const char* fname);
+int            nedgz_scene_tiles(int layout, int zoom);
+void           nedgz_scene_tile2coord(int layout,
+                                      float x, float y, int zoom,
+                                      double* lat, double* lon);
+void           nedgz_scene_coord2tile(int layout,
+                                      double lat, double lon,
+                                      int zoom,
+                                      float* x, float* y);
+nedgz_scene_t* nedgz_scene_find(nedgz_scene_t* self,
+                                int x, int y, int zoom);
+int            nedgz_scene_exists(nedgz_scene_t* self,
+                                  int x, int y, int zoom);
+int            nedgz_scene_lod(nedgz_scene_t* self, int layout,
+                               double lat, double lon,
+                               int max_zoom,
+                               int* x, int* y);
+int            nedgz_scene_box(nedgz_scene_t* self, int layout,
+                               int zoom,
+                               double latT, double lonL,
+                               double latB, double lonR,
+                               nedgz_scene_query_fn query_fn,
+                               void* priv);
+int            nedgz_scene_bounds(nedgz_scene_t* self, int layout,
+                                  int zoom,
+                                  double latT, double lonL,
+                                  double latB, double lonR,
+                                  short* min, short* max);
 
 #endif
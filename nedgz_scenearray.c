@@ -0,0 +1,468 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "nedgz_profile.h"
+#include "nedgz_scenearray.h"
+
+#define LOG_TAG "nedgz"
+#include "nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+typedef struct
+{
+	int idx;
+	int x;
+	int y;
+	int zoom;
+} nedgz_scenearray_entry_t;
+
+static int nedgz_scenearray_count(nedgz_scene_t* scene)
+{
+	// scene may be NULL
+	if(scene == NULL)
+	{
+		return 0;
+	}
+
+	return 1 + nedgz_scenearray_count(scene->tl) +
+	       nedgz_scenearray_count(scene->tr) +
+	       nedgz_scenearray_count(scene->bl) +
+	       nedgz_scenearray_count(scene->br);
+}
+
+static nedgz_scene_t*
+nedgz_scenearray_treenode(nedgz_scenearray_t* self, int idx)
+{
+	assert(self);
+	assert(idx >= 0);
+	assert(idx < self->count);
+	LOGD("debug idx=%i", idx);
+
+	const nedgz_scenenode_t* node  = &self->node[idx];
+	nedgz_scene_t*           scene = nedgz_scene_new();
+	if(scene == NULL)
+	{
+		return NULL;
+	}
+
+	scene->exists = (node->mask & NEDGZ_SCENENODE_EXISTS) ? 1 : 0;
+	scene->fsize  = node->fsize;
+	scene->min    = node->min;
+	scene->max    = node->max;
+
+	nedgz_scene_t** child[4] =
+	{
+		&scene->tl,
+		&scene->tr,
+		&scene->bl,
+		&scene->br,
+	};
+
+	int q;
+	for(q = 0; q < 4; ++q)
+	{
+		int c = nedgz_scenearray_child(self, idx, q);
+		if(c < 0)
+		{
+			continue;
+		}
+
+		*child[q] = nedgz_scenearray_treenode(self, c);
+		if(*child[q] == NULL)
+		{
+			nedgz_scene_delete(&scene);
+			return NULL;
+		}
+	}
+
+	return scene;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+nedgz_scenearray_t* nedgz_scenearray_new(nedgz_scene_t* scene)
+{
+	assert(scene);
+	LOGD("debug");
+
+	nedgz_scenearray_t* self = (nedgz_scenearray_t*)
+	                           malloc(sizeof(nedgz_scenearray_t));
+	if(self == NULL)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->count = nedgz_scenearray_count(scene);
+	self->size  = 0;
+	self->map   = NULL;
+
+	nedgz_scenenode_t* nodes = (nedgz_scenenode_t*)
+	                           malloc(self->count*sizeof(nedgz_scenenode_t));
+	if(nodes == NULL)
+	{
+		LOGE("malloc failed");
+		goto fail_node;
+	}
+	self->node = nodes;
+
+	// the node array doubles as the breadth-first queue
+	// where tree[idx] is the scene for node[idx]
+	nedgz_scene_t** tree = (nedgz_scene_t**)
+	                       malloc(self->count*sizeof(nedgz_scene_t*));
+	if(tree == NULL)
+	{
+		LOGE("malloc failed");
+		goto fail_tree;
+	}
+
+	tree[0] = scene;
+
+	int idx;
+	int tail = 1;
+	for(idx = 0; idx < self->count; ++idx)
+	{
+		nedgz_scene_t*     s    = tree[idx];
+		nedgz_scenenode_t* node = &nodes[idx];
+		nedgz_scene_t*     child[4] =
+		{
+			s->tl,
+			s->tr,
+			s->bl,
+			s->br,
+		};
+
+		node->child = 0;
+		node->fsize = s->fsize;
+		node->min   = s->min;
+		node->max   = s->max;
+		node->mask  = s->exists ? NEDGZ_SCENENODE_EXISTS : 0;
+		node->pad   = 0;
+
+		int q;
+		for(q = 0; q < 4; ++q)
+		{
+			if(child[q] == NULL)
+			{
+				continue;
+			}
+
+			if(node->child == 0)
+			{
+				node->child = tail;
+			}
+			node->mask   |= (unsigned short) (1 << q);
+			tree[tail++]  = child[q];
+		}
+	}
+	free(tree);
+
+	// success
+	return self;
+
+	// failure
+	fail_tree:
+		free(nodes);
+	fail_node:
+		free(self);
+	return NULL;
+}
+
+void nedgz_scenearray_delete(nedgz_scenearray_t** _self)
+{
+	assert(_self);
+
+	nedgz_scenearray_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug");
+
+		if(self->map)
+		{
+			munmap((void*) self->map, self->size);
+		}
+		else
+		{
+			free((void*) self->node);
+		}
+		free(self);
+		*_self = NULL;
+	}
+}
+
+nedgz_scenearray_t* nedgz_scenearray_import(const char* fname)
+{
+	assert(fname);
+	LOGD("debug fname=%s", fname);
+
+	NEDGZ_PROFILE_BEGIN(scenearray_import);
+	int fd = open(fname, O_RDONLY);
+	if(fd == -1)
+	{
+		LOGE("open %s failed", fname);
+		goto fail_open;
+	}
+
+	// v1 files are converted from the scene graph but files
+	// with the v2 magic must not fall back since
+	// nedgz_scene_import would convert them from the array
+	int     header[4] = { 0, 0, 0, 0 };
+	ssize_t bytes     = read(fd, (void*) header, sizeof(header));
+	if((bytes < (ssize_t) sizeof(int)) ||
+	   (header[0] != NEDGZ_SCENEARRAY_MAGIC))
+	{
+		close(fd);
+
+		nedgz_scene_t* scene = nedgz_scene_import(fname);
+		if(scene == NULL)
+		{
+			goto fail_scene;
+		}
+
+		nedgz_scenearray_t* self = nedgz_scenearray_new(scene);
+		nedgz_scene_delete(&scene);
+		NEDGZ_PROFILE_END(scenearray_import);
+		return self;
+	}
+
+	struct stat st;
+	if((bytes != (ssize_t) sizeof(header)) ||
+	   (fstat(fd, &st) == -1))
+	{
+		LOGE("invalid header %s", fname);
+		goto fail_header;
+	}
+
+	if((header[1] != NEDGZ_SCENEARRAY_VERSION) ||
+	   (header[2] <= 0) ||
+	   (st.st_size != sizeof(header) +
+	                  header[2]*sizeof(nedgz_scenenode_t)))
+	{
+		LOGE("invalid %s version=%i, count=%i",
+		     fname, header[1], header[2]);
+		goto fail_header;
+	}
+
+	nedgz_scenearray_t* self = (nedgz_scenearray_t*)
+	                           malloc(sizeof(nedgz_scenearray_t));
+	if(self == NULL)
+	{
+		LOGE("malloc failed");
+		goto fail_malloc;
+	}
+
+	// the mapping remains valid after the fd is closed
+	self->size = (size_t) st.st_size;
+	self->map  = mmap(NULL, self->size, PROT_READ, MAP_SHARED,
+	                  fd, 0);
+	if(self->map == MAP_FAILED)
+	{
+		LOGE("mmap %s failed", fname);
+		goto fail_mmap;
+	}
+	close(fd);
+
+	self->count = header[2];
+	self->node  = (const nedgz_scenenode_t*)
+	              ((const unsigned char*) self->map + sizeof(header));
+	NEDGZ_PROFILE_END(scenearray_import);
+
+	// success
+	return self;
+
+	// failure
+	fail_mmap:
+		free(self);
+	fail_malloc:
+	fail_header:
+		close(fd);
+	fail_scene:
+	fail_open:
+		NEDGZ_PROFILE_END(scenearray_import);
+	return NULL;
+}
+
+int nedgz_scenearray_export(nedgz_scenearray_t* self,
+                            const char* fname)
+{
+	assert(self);
+	assert(fname);
+	LOGD("debug fname=%s", fname);
+
+	FILE* f = fopen(fname, "w");
+	if(f == NULL)
+	{
+		LOGE("fopen %s failed", fname);
+		return 0;
+	}
+
+	int header[4] =
+	{
+		NEDGZ_SCENEARRAY_MAGIC,
+		NEDGZ_SCENEARRAY_VERSION,
+		self->count,
+		0,
+	};
+
+	if((fwrite((const void*) header, sizeof(header), 1, f) != 1) ||
+	   (fwrite((const void*) self->node, sizeof(nedgz_scenenode_t),
+	           self->count, f) != self->count))
+	{
+		LOGE("fwrite %s failed", fname);
+		goto fail_fwrite;
+	}
+
+	if(fclose(f) != 0)
+	{
+		LOGE("fclose %s failed", fname);
+		return 0;
+	}
+
+	// success
+	return 1;
+
+	// failure
+	fail_fwrite:
+		fclose(f);
+	return 0;
+}
+
+nedgz_scene_t* nedgz_scenearray_tree(nedgz_scenearray_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	if(self->count == 0)
+	{
+		LOGE("empty scene");
+		return NULL;
+	}
+
+	return nedgz_scenearray_treenode(self, 0);
+}
+
+int nedgz_scenearray_child(nedgz_scenearray_t* self,
+                           int idx, int q)
+{
+	assert(self);
+	assert(idx >= 0);
+	assert(idx < self->count);
+	assert((q >= 0) && (q < 4));
+	LOGD("debug idx=%i, q=%i", idx, q);
+
+	const nedgz_scenenode_t* node = &self->node[idx];
+	unsigned int             bit  = 1 << q;
+	if((node->mask & bit) == 0)
+	{
+		return -1;
+	}
+
+	// skip the children which precede q
+	int c = node->child + __builtin_popcount(node->mask & (bit - 1));
+	if((c <= idx) || (c >= self->count))
+	{
+		// mapped files are not validated on import
+		LOGE("invalid idx=%i, child=%i", idx, c);
+		return -1;
+	}
+	return c;
+}
+
+int nedgz_scenearray_traverse(nedgz_scenearray_t* self,
+                              nedgz_scenearray_visit_fn visit_fn,
+                              void* priv)
+{
+	// priv may be NULL
+	assert(self);
+	assert(visit_fn);
+	LOGD("debug");
+
+	if(self->count == 0)
+	{
+		return 1;
+	}
+
+	// depth-first traversal in tl, tr, bl, br order with an
+	// explicit stack which holds at most 3 siblings per level
+	nedgz_scenearray_entry_t stack[3*NEDGZ_SCENEARRAY_DEPTH + 1];
+	int                      top = 0;
+	stack[top].idx  = 0;
+	stack[top].x    = 0;
+	stack[top].y    = 0;
+	stack[top].zoom = 0;
+	++top;
+
+	while(top > 0)
+	{
+		nedgz_scenearray_entry_t e    = stack[--top];
+		const nedgz_scenenode_t* node = &self->node[e.idx];
+		if((visit_fn(priv, node, e.x, e.y, e.zoom) == 0) ||
+		   ((node->mask & 0xF) == 0))
+		{
+			continue;
+		}
+
+		if(e.zoom + 1 >= NEDGZ_SCENEARRAY_DEPTH)
+		{
+			LOGE("invalid zoom=%i", e.zoom + 1);
+			return 0;
+		}
+
+		// push the children in reverse order
+		int q;
+		int c = node->child + __builtin_popcount(node->mask & 0xF);
+		if((node->child <= e.idx) || (c > self->count))
+		{
+			LOGE("invalid idx=%i, child=%i", e.idx, node->child);
+			return 0;
+		}
+		for(q = 3; q >= 0; --q)
+		{
+			if((node->mask & (1 << q)) == 0)
+			{
+				continue;
+			}
+
+			--c;
+			stack[top].idx  = c;
+			stack[top].x    = 2*e.x + (q & 1);
+			stack[top].y    = 2*e.y + (q >> 1);
+			stack[top].zoom = e.zoom + 1;
+			++top;
+		}
+	}
+
+	return 1;
+}
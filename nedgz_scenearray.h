@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+#ifndef nedgz_scenearray_H
+#define nedgz_scenearray_H
+
+#include "nedgz_scene.h"
+
+#include <stddef.h>
+
+// the scene array is a compact pointer free copy of a scene
+// graph where the nodes are stored in breadth-first order
+// so that the children of a node are contiguous and may be
+// addressed by the index of the first child and the mask
+//
+// the root is tile 0,0 at zoom 0 and child q (TL=0, TR=1,
+// BL=2, BR=3) of x,y,zoom is 2*x + (q & 1), 2*y + (q >> 1)
+// at zoom + 1 which matches the nedsg scene graph
+
+/***********************************************************
+* v1 .sg files are the recursive scene graph written by    *
+* nedgz_scene_export.                                      *
+*                                                          *
+* v2 .sg files are the scene array so that the file may be *
+* mapped by nedgz_scenearray_import without parsing or     *
+* allocating the nodes.                                    *
+*                                                          *
+* header: int magic, int version, int count, int pad       *
+* nodes:  nedgz_scenenode_t[count]                         *
+*                                                          *
+* nedgz_scenearray_import also reads v1 files and          *
+* nedgz_scene_import also reads v2 files.                  *
+***********************************************************/
+
+#define NEDGZ_SCENEARRAY_MAGIC   0x4753454E
+#define NEDGZ_SCENEARRAY_VERSION 2
+
+#define NEDGZ_SCENENODE_TL     0x01
+#define NEDGZ_SCENENODE_TR     0x02
+#define NEDGZ_SCENENODE_BL     0x04
+#define NEDGZ_SCENENODE_BR     0x08
+#define NEDGZ_SCENENODE_EXISTS 0x10
+
+// maximum depth of nedgz_scenearray_traverse
+#define NEDGZ_SCENEARRAY_DEPTH 32
+
+// 16 bytes per node where child is the index of the first
+// child (0 when the node is a leaf)
+typedef struct
+{
+	int            child;
+	int            fsize;
+	short          min;
+	short          max;
+	unsigned short mask;
+	unsigned short pad;
+} nedgz_scenenode_t;
+
+// imported v2 arrays are mapped read-only from the file
+typedef struct
+{
+	int                      count;
+	const nedgz_scenenode_t* node;
+
+	// import mode
+	size_t      size;
+	const void* map;
+} nedgz_scenearray_t;
+
+// the visitor returns 1 to traverse the children of node
+typedef int (*nedgz_scenearray_visit_fn)(void* priv,
+                                         const nedgz_scenenode_t* node,
+                                         int x, int y, int zoom);
+
+nedgz_scenearray_t* nedgz_scenearray_new(nedgz_scene_t* scene);
+void                nedgz_scenearray_delete(nedgz_scenearray_t** _self);
+nedgz_scenearray_t* nedgz_scenearray_import(const char* fname);
+int                 nedgz_scenearray_export(nedgz_scenearray_t* self,
+                                            const char* fname);
+nedgz_scene_t*      nedgz_scenearray_tree(nedgz_scenearray_t* self);
+int                 nedgz_scenearray_child(nedgz_scenearray_t* self,
+                                           int idx, int q);
+int                 nedgz_scenearray_traverse(nedgz_scenearray_t* self,
+                                              nedgz_scenearray_visit_fn visit_fn,
+                                              void* priv);
+
+#endif
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include "nedgz_stats.h"
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#elif defined(__SSE2__)
+	#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define NEDGZ_STATS_NEON
+#endif
+
+#define LOG_TAG "nedgz"
+#include "nedgz_log.h"
+
+#define NEDGZ_STATS_SAMPLES (NEDGZ_SUBTILE_SIZE*NEDGZ_SUBTILE_SIZE)
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+// NODATA samples are replaced with the identity of the
+// min/max operation so the loops do not need to branch
+// the min/max are only valid when nodata < count
+
+#if defined(__AVX2__)
+
+static void nedgz_stats_subtile(const short* data,
+                                short* min, short* max,
+                                int* sum, int* nodata)
+{
+	assert(data);
+	assert(min);
+	assert(max);
+	assert(sum);
+	assert(nodata);
+
+	const __m256i nd   = _mm256_set1_epi16(NEDGZ_NODATA);
+	const __m256i hi   = _mm256_set1_epi16(32767);
+	const __m256i lo   = _mm256_set1_epi16(-32768);
+	const __m256i ones = _mm256_set1_epi16(1);
+	__m256i vmin = hi;
+	__m256i vmax = lo;
+	__m256i vsum = _mm256_setzero_si256();
+	__m256i vcnt = _mm256_setzero_si256();
+
+	int i;
+	for(i = 0; i < NEDGZ_STATS_SAMPLES; i += 16)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*) &data[i]);
+		__m256i m = _mm256_cmpeq_epi16(v, nd);
+		vmin = _mm256_min_epi16(vmin, _mm256_blendv_epi8(v, hi, m));
+		vmax = _mm256_max_epi16(vmax, _mm256_blendv_epi8(v, lo, m));
+		vsum = _mm256_add_epi32(vsum,
+		                        _mm256_madd_epi16(_mm256_andnot_si256(m, v),
+		                                          ones));
+		vcnt = _mm256_sub_epi16(vcnt, m);
+	}
+
+	short a[16];
+	short b[16];
+	short c[16];
+	int   s[8];
+	_mm256_storeu_si256((__m256i*) a, vmin);
+	_mm256_storeu_si256((__m256i*) b, vmax);
+	_mm256_storeu_si256((__m256i*) c, vcnt);
+	_mm256_storeu_si256((__m256i*) s, vsum);
+
+	*min    = a[0];
+	*max    = b[0];
+	*sum    = 0;
+	*nodata = 0;
+	for(i = 0; i < 16; ++i)
+	{
+		*min     = (a[i] < *min) ? a[i] : *min;
+		*max     = (b[i] > *max) ? b[i] : *max;
+		*nodata += c[i];
+	}
+	for(i = 0; i < 8; ++i)
+	{
+		*sum += s[i];
+	}
+}
+
+#elif defined(__SSE2__)
+
+static void nedgz_stats_subtile(const short* data,
+                                short* min, short* max,
+                                int* sum, int* nodata)
+{
+	assert(data);
+	assert(min);
+	assert(max);
+	assert(sum);
+	assert(nodata);
+
+	// SSE2 has no 16-bit blend so select with and/andnot
+	const __m128i nd   = _mm_set1_epi16(NEDGZ_NODATA);
+	const __m128i hi   = _mm_set1_epi16(32767);
+	const __m128i lo   = _mm_set1_epi16(-32768);
+	const __m128i ones = _mm_set1_epi16(1);
+	__m128i vmin = hi;
+	__m128i vmax = lo;
+	__m128i vsum = _mm_setzero_si128();
+	__m128i vcnt = _mm_setzero_si128();
+
+	int i;
+	for(i = 0; i < NEDGZ_STATS_SAMPLES; i += 8)
+	{
+		__m128i v  = _mm_loadu_si128((const __m128i*) &data[i]);
+		__m128i m  = _mm_cmpeq_epi16(v, nd);
+		__m128i vd = _mm_andnot_si128(m, v);
+		vmin = _mm_min_epi16(vmin, _mm_or_si128(vd, _mm_and_si128(m, hi)));
+		vmax = _mm_max_epi16(vmax, _mm_or_si128(vd, _mm_and_si128(m, lo)));
+		vsum = _mm_add_epi32(vsum, _mm_madd_epi16(vd, ones));
+		vcnt = _mm_sub_epi16(vcnt, m);
+	}
+
+	short a[8];
+	short b[8];
+	short c[8];
+	int   s[4];
+	_mm_storeu_si128((__m128i*) a, vmin);
+	_mm_storeu_si128((__m128i*) b, vmax);
+	_mm_storeu_si128((__m128i*) c, vcnt);
+	_mm_storeu_si128((__m128i*) s, vsum);
+
+	*min    = a[0];
+	*max    = b[0];
+	*sum    = 0;
+	*nodata = 0;
+	for(i = 0; i < 8; ++i)
+	{
+		*min     = (a[i] < *min) ? a[i] : *min;
+		*max     = (b[i] > *max) ? b[i] : *max;
+		*nodata += c[i];
+	}
+	for(i = 0; i < 4; ++i)
+	{
+		*sum += s[i];
+	}
+}
+
+#elif defined(NEDGZ_STATS_NEON)
+
+static void nedgz_stats_subtile(const short* data,
+                                short* min, short* max,
+                                int* sum, int* nodata)
+{
+	assert(data);
+	assert(min);
+	assert(max);
+	assert(sum);
+	assert(nodata);
+
+	const int16x8_t nd   = vdupq_n_s16(NEDGZ_NODATA);
+	const int16x8_t hi   = vdupq_n_s16(32767);
+	const int16x8_t lo   = vdupq_n_s16(-32768);
+	const int16x8_t zero = vdupq_n_s16(0);
+	int16x8_t vmin = hi;
+	int16x8_t vmax = lo;
+	int32x4_t vsum = vdupq_n_s32(0);
+	int16x8_t vcnt = zero;
+
+	int i;
+	for(i = 0; i < NEDGZ_STATS_SAMPLES; i += 8)
+	{
+		int16x8_t  v = vld1q_s16(&data[i]);
+		uint16x8_t m = vceqq_s16(v, nd);
+		vmin = vminq_s16(vmin, vbslq_s16(m, hi, v));
+		vmax = vmaxq_s16(vmax, vbslq_s16(m, lo, v));
+		vsum = vpadalq_s16(vsum, vbslq_s16(m, zero, v));
+		vcnt = vsubq_s16(vcnt, vreinterpretq_s16_u16(m));
+	}
+
+	short a[8];
+	short b[8];
+	short c[8];
+	int   s[4];
+	vst1q_s16(a, vmin);
+	vst1q_s16(b, vmax);
+	vst1q_s16(c, vcnt);
+	vst1q_s32(s, vsum);
+
+	*min    = a[0];
+	*max    = b[0];
+	*sum    = 0;
+	*nodata = 0;
+	for(i = 0; i < 8; ++i)
+	{
+		*min     = (a[i] < *min) ? a[i] : *min;
+		*max     = (b[i] > *max) ? b[i] : *max;
+		*nodata += c[i];
+	}
+	for(i = 0; i < 4; ++i)
+	{
+		*sum += s[i];
+	}
+}
+
+#else
+
+static void nedgz_stats_subtile(const short* data,
+                                short* min, short* max,
+                                int* sum, int* nodata)
+{
+	assert(data);
+	assert(min);
+	assert(max);
+	assert(sum);
+	assert(nodata);
+
+	// written without branches so the compiler
+	// may vectorize the loop on other targets
+	short vmin = 32767;
+	short vmax = -32768;
+	int   vsum = 0;
+	int   vcnt = 0;
+
+	int i;
+	for(i = 0; i < NEDGZ_STATS_SAMPLES; ++i)
+	{
+		short h  = data[i];
+		int   nd = (h == NEDGZ_NODATA);
+		short a  = nd ? 32767 : h;
+		short b  = nd ? -32768 : h;
+		vmin  = (a < vmin) ? a : vmin;
+		vmax  = (b > vmax) ? b : vmax;
+		vsum += nd ? 0 : h;
+		vcnt += nd;
+	}
+
+	*min    = vmin;
+	*max    = vmax;
+	*sum    = vsum;
+	*nodata = vcnt;
+}
+
+#endif
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+void nedgz_stats_tile(nedgz_stats_t* self, nedgz_tile_t* tile)
+{
+	assert(self);
+	assert(tile);
+	LOGD("debug x=%i, y=%i, zoom=%i", tile->x, tile->y, tile->zoom);
+
+	self->min    = NEDGZ_NODATA;
+	self->max    = NEDGZ_NODATA;
+	self->mean   = 0.0f;
+	self->count  = 0;
+	self->nodata = 0;
+
+	int       idx;
+	long long total = 0;
+	for(idx = 0; idx < NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT; ++idx)
+	{
+		self->submin[idx] = NEDGZ_NODATA;
+		self->submax[idx] = NEDGZ_NODATA;
+
+		nedgz_subtile_t* subtile = tile->subtile[idx];
+		if(subtile == NULL)
+		{
+			self->nodata += NEDGZ_STATS_SAMPLES;
+			continue;
+		}
+
+		short min;
+		short max;
+		int   sum;
+		int   nodata;
+		nedgz_stats_subtile(subtile->data, &min, &max, &sum, &nodata);
+		self->nodata += nodata;
+		if(nodata == NEDGZ_STATS_SAMPLES)
+		{
+			continue;
+		}
+
+		self->submin[idx] = min;
+		self->submax[idx] = max;
+		self->count      += NEDGZ_STATS_SAMPLES - nodata;
+		total            += sum;
+
+		if((self->min == NEDGZ_NODATA) || (min < self->min))
+		{
+			self->min = min;
+		}
+
+		if((self->max == NEDGZ_NODATA) || (max > self->max))
+		{
+			self->max = max;
+		}
+	}
+
+	if(self->count)
+	{
+		self->mean = (float) ((double) total/(double) self->count);
+	}
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef nedgz_stats_H
+#define nedgz_stats_H
+
+#include "nedgz_tile.h"
+
+// min/max/submin/submax are NEDGZ_NODATA when the
+// tile or subtile does not contain any data
+typedef struct
+{
+	short min;
+	short max;
+	float mean;
+	int   count;
+	int   nodata;
+	short submin[NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT];
+	short submax[NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT];
+} nedgz_stats_t;
+
+// compute the statistics for all samples of a tile in a
+// single pass where missing subtiles count as NEDGZ_NODATA
+// the kernel is vectorized with AVX2, SSE2 or NEON when
+// enabled by the compiler
+void nedgz_stats_tile(nedgz_stats_t* self, nedgz_tile_t* tile);
+
+#endif
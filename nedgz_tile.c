@@ -28,8 +28,13 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 #include <zlib.h>
+#include "nedgz_codec.h"
+#include "nedgz_stats.h"
 #include "nedgz_tile.h"
+#include "nedgz_path.h"
+#include "nedgz_profile.h"
 #include "nedgz_util.h"
 
 #define LOG_TAG "nedgz"
@@ -39,6 +44,56 @@
 * private                                                  *
 ***********************************************************/
 
+// v2 header: magic, version and {offset, size} table
+#define NEDGZ_TABLE_COUNT      (NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT)
+#define NEDGZ_TABLE_SIZE       ((int) (2*NEDGZ_TABLE_COUNT*sizeof(int)))
+#define NEDGZ_V2_ENTRY_OFFSET  ((int) (2*sizeof(int)))
+
+// v3 header: v2 header with metadata preceding the table
+#define NEDGZ_V3_META_SIZE     (16 + 4*NEDGZ_TABLE_COUNT)
+#define NEDGZ_V3_ENTRY_OFFSET  (NEDGZ_V2_ENTRY_OFFSET + NEDGZ_V3_META_SIZE)
+#define NEDGZ_V3_HEADER_SIZE   (NEDGZ_V3_ENTRY_OFFSET + NEDGZ_TABLE_SIZE)
+
+static void nedgz_span_clear(short* data, int count)
+{
+	assert(data);
+	LOGD("debug count=%i", count);
+
+	#if NEDGZ_NODATA == 0
+		memset((void*) data, 0, count*sizeof(short));
+	#else
+		int i;
+		for(i = 0; i < count; ++i)
+		{
+			data[i] = NEDGZ_NODATA;
+		}
+	#endif
+}
+
+static int nedgz_span_empty(const short* data, int count)
+{
+	assert(data);
+	LOGD("debug count=%i", count);
+
+	// accumulate rather than early exit so the
+	// loop may be vectorized
+	int i;
+	int defined = 0;
+	for(i = 0; i < count; ++i)
+	{
+		defined |= (data[i] != NEDGZ_NODATA);
+	}
+	return defined == 0;
+}
+
+static void nedgz_subtile_clear(nedgz_subtile_t* self)
+{
+	assert(self);
+	LOGD("debug");
+
+	nedgz_span_clear(self->data, NEDGZ_SUBTILE_SIZE*NEDGZ_SUBTILE_SIZE);
+}
+
 static nedgz_subtile_t* nedgz_subtile_new(void)
 {
 	nedgz_subtile_t* self = (nedgz_subtile_t*) malloc(sizeof(nedgz_subtile_t));
@@ -48,11 +103,7 @@ static nedgz_subtile_t* nedgz_subtile_new(void)
 		return NULL;
 	}
 
-	int i;
-	for(i = 0; i < NEDGZ_SUBTILE_SIZE*NEDGZ_SUBTILE_SIZE; ++i)
-	{
-		self->data[i] = NEDGZ_NODATA;
-	}
+	nedgz_subtile_clear(self);
 	return self;
 }
 
@@ -77,89 +128,195 @@ static void nedgz_subtile_set(nedgz_subtile_t* self, int m, int n, short h)
 	self->data[m*NEDGZ_SUBTILE_SIZE + n] = h;
 }
 
-/***********************************************************
-* public                                                   *
-***********************************************************/
-
-nedgz_tile_t* nedgz_tile_new(int x, int y, int zoom)
+static void nedgz_tile_deleteij(nedgz_tile_t* self, int idx)
 {
-	assert(x >= 0);
-	assert(y >= 0);
-	assert(zoom >= 0);
-	LOGD("debug x=%i, y=%i, zoom=%i",
-	     x, y, zoom);
+	assert(self);
+	LOGD("debug idx=%i", idx);
 
-	nedgz_tile_t* self = (nedgz_tile_t*) malloc(sizeof(nedgz_tile_t));
-	if(self == NULL)
+	if(self->slab)
 	{
-		LOGE("malloc failed");
-		return NULL;
+		// subtiles are owned by the slab
+		self->subtile[idx] = NULL;
+		self->mask &= ~(1ULL << idx);
 	}
+	else
+	{
+		nedgz_subtile_delete(&self->subtile[idx]);
+		self->mask &= ~(1ULL << idx);
+	}
+}
 
-	self->x    = x;
-	self->y    = y;
-	self->zoom = zoom;
-
-	int    count = NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT;
-	size_t size  = count*sizeof(nedgz_subtile_t*);
-	memset((void*) self->subtile, 0, size);
+static int nedgz_tile_entryoffset(int version)
+{
+	LOGD("debug version=%i", version);
 
-	return self;
+	// v2 and v3 files share the table and block layout
+	if(version == NEDGZ_VERSION_2)
+	{
+		return NEDGZ_V2_ENTRY_OFFSET;
+	}
+	else if(version == NEDGZ_VERSION_3)
+	{
+		return NEDGZ_V3_ENTRY_OFFSET;
+	}
+	return 0;
 }
 
-void nedgz_tile_delete(nedgz_tile_t** _self)
+static void nedgz_header_make(nedgz_header_t* self,
+                              nedgz_tile_t* tile)
 {
-	assert(_self);
+	assert(self);
+	assert(tile);
+	LOGD("debug");
 
-	nedgz_tile_t* self = *_self;
-	if(self)
-	{
-		LOGD("debug");
+	nedgz_stats_t stats;
+	nedgz_stats_tile(&stats, tile);
 
-		int i;
-		int j;
-		for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+	self->min   = stats.min;
+	self->max   = stats.max;
+	self->count = stats.count;
+	self->mask  = 0;
+	memcpy((void*) self->submin, (const void*) stats.submin,
+	       sizeof(self->submin));
+	memcpy((void*) self->submax, (const void*) stats.submax,
+	       sizeof(self->submax));
+
+	int idx;
+	for(idx = 0; idx < NEDGZ_TABLE_COUNT; ++idx)
+	{
+		if(tile->subtile[idx])
 		{
-			for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
-			{
-				nedgz_subtile_t* subtile = nedgz_tile_getij(self, i, j);
-				if(subtile)
-				{
-					nedgz_subtile_delete(&subtile);
-				}
-			}
+			self->mask |= 1ULL << idx;
 		}
-		free(self);
-		*_self = NULL;
 	}
 }
 
-nedgz_tile_t* nedgz_tile_import(const char* base,
-                                int x, int y, int zoom)
+static void nedgz_header_pack(const nedgz_header_t* self,
+                              unsigned char* buf)
 {
-	assert(base);
-	assert(x >= 0);
-	assert(y >= 0);
-	assert(zoom >= 0);
-	LOGD("debug base=%s, x=%i, y=%i, zoom=%i", base, x, y, zoom);
+	assert(self);
+	assert(buf);
+	LOGD("debug");
 
-	nedgz_tile_t* self = nedgz_tile_new(x, y, zoom);
-	if(self == NULL)
+	memcpy((void*) &buf[0],   (const void*) &self->min,   sizeof(short));
+	memcpy((void*) &buf[2],   (const void*) &self->max,   sizeof(short));
+	memcpy((void*) &buf[4],   (const void*) &self->count, sizeof(int));
+	memcpy((void*) &buf[8],   (const void*) &self->mask,
+	       sizeof(unsigned long long));
+	memcpy((void*) &buf[16],  (const void*) self->submin,
+	       sizeof(self->submin));
+	memcpy((void*) &buf[16 + sizeof(self->submin)],
+	       (const void*) self->submax, sizeof(self->submax));
+}
+
+static void nedgz_header_unpack(nedgz_header_t* self,
+                                const unsigned char* buf)
+{
+	assert(self);
+	assert(buf);
+	LOGD("debug");
+
+	memcpy((void*) &self->min,   (const void*) &buf[0], sizeof(short));
+	memcpy((void*) &self->max,   (const void*) &buf[2], sizeof(short));
+	memcpy((void*) &self->count, (const void*) &buf[4], sizeof(int));
+	memcpy((void*) &self->mask,  (const void*) &buf[8],
+	       sizeof(unsigned long long));
+	memcpy((void*) self->submin, (const void*) &buf[16],
+	       sizeof(self->submin));
+	memcpy((void*) self->submax,
+	       (const void*) &buf[16 + sizeof(self->submin)],
+	       sizeof(self->submax));
+}
+
+static unsigned char*
+nedgz_tile_readfile(FILE* f, const char* fname, long* _size)
+{
+	assert(f);
+	assert(fname);
+	assert(_size);
+	LOGD("debug fname=%s", fname);
+
+	if(fseek(f, 0, SEEK_END) == -1)
 	{
+		LOGE("fseek failed %s", fname);
 		return NULL;
 	}
 
-	char fname[256];
-	snprintf(fname, 256, "%s/%i/%i_%i.nedgz", base, zoom, x, y);
-	gzFile f = gzopen(fname, "rb");
-	if(f == NULL)
+	long size = ftell(f);
+	if(size <= 0)
 	{
-		LOGE("failed %s", fname);
-		goto fail_gzopen;
+		LOGE("invalid size=%li, %s", size, fname);
+		return NULL;
+	}
+
+	unsigned char* buf = (unsigned char*) malloc(size);
+	if(buf == NULL)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	rewind(f);
+	if(fread((void*) buf, size, 1, f) != 1)
+	{
+		LOGE("fread failed %s", fname);
+		goto fail_read;
+	}
+
+	*_size = size;
+
+	// success
+	return buf;
+
+	// failure
+	fail_read:
+		free(buf);
+	return NULL;
+}
+
+static int nedgz_tile_inflate(z_stream* strm, void* data, int size)
+{
+	assert(strm);
+	assert(data);
+	LOGD("debug size=%i", size);
+
+	// the entire input is available so inflate only
+	// returns early when the stream is truncated
+	strm->next_out  = (Bytef*) data;
+	strm->avail_out = size;
+	int ret = inflate(strm, Z_NO_FLUSH);
+	if(((ret != Z_OK) && (ret != Z_STREAM_END)) ||
+	   (strm->avail_out != 0))
+	{
+		LOGE("inflate failed ret=%i", ret);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int nedgz_tile_importv1(nedgz_tile_t* self,
+                               const unsigned char* buf, long size,
+                               const char* fname)
+{
+	assert(self);
+	assert(buf);
+	assert(fname);
+	LOGD("debug size=%li, fname=%s", size, fname);
+
+	// inflate the records directly into the subtiles
+	z_stream strm;
+	memset((void*) &strm, 0, sizeof(z_stream));
+	strm.next_in  = (Bytef*) buf;
+	strm.avail_in = (uInt) size;
+	if(inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK)
+	{
+		LOGE("inflateInit2 failed %s", fname);
+		return 0;
 	}
 
 	short count;
-	if(gzread(f, &count, sizeof(short)) != sizeof(short))
+	if(nedgz_tile_inflate(&strm, &count, sizeof(short)) == 0)
 	{
 		LOGE("failed %s", fname);
 		goto fail_count;
@@ -175,21 +332,16 @@ nedgz_tile_t* nedgz_tile_import(const char* base,
 	int idx;
 	for(idx = 0; idx < count; ++idx)
 	{
-		unsigned char i;
-		unsigned char j;
-		if(gzread(f, &i, sizeof(i)) != sizeof(i))
-		{
-			LOGE("failed %s", fname);
-			goto fail_ij;
-		}
-		if(gzread(f, &j, sizeof(j)) != sizeof(j))
+		unsigned char ij[2];
+		if(nedgz_tile_inflate(&strm, ij, sizeof(ij)) == 0)
 		{
 			LOGE("failed %s", fname);
 			goto fail_ij;
 		}
 
-		if((i < 0) || (i >= NEDGZ_SUBTILE_COUNT) ||
-		   (j < 0) || (j >= NEDGZ_SUBTILE_COUNT))
+		int i = (int) ij[0];
+		int j = (int) ij[1];
+		if((i >= NEDGZ_SUBTILE_COUNT) || (j >= NEDGZ_SUBTILE_COUNT))
 		{
 			LOGE("failed %s", fname);
 			goto fail_ij;
@@ -203,32 +355,24 @@ nedgz_tile_t* nedgz_tile_import(const char* base,
 			goto fail_subtile_exists;
 		}
 
-		subtile = nedgz_subtile_new();
+		subtile = nedgz_tile_newij(self, i, j);
 		if(subtile == NULL)
 		{
 			goto fail_subtile_new;
 		}
-		self->subtile[i*NEDGZ_SUBTILE_COUNT + j] = subtile;
 
-		int bytes = NEDGZ_SUBTILE_SIZE*NEDGZ_SUBTILE_SIZE*sizeof(short);
-		unsigned char* data = (unsigned char*) subtile->data;
-		while(bytes > 0)
+		if(nedgz_tile_inflate(&strm, subtile->data,
+		                      sizeof(subtile->data)) == 0)
 		{
-			int bytes_read = gzread(f, data, bytes);
-			if(bytes_read == 0)
-			{
-				LOGE("failed to read data");
-				goto fail_data;
-			}
-			data  += bytes_read;
-			bytes -= bytes_read;
+			LOGE("failed to read data");
+			goto fail_data;
 		}
 	}
 
-	gzclose(f);
+	inflateEnd(&strm);
 
 	// success
-	return self;
+	return 1;
 
 	// failure
 	fail_data:
@@ -237,173 +381,923 @@ nedgz_tile_t* nedgz_tile_import(const char* base,
 	fail_subtile_exists:
 	fail_ij:
 	fail_count:
-		gzclose(f);
-	fail_gzopen:
-		nedgz_tile_delete(&self);
-	return NULL;
+		inflateEnd(&strm);
+	return 0;
 }
 
-int nedgz_tile_export(nedgz_tile_t* self, const char* base)
+static nedgz_tile_t*
+nedgz_tile_importv1ij(const char* base,
+                      int x, int y, int zoom,
+                      int i, int j)
 {
-	assert(self);
 	assert(base);
+	LOGD("debug base=%s, x=%i, y=%i, zoom=%i, i=%i, j=%i",
+	     base, x, y, zoom, i, j);
 
-	char dname[256];
-	char fname[256];
-	snprintf(dname, 256, "%s/%i", base, self->zoom);
-	snprintf(fname, 256, "%s/%i_%i.nedgz", dname, self->x, self->y);
-	LOGD("debug %s", fname);
+	nedgz_tile_t* self = nedgz_tile_import(base, x, y, zoom);
+	if(self == NULL)
+	{
+		return NULL;
+	}
 
-	// make sure there are subtiles to write
-	short count = 0;
-	unsigned char i;
-	unsigned char j;
-	for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+	if(nedgz_tile_getij(self, i, j) == NULL)
 	{
-		for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+		// subtile does not exist
+		nedgz_tile_delete(&self);
+		return NULL;
+	}
+
+	// discard the other subtiles
+	int idx;
+	for(idx = 0; idx < NEDGZ_TABLE_COUNT; ++idx)
+	{
+		if(idx != i*NEDGZ_SUBTILE_COUNT + j)
 		{
-			if(nedgz_tile_getij(self, (int) i, (int) j))
-			{
-				++count;
-			}
+			nedgz_tile_deleteij(self, idx);
 		}
 	}
 
-	if(count == 0)
+	return self;
+}
+
+static int nedgz_tile_importv2(nedgz_tile_t* self,
+                               const unsigned char* buf, long size,
+                               const char* fname)
+{
+	assert(self);
+	assert(buf);
+	assert(fname);
+	LOGD("debug size=%li, fname=%s", size, fname);
+
+	if(size < NEDGZ_V2_ENTRY_OFFSET + NEDGZ_TABLE_SIZE)
 	{
-		// silently succeed
-		return 1;
+		LOGE("invalid size=%li, %s", size, fname);
+		return 0;
+	}
+
+	int header[2];
+	memcpy((void*) header, (const void*) buf, sizeof(header));
+	int entry_offset = nedgz_tile_entryoffset(header[1]);
+	int header_size  = entry_offset + NEDGZ_TABLE_SIZE;
+	if((entry_offset == 0) || (size < header_size))
+	{
+		LOGE("invalid version=%i, size=%li, %s",
+		     header[1], size, fname);
+		goto fail_version;
 	}
 
-	// create directories if necessary
-	if(mkdir(base, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+	// decode the subtiles
+	int table[2*NEDGZ_TABLE_COUNT];
+	memcpy((void*) table, (const void*) &buf[entry_offset],
+	       sizeof(table));
+
+	int idx;
+	for(idx = 0; idx < NEDGZ_TABLE_COUNT; ++idx)
 	{
-		if(errno == EEXIST)
+		int offset = table[2*idx];
+		int bytes  = table[2*idx + 1];
+		if(bytes == 0)
 		{
-			// already exists
+			continue;
 		}
-		else
+
+		if((offset < header_size) || (bytes < 0) ||
+		   ((long) offset + bytes > size))
 		{
-			LOGE("mkdir %s failed", base);
-			return 0;
+			LOGE("invalid offset=%i, bytes=%i, %s", offset, bytes, fname);
+			goto fail_table;
 		}
-	}
-	if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
-	{
-		if(errno == EEXIST)
+
+		nedgz_subtile_t* subtile;
+		subtile = nedgz_tile_newij(self, idx/NEDGZ_SUBTILE_COUNT,
+		                          idx%NEDGZ_SUBTILE_COUNT);
+		if(subtile == NULL)
 		{
-			// already exists
+			goto fail_subtile;
 		}
-		else
+
+		if(nedgz_codec_decode(subtile, &buf[offset], bytes) == 0)
 		{
-			LOGE("mkdir %s failed", dname);
-			return 0;
+			LOGE("failed %s", fname);
+			goto fail_decode;
 		}
 	}
 
-	gzFile f = gzopen(fname, "wb");
-	if(f == NULL)
+	// success
+	return 1;
+
+	// failure
+	fail_decode:
+	fail_subtile:
+	fail_table:
+	fail_version:
+	return 0;
+}
+
+static int nedgz_tile_deflate(z_stream* strm, const void* data,
+                              int size, int flush)
+{
+	assert(strm);
+	assert(data);
+	LOGD("debug size=%i, flush=%i", size, flush);
+
+	// the output buffer is sized by deflateBound so
+	// deflate always consumes the entire input
+	strm->next_in  = (Bytef*) data;
+	strm->avail_in = size;
+	int ret = deflate(strm, flush);
+	if((ret == Z_STREAM_ERROR) || (strm->avail_in != 0) ||
+	   ((flush == Z_FINISH) && (ret != Z_STREAM_END)))
+	{
+		LOGE("deflate failed ret=%i", ret);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int nedgz_tile_exportv1(nedgz_tile_t* self, FILE* f,
+                               const char* fname, short count)
+{
+	assert(self);
+	assert(f);
+	assert(fname);
+	LOGD("debug fname=%s, count=%i", fname, (int) count);
+
+	// deflate the records directly from the subtiles
+	z_stream strm;
+	memset((void*) &strm, 0, sizeof(z_stream));
+	if(deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+	                16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
 	{
-		LOGE("gzopen failed");
+		LOGE("deflateInit2 failed");
 		return 0;
 	}
 
-	if(gzwrite(f, (const void*) &count, sizeof(short)) != sizeof(short))
+	uLong raw  = sizeof(short) +
+	             count*(2 + sizeof(nedgz_subtile_t));
+	uLong size = deflateBound(&strm, raw);
+	unsigned char* buf = (unsigned char*) malloc(size);
+	if(buf == NULL)
+	{
+		LOGE("malloc failed");
+		goto fail_malloc;
+	}
+	strm.next_out  = (Bytef*) buf;
+	strm.avail_out = (uInt) size;
+
+	if(nedgz_tile_deflate(&strm, &count, sizeof(short),
+	                      Z_NO_FLUSH) == 0)
 	{
 		LOGE("failed to write count");
 		goto fail_count;
 	}
 
 	// write subtiles
-	for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+	int idx;
+	int remaining = count;
+	for(idx = 0; idx < NEDGZ_TABLE_COUNT; ++idx)
 	{
-		for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+		nedgz_subtile_t* subtile = self->subtile[idx];
+		if(subtile == NULL)
 		{
-			nedgz_subtile_t* subtile = nedgz_tile_getij(self, (int) i, (int) j);
-			if(subtile == NULL)
-			{
-				continue;
-			}
-
-			if(gzwrite(f, (const void*) &i, sizeof(unsigned char)) != sizeof(unsigned char))
-			{
-				LOGE("failed %s", fname);
-				goto fail_i;
-			}
-			if(gzwrite(f, (const void*) &j, sizeof(unsigned char)) != sizeof(unsigned char))
-			{
-				LOGE("failed %s", fname);
-				goto fail_j;
-			}
+			continue;
+		}
+		--remaining;
 
-			int bytes = NEDGZ_SUBTILE_SIZE*NEDGZ_SUBTILE_SIZE*sizeof(short);
-			unsigned char* data = (unsigned char*) subtile->data;
-			while(bytes > 0)
-			{
-				int bytes_written = gzwrite(f, (const void*) data, bytes);
-				if(bytes_written == 0)
-				{
-					LOGE("failed %s", fname);
-					goto fail_data;
-				}
-				data  += bytes_written;
-				bytes -= bytes_written;
-			}
+		unsigned char ij[2];
+		ij[0] = (unsigned char) (idx/NEDGZ_SUBTILE_COUNT);
+		ij[1] = (unsigned char) (idx%NEDGZ_SUBTILE_COUNT);
+		if((nedgz_tile_deflate(&strm, ij, sizeof(ij),
+		                       Z_NO_FLUSH) == 0) ||
+		   (nedgz_tile_deflate(&strm, subtile->data,
+		                       sizeof(subtile->data),
+		                       remaining ? Z_NO_FLUSH : Z_FINISH) == 0))
+		{
+			LOGE("failed %s", fname);
+			goto fail_data;
 		}
 	}
 
-	gzclose(f);
+	if(fwrite((const void*) buf, strm.total_out, 1, f) != 1)
+	{
+		LOGE("fwrite %s failed", fname);
+		goto fail_fwrite;
+	}
+	free(buf);
+	deflateEnd(&strm);
 
 	// success
 	return 1;
 
 	// failure
+	fail_fwrite:
 	fail_data:
-	fail_j:
-	fail_i:
 	fail_count:
-		gzclose(f);
+		free(buf);
+	fail_malloc:
+		deflateEnd(&strm);
 	return 0;
 }
 
-nedgz_subtile_t* nedgz_tile_getij(nedgz_tile_t* self, int i, int j)
+static int nedgz_tile_exportv3(nedgz_tile_t* self, FILE* f,
+                               const char* fname, int codec)
 {
 	assert(self);
-	assert(i >= 0);
-	assert(i < NEDGZ_SUBTILE_COUNT);
-	assert(j >= 0);
-	assert(j < NEDGZ_SUBTILE_COUNT);
-	LOGD("debug i=%i, j=%i", i, j);
+	assert(f);
+	assert(fname);
+	LOGD("debug fname=%s, codec=%i", fname, codec);
 
-	return self->subtile[i*NEDGZ_SUBTILE_COUNT + j];
-}
+	int size = NEDGZ_TABLE_COUNT*NEDGZ_CODEC_BOUND;
+	unsigned char* blocks = (unsigned char*) malloc(size);
+	if(blocks == NULL)
+	{
+		LOGE("malloc failed");
+		return 0;
+	}
 
-int nedgz_tile_set(nedgz_tile_t* self,
-                   int i, int j,
-                   int m, int n,
-                   short h)
-{
-	assert(self);
-	assert(i >= 0);
-	assert(i < NEDGZ_SUBTILE_COUNT);
-	assert(j >= 0);
-	assert(j < NEDGZ_SUBTILE_COUNT);
-	assert(m >= 0);
-	assert(m < NEDGZ_SUBTILE_SIZE);
-	assert(n >= 0);
-	assert(n < NEDGZ_SUBTILE_SIZE);
-	LOGD("debug i=%i, j=%i, m=%i, n=%i, h=%i", i, j, m, n, (int) h);
+	// compute the metadata
+	int            header[2] = { NEDGZ_MAGIC, NEDGZ_VERSION_3 };
+	unsigned char  meta[NEDGZ_V3_META_SIZE];
+	nedgz_header_t hdr;
+	nedgz_header_make(&hdr, self);
+	nedgz_header_pack(&hdr, meta);
 
-	// create subtile if it does not yet exist
-	nedgz_subtile_t* subtile = nedgz_tile_getij(self, i, j);
+	// encode subtiles
+	int table[2*NEDGZ_TABLE_COUNT];
+	int used = 0;
+	int idx;
+	for(idx = 0; idx < NEDGZ_TABLE_COUNT; ++idx)
+	{
+		nedgz_subtile_t* subtile = self->subtile[idx];
+		if(subtile == NULL)
+		{
+			table[2*idx]     = 0;
+			table[2*idx + 1] = 0;
+			continue;
+		}
+
+		int bytes = nedgz_codec_encode(subtile, codec,
+		                               &blocks[used], size - used);
+		if(bytes == 0)
+		{
+			goto fail_encode;
+		}
+		table[2*idx]     = NEDGZ_V3_HEADER_SIZE + used;
+		table[2*idx + 1] = bytes;
+		used += bytes;
+	}
+
+	if((fwrite((const void*) header, sizeof(header), 1, f) != 1) ||
+	   (fwrite((const void*) meta, sizeof(meta), 1, f) != 1) ||
+	   (fwrite((const void*) table, sizeof(table), 1, f) != 1) ||
+	   (fwrite((const void*) blocks, used, 1, f) != 1))
+	{
+		LOGE("fwrite %s failed", fname);
+		goto fail_fwrite;
+	}
+	free(blocks);
+
+	// success
+	return 1;
+
+	// failure
+	fail_fwrite:
+	fail_encode:
+		free(blocks);
+	return 0;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+nedgz_tile_t* nedgz_tile_new(int x, int y, int zoom)
+{
+	assert(x >= 0);
+	assert(y >= 0);
+	assert(zoom >= 0);
+	LOGD("debug x=%i, y=%i, zoom=%i",
+	     x, y, zoom);
+
+	nedgz_tile_t* self = (nedgz_tile_t*) malloc(sizeof(nedgz_tile_t));
+	if(self == NULL)
+	{
+		LOGE("malloc failed");
+		return NULL;
+	}
+
+	self->x    = x;
+	self->y    = y;
+	self->zoom = zoom;
+	self->mask = 0;
+	self->slab = NULL;
+	memset((void*) self->subtile, 0, sizeof(self->subtile));
+
+	return self;
+}
+
+nedgz_tile_t* nedgz_tile_newslab(int x, int y, int zoom)
+{
+	assert(x >= 0);
+	assert(y >= 0);
+	assert(zoom >= 0);
+	LOGD("debug x=%i, y=%i, zoom=%i",
+	     x, y, zoom);
+
+	nedgz_tile_t* self = nedgz_tile_new(x, y, zoom);
+	if(self == NULL)
+	{
+		return NULL;
+	}
+
+	// the slab is not cleared until subtiles are created
+	self->slab = (nedgz_subtile_t*)
+	             malloc(NEDGZ_TABLE_COUNT*sizeof(nedgz_subtile_t));
+	if(self->slab == NULL)
+	{
+		LOGE("malloc failed");
+		goto fail_slab;
+	}
+
+	// success
+	return self;
+
+	// failure
+	fail_slab:
+		free(self);
+	return NULL;
+}
+
+void nedgz_tile_delete(nedgz_tile_t** _self)
+{
+	assert(_self);
+
+	nedgz_tile_t* self = *_self;
+	if(self)
+	{
+		LOGD("debug");
+
+		int idx;
+		for(idx = 0; idx < NEDGZ_TABLE_COUNT; ++idx)
+		{
+			nedgz_tile_deleteij(self, idx);
+		}
+		free(self->slab);
+		free(self);
+		*_self = NULL;
+	}
+}
+
+void nedgz_tile_reset(nedgz_tile_t* self, int x, int y, int zoom)
+{
+	assert(self);
+	assert(x >= 0);
+	assert(y >= 0);
+	assert(zoom >= 0);
+	LOGD("debug x=%i, y=%i, zoom=%i", x, y, zoom);
+
+	self->x    = x;
+	self->y    = y;
+	self->zoom = zoom;
+
+	if(self->slab)
+	{
+		self->mask = 0;
+		memset((void*) self->subtile, 0, sizeof(self->subtile));
+	}
+	else
+	{
+		int idx;
+		for(idx = 0; idx < NEDGZ_TABLE_COUNT; ++idx)
+		{
+			nedgz_subtile_delete(&self->subtile[idx]);
+		}
+		self->mask = 0;
+	}
+}
+
+nedgz_tile_t* nedgz_tile_import(const char* base,
+                                int x, int y, int zoom)
+{
+	assert(base);
+	assert(x >= 0);
+	assert(y >= 0);
+	assert(zoom >= 0);
+	LOGD("debug base=%s, x=%i, y=%i, zoom=%i", base, x, y, zoom);
+
+	nedgz_tile_t* self = nedgz_tile_new(x, y, zoom);
+	if(self == NULL)
+	{
+		return NULL;
+	}
+
+	if(nedgz_tile_load(self, base) == 0)
+	{
+		nedgz_tile_delete(&self);
+		return NULL;
+	}
+
+	return self;
+}
+
+int nedgz_tile_load(nedgz_tile_t* self, const char* base)
+{
+	assert(self);
+	assert(base);
+	LOGD("debug base=%s, x=%i, y=%i, zoom=%i",
+	     base, self->x, self->y, self->zoom);
+
+	char fname[256];
+	snprintf(fname, 256, "%s/%i/%i_%i.nedgz",
+	         base, self->zoom, self->x, self->y);
+	NEDGZ_PROFILE_BEGIN(tile_read);
+	FILE* f = fopen(fname, "r");
+	if(f == NULL)
+	{
+		LOGE("failed %s", fname);
+		goto fail_fopen;
+	}
+
+	// read the entire file with a single fread
+	long           size = 0;
+	unsigned char* buf  = nedgz_tile_readfile(f, fname, &size);
+	fclose(f);
+	if(buf == NULL)
+	{
+		goto fail_read;
+	}
+	NEDGZ_PROFILE_END(tile_read);
+	NEDGZ_PROFILE_COUNT(tile_read_bytes, size);
+
+	// v1 files are a gzip stream without a header
+	NEDGZ_PROFILE_BEGIN(tile_decode);
+	int magic = 0;
+	if(size >= (long) sizeof(int))
+	{
+		memcpy((void*) &magic, (const void*) buf, sizeof(int));
+	}
+
+	if(magic == NEDGZ_MAGIC)
+	{
+		if(nedgz_tile_importv2(self, buf, size, fname) == 0)
+		{
+			goto fail_import;
+		}
+	}
+	else
+	{
+		if(nedgz_tile_importv1(self, buf, size, fname) == 0)
+		{
+			goto fail_import;
+		}
+	}
+	NEDGZ_PROFILE_END(tile_decode);
+
+	free(buf);
+
+	// success
+	return 1;
+
+	// failure
+	fail_import:
+		NEDGZ_PROFILE_END(tile_decode);
+		free(buf);
+	return 0;
+	fail_read:
+	fail_fopen:
+		NEDGZ_PROFILE_END(tile_read);
+	return 0;
+}
+
+nedgz_tile_t* nedgz_tile_importij(const char* base,
+                                  int x, int y, int zoom,
+                                  int i, int j)
+{
+	assert(base);
+	assert(x >= 0);
+	assert(y >= 0);
+	assert(zoom >= 0);
+	assert(i >= 0);
+	assert(i < NEDGZ_SUBTILE_COUNT);
+	assert(j >= 0);
+	assert(j < NEDGZ_SUBTILE_COUNT);
+	LOGD("debug base=%s, x=%i, y=%i, zoom=%i, i=%i, j=%i",
+	     base, x, y, zoom, i, j);
+
+	char fname[256];
+	snprintf(fname, 256, "%s/%i/%i_%i.nedgz", base, zoom, x, y);
+	FILE* f = fopen(fname, "r");
+	if(f == NULL)
+	{
+		LOGE("failed %s", fname);
+		return NULL;
+	}
+
+	int header[2];
+	if((fread((void*) header, sizeof(header), 1, f) != 1) ||
+	   (header[0] != NEDGZ_MAGIC))
+	{
+		// fall back to importing the entire v1 tile
+		fclose(f);
+		return nedgz_tile_importv1ij(base, x, y, zoom, i, j);
+	}
+
+	int entry_offset = nedgz_tile_entryoffset(header[1]);
+	if(entry_offset == 0)
+	{
+		LOGE("invalid version=%i, %s", header[1], fname);
+		goto fail_version;
+	}
+
+	// read the table entry for i,j
+	int  entry[2];
+	long offset = entry_offset + 2*(i*NEDGZ_SUBTILE_COUNT + j)*sizeof(int);
+	if((fseek(f, offset, SEEK_SET) == -1) ||
+	   (fread((void*) entry, sizeof(entry), 1, f) != 1))
+	{
+		LOGE("failed %s", fname);
+		goto fail_entry;
+	}
+
+	if(entry[1] == 0)
+	{
+		// subtile does not exist
+		fclose(f);
+		return NULL;
+	}
+
+	if((entry[0] < entry_offset + NEDGZ_TABLE_SIZE) ||
+	   (entry[1] < 0) || (entry[1] > NEDGZ_CODEC_BOUND))
+	{
+		LOGE("invalid offset=%i, size=%i, %s", entry[0], entry[1], fname);
+		goto fail_entry;
+	}
+
+	// read the block
+	unsigned char block[NEDGZ_CODEC_BOUND];
+	if((fseek(f, entry[0], SEEK_SET) == -1) ||
+	   (fread((void*) block, entry[1], 1, f) != 1))
+	{
+		LOGE("failed %s", fname);
+		goto fail_block;
+	}
+
+	nedgz_tile_t* self = nedgz_tile_new(x, y, zoom);
+	if(self == NULL)
+	{
+		goto fail_tile;
+	}
+
+	nedgz_subtile_t* subtile = nedgz_tile_newij(self, i, j);
 	if(subtile == NULL)
+	{
+		goto fail_subtile;
+	}
+
+	if(nedgz_codec_decode(subtile, block, entry[1]) == 0)
+	{
+		goto fail_decode;
+	}
+
+	fclose(f);
+
+	// success
+	return self;
+
+	// failure
+	fail_decode:
+	fail_subtile:
+		nedgz_tile_delete(&self);
+	fail_tile:
+	fail_block:
+	fail_entry:
+	fail_version:
+		fclose(f);
+	return NULL;
+}
+
+int nedgz_tile_header(const char* base,
+                      int x, int y, int zoom,
+                      nedgz_header_t* header)
+{
+	assert(base);
+	assert(x >= 0);
+	assert(y >= 0);
+	assert(zoom >= 0);
+	assert(header);
+	LOGD("debug base=%s, x=%i, y=%i, zoom=%i",
+	     base, x, y, zoom);
+
+	char fname[256];
+	snprintf(fname, 256, "%s/%i/%i_%i.nedgz", base, zoom, x, y);
+	FILE* f = fopen(fname, "r");
+	if(f == NULL)
+	{
+		LOGE("failed %s", fname);
+		return 0;
+	}
+
+	int version[2];
+	if((fread((void*) version, sizeof(version), 1, f) == 1) &&
+	   (version[0] == NEDGZ_MAGIC) &&
+	   (version[1] == NEDGZ_VERSION_3))
+	{
+		unsigned char meta[NEDGZ_V3_META_SIZE];
+		if(fread((void*) meta, sizeof(meta), 1, f) != 1)
+		{
+			LOGE("fread failed %s", fname);
+			goto fail_meta;
+		}
+		fclose(f);
+
+		nedgz_header_unpack(header, meta);
+		return 1;
+	}
+	fclose(f);
+
+	// older versions must import the tile to
+	// compute the metadata
+	nedgz_tile_t* tile = nedgz_tile_import(base, x, y, zoom);
+	if(tile == NULL)
+	{
+		return 0;
+	}
+	nedgz_header_make(header, tile);
+	nedgz_tile_delete(&tile);
+
+	// success
+	return 1;
+
+	// failure
+	fail_meta:
+		fclose(f);
+	return 0;
+}
+
+int nedgz_tile_valid(const char* base, int x, int y, int zoom)
+{
+	assert(base);
+	assert(x >= 0);
+	assert(y >= 0);
+	assert(zoom >= 0);
+	LOGD("debug base=%s, x=%i, y=%i, zoom=%i",
+	     base, x, y, zoom);
+
+	char fname[256];
+	snprintf(fname, 256, "%s/%i/%i_%i.nedgz", base, zoom, x, y);
+	FILE* f = fopen(fname, "r");
+	if(f == NULL)
+	{
+		// tile does not exist
+		return 0;
+	}
+
+	int header[2];
+	if((fread((void*) header, sizeof(header), 1, f) != 1) ||
+	   (header[0] != NEDGZ_MAGIC))
+	{
+		// v1 tiles must be imported to validate the stream
+		fclose(f);
+		nedgz_tile_t* self = nedgz_tile_import(base, x, y, zoom);
+		if(self == NULL)
+		{
+			return 0;
+		}
+		nedgz_tile_delete(&self);
+		return 1;
+	}
+
+	// check that the table entries are within the file
+	int  table[2*NEDGZ_TABLE_COUNT];
+	int  entry_offset = nedgz_tile_entryoffset(header[1]);
+	long size         = 0;
+	if((entry_offset == 0) ||
+	   (fseek(f, entry_offset, SEEK_SET) == -1) ||
+	   (fread((void*) table, sizeof(table), 1, f) != 1) ||
+	   (fseek(f, 0, SEEK_END) == -1) ||
+	   ((size = ftell(f)) < 0))
+	{
+		LOGE("invalid %s", fname);
+		goto fail_table;
+	}
+	fclose(f);
+
+	int idx;
+	for(idx = 0; idx < NEDGZ_TABLE_COUNT; ++idx)
+	{
+		int offset = table[2*idx];
+		int bytes  = table[2*idx + 1];
+		if(bytes == 0)
+		{
+			continue;
+		}
+
+		if((offset < entry_offset + NEDGZ_TABLE_SIZE) ||
+		   (bytes < 0) || ((long) offset + bytes > size))
+		{
+			LOGE("invalid offset=%i, bytes=%i, %s",
+			     offset, bytes, fname);
+			return 0;
+		}
+	}
+
+	// success
+	return 1;
+
+	// failure
+	fail_table:
+		fclose(f);
+	return 0;
+}
+
+int nedgz_tile_export(nedgz_tile_t* self, const char* base)
+{
+	assert(self);
+	assert(base);
+	LOGD("debug base=%s", base);
+
+	return nedgz_tile_exportflags(self, base, 0);
+}
+
+int nedgz_tile_exportflags(nedgz_tile_t* self, const char* base,
+                           int flags)
+{
+	assert(self);
+	assert(base);
+
+	char dname[256];
+	char fname[256];
+	snprintf(dname, 256, "%s/%i", base, self->zoom);
+	snprintf(fname, 256, "%s/%i_%i.nedgz", dname, self->x, self->y);
+	LOGD("debug %s, flags=0x%X", fname, flags);
+
+	// make sure there are subtiles to write
+	short count = 0;
+	int   i;
+	int   j;
+	for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+	{
+		for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+		{
+			if(nedgz_tile_getij(self, i, j))
+			{
+				++count;
+			}
+		}
+	}
+
+	if(count == 0)
+	{
+		// silently succeed
+		return 1;
+	}
+
+	// write to fname.part and rename so that an interrupted
+	// export never leaves a truncated tile
+	NEDGZ_PROFILE_BEGIN(tile_export);
+	char pname[256];
+	snprintf(pname, 256, "%s.part", fname);
+	FILE* f = nedgz_path_fopen(pname, "w");
+	if(f == NULL)
+	{
+		LOGE("fopen %s failed", pname);
+		goto fail_fopen;
+	}
+
+	NEDGZ_PROFILE_BEGIN(tile_encode);
+	if(flags & NEDGZ_FLAG_V1)
+	{
+		if(nedgz_tile_exportv1(self, f, pname, count) == 0)
+		{
+			goto fail_export;
+		}
+	}
+	else
+	{
+		int codec = NEDGZ_CODEC_ZLIB;
+		if(flags & NEDGZ_FLAG_PREDICT)
+		{
+			codec = NEDGZ_CODEC_PREDICT;
+		}
+
+		if(nedgz_tile_exportv3(self, f, pname, codec) == 0)
+		{
+			goto fail_export;
+		}
+	}
+	NEDGZ_PROFILE_END(tile_encode);
+
+	if(flags & NEDGZ_FLAG_FSYNC)
+	{
+		if((fflush(f) != 0) || (fsync(fileno(f)) != 0))
+		{
+			LOGE("fsync %s failed", pname);
+			goto fail_fsync;
+		}
+	}
+
+	if(fclose(f) != 0)
+	{
+		LOGE("fclose %s failed", pname);
+		goto fail_fclose;
+	}
+
+	// deferred exports are renamed by nedgz_batch_commit
+	if((flags & NEDGZ_FLAG_DEFER) == 0)
+	{
+		if(rename(pname, fname) != 0)
+		{
+			LOGE("rename %s failed", pname);
+			goto fail_rename;
+		}
+	}
+	NEDGZ_PROFILE_END(tile_export);
+
+	// success
+	return 1;
+
+	// failure
+	fail_export:
+		NEDGZ_PROFILE_END(tile_encode);
+	fail_fsync:
+		fclose(f);
+	fail_fclose:
+	fail_rename:
+		unlink(pname);
+	fail_fopen:
+		NEDGZ_PROFILE_END(tile_export);
+	return 0;
+}
+
+nedgz_subtile_t* nedgz_tile_getij(nedgz_tile_t* self, int i, int j)
+{
+	assert(self);
+	assert(i >= 0);
+	assert(i < NEDGZ_SUBTILE_COUNT);
+	assert(j >= 0);
+	assert(j < NEDGZ_SUBTILE_COUNT);
+	LOGD("debug i=%i, j=%i", i, j);
+
+	return self->subtile[i*NEDGZ_SUBTILE_COUNT + j];
+}
+
+nedgz_subtile_t* nedgz_tile_newij(nedgz_tile_t* self, int i, int j)
+{
+	assert(self);
+	assert(i >= 0);
+	assert(i < NEDGZ_SUBTILE_COUNT);
+	assert(j >= 0);
+	assert(j < NEDGZ_SUBTILE_COUNT);
+	LOGD("debug i=%i, j=%i", i, j);
+
+	// create subtile if it does not yet exist
+	int              idx     = i*NEDGZ_SUBTILE_COUNT + j;
+	nedgz_subtile_t* subtile = self->subtile[idx];
+	if(subtile)
+	{
+		return subtile;
+	}
+
+	if(self->slab)
+	{
+		subtile = &self->slab[idx];
+		nedgz_subtile_clear(subtile);
+	}
+	else
 	{
 		subtile = nedgz_subtile_new();
 		if(subtile == NULL)
 		{
-			return 0;
+			return NULL;
 		}
-		self->subtile[i*NEDGZ_SUBTILE_COUNT + j] = subtile;
+	}
+	self->subtile[idx] = subtile;
+	self->mask        |= 1ULL << idx;
+
+	return subtile;
+}
+
+int nedgz_tile_set(nedgz_tile_t* self,
+                   int i, int j,
+                   int m, int n,
+                   short h)
+{
+	assert(self);
+	assert(i >= 0);
+	assert(i < NEDGZ_SUBTILE_COUNT);
+	assert(j >= 0);
+	assert(j < NEDGZ_SUBTILE_COUNT);
+	assert(m >= 0);
+	assert(m < NEDGZ_SUBTILE_SIZE);
+	assert(n >= 0);
+	assert(n < NEDGZ_SUBTILE_SIZE);
+	LOGD("debug i=%i, j=%i, m=%i, n=%i, h=%i", i, j, m, n, (int) h);
+
+	nedgz_subtile_t* subtile = nedgz_tile_newij(self, i, j);
+	if(subtile == NULL)
+	{
+		return 0;
 	}
 
 	nedgz_subtile_set(subtile, m, n, h);
@@ -411,6 +1305,141 @@ int nedgz_tile_set(nedgz_tile_t* self,
 	return 1;
 }
 
+void nedgz_tile_getregion(nedgz_tile_t* self,
+                          int r0, int c0,
+                          int rows, int cols,
+                          int stride, short* data)
+{
+	assert(self);
+	assert(r0 >= 0);
+	assert(c0 >= 0);
+	assert(rows >= 0);
+	assert(cols >= 0);
+	assert((r0 + rows) <= NEDGZ_TILE_SIZE);
+	assert((c0 + cols) <= NEDGZ_TILE_SIZE);
+	assert(stride >= cols);
+	assert(data);
+	LOGD("debug r0=%i, c0=%i, rows=%i, cols=%i, stride=%i",
+	     r0, c0, rows, cols, stride);
+
+	// copy each row as spans which do not cross subtiles
+	int r;
+	int c;
+	for(r = 0; r < rows; ++r)
+	{
+		int    i   = (r0 + r)/NEDGZ_SUBTILE_SIZE;
+		int    m   = (r0 + r)%NEDGZ_SUBTILE_SIZE;
+		short* dst = &data[r*stride];
+		for(c = 0; c < cols;)
+		{
+			int j     = (c0 + c)/NEDGZ_SUBTILE_SIZE;
+			int n     = (c0 + c)%NEDGZ_SUBTILE_SIZE;
+			int count = NEDGZ_SUBTILE_SIZE - n;
+			if(count > cols - c)
+			{
+				count = cols - c;
+			}
+
+			nedgz_subtile_t* subtile;
+			subtile = self->subtile[i*NEDGZ_SUBTILE_COUNT + j];
+			if(subtile)
+			{
+				memcpy((void*) &dst[c],
+				       (const void*) &subtile->data[m*NEDGZ_SUBTILE_SIZE + n],
+				       count*sizeof(short));
+			}
+			else
+			{
+				nedgz_span_clear(&dst[c], count);
+			}
+			c += count;
+		}
+	}
+}
+
+int nedgz_tile_setregion(nedgz_tile_t* self,
+                         int r0, int c0,
+                         int rows, int cols,
+                         int stride, const short* data)
+{
+	assert(self);
+	assert(r0 >= 0);
+	assert(c0 >= 0);
+	assert(rows >= 0);
+	assert(cols >= 0);
+	assert((r0 + rows) <= NEDGZ_TILE_SIZE);
+	assert((c0 + cols) <= NEDGZ_TILE_SIZE);
+	assert(stride >= cols);
+	assert(data);
+	LOGD("debug r0=%i, c0=%i, rows=%i, cols=%i, stride=%i",
+	     r0, c0, rows, cols, stride);
+
+	// copy each row as spans which do not cross subtiles
+	// and only create subtiles for spans containing data
+	int r;
+	int c;
+	for(r = 0; r < rows; ++r)
+	{
+		int          i   = (r0 + r)/NEDGZ_SUBTILE_SIZE;
+		int          m   = (r0 + r)%NEDGZ_SUBTILE_SIZE;
+		const short* src = &data[r*stride];
+		for(c = 0; c < cols;)
+		{
+			int j     = (c0 + c)/NEDGZ_SUBTILE_SIZE;
+			int n     = (c0 + c)%NEDGZ_SUBTILE_SIZE;
+			int count = NEDGZ_SUBTILE_SIZE - n;
+			if(count > cols - c)
+			{
+				count = cols - c;
+			}
+
+			nedgz_subtile_t* subtile;
+			subtile = self->subtile[i*NEDGZ_SUBTILE_COUNT + j];
+			if((subtile == NULL) &&
+			   (nedgz_span_empty(&src[c], count) == 0))
+			{
+				subtile = nedgz_tile_newij(self, i, j);
+				if(subtile == NULL)
+				{
+					return 0;
+				}
+			}
+
+			if(subtile)
+			{
+				memcpy((void*) &subtile->data[m*NEDGZ_SUBTILE_SIZE + n],
+				       (const void*) &src[c],
+				       count*sizeof(short));
+			}
+			c += count;
+		}
+	}
+
+	return 1;
+}
+
+void nedgz_tile_getdata(nedgz_tile_t* self, short* data)
+{
+	assert(self);
+	assert(data);
+	LOGD("debug");
+
+	nedgz_tile_getregion(self, 0, 0,
+	                     NEDGZ_TILE_SIZE, NEDGZ_TILE_SIZE,
+	                     NEDGZ_TILE_SIZE, data);
+}
+
+int nedgz_tile_setdata(nedgz_tile_t* self, const short* data)
+{
+	assert(self);
+	assert(data);
+	LOGD("debug");
+
+	return nedgz_tile_setregion(self, 0, 0,
+	                            NEDGZ_TILE_SIZE, NEDGZ_TILE_SIZE,
+	                            NEDGZ_TILE_SIZE, data);
+}
+
 void nedgz_tile_coord(nedgz_tile_t* self,
                       int i, int j,
                       int m, int n,
@@ -28,6 +28,53 @@
 #define NEDGZ_SUBTILE_SIZE  32
 #define NEDGZ_NODATA        0
 
+// tile samples may also be addressed as a flat row-major
+// array of NEDGZ_TILE_SIZE x NEDGZ_TILE_SIZE shorts where
+// row r = i*NEDGZ_SUBTILE_SIZE + m and
+// col c = j*NEDGZ_SUBTILE_SIZE + n
+#define NEDGZ_TILE_SIZE (NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_SIZE)
+
+/***********************************************************
+* v1 files are a single gzip stream containing a short     *
+* count followed by {uchar i, uchar j, short data[]}       *
+* records for each subtile.                                *
+*                                                          *
+* v2 files contain an uncompressed header followed by      *
+* subtiles which are compressed as independent blocks so   *
+* that individual subtiles may be decoded with             *
+* nedgz_tile_importij.                                     *
+*                                                          *
+* header: int magic, int version                           *
+* table:  {int offset, int size}[64] (size 0 if missing)   *
+* blocks: compressed subtiles                              *
+*                                                          *
+* v3 files extend v2 with uncompressed metadata following  *
+* the version so that nedgz_tile_header may be read        *
+* without decoding the subtiles.                           *
+*                                                          *
+* meta:   short min, short max, int count,                 *
+*         ulonglong mask, short submin[64],                *
+*         short submax[64]                                 *
+*                                                          *
+* Blocks are compressed with zlib by default or with the   *
+* predictive elevation codec when NEDGZ_FLAG_PREDICT is    *
+* set. The version and codec are detected automatically    *
+* on import.                                               *
+***********************************************************/
+
+#define NEDGZ_MAGIC     0x5A44454E
+#define NEDGZ_VERSION_2 2
+#define NEDGZ_VERSION_3 3
+
+// export flags
+// tiles are written to fname.part and renamed when complete
+// NEDGZ_FLAG_FSYNC syncs the tile to disk before the rename
+// NEDGZ_FLAG_DEFER leaves the .part file for nedgz_batch
+#define NEDGZ_FLAG_V1      0x1
+#define NEDGZ_FLAG_PREDICT 0x2
+#define NEDGZ_FLAG_FSYNC   0x4
+#define NEDGZ_FLAG_DEFER   0x8
+
 // data units are measured in feet because the highest
 // point, Mt Everest is 29029 feet,  which matches up
 // nicely with range of shorts (-32768 to 32767)
@@ -44,20 +91,71 @@ typedef struct
 
 	// individual subtiles may be null when not defined
 	nedgz_subtile_t* subtile[NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT];
+
+	// bit i*NEDGZ_SUBTILE_COUNT + j is set for defined subtiles
+	unsigned long long mask;
+
+	// slab tiles back all subtiles with one contiguous
+	// allocation rather than allocating them individually
+	nedgz_subtile_t* slab;
 } nedgz_tile_t;
 
+// metadata stored in v3 headers where mask matches the
+// tile mask and min/max/submin/submax are NEDGZ_NODATA
+// when the tile or subtile does not contain any data
+typedef struct
+{
+	short              min;
+	short              max;
+	int                count;
+	unsigned long long mask;
+	short              submin[NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT];
+	short              submax[NEDGZ_SUBTILE_COUNT*NEDGZ_SUBTILE_COUNT];
+} nedgz_header_t;
+
 nedgz_tile_t*    nedgz_tile_new(int x, int y, int zoom);
+nedgz_tile_t*    nedgz_tile_newslab(int x, int y, int zoom);
 void             nedgz_tile_delete(nedgz_tile_t** _self);
+void             nedgz_tile_reset(nedgz_tile_t* self,
+                                  int x, int y, int zoom);
 nedgz_tile_t*    nedgz_tile_import(const char* base,
                                    int x, int y, int zoom);
+int              nedgz_tile_load(nedgz_tile_t* self,
+                                 const char* base);
+nedgz_tile_t*    nedgz_tile_importij(const char* base,
+                                     int x, int y, int zoom,
+                                     int i, int j);
+int              nedgz_tile_header(const char* base,
+                                   int x, int y, int zoom,
+                                   nedgz_header_t* header);
+int              nedgz_tile_valid(const char* base,
+                                  int x, int y, int zoom);
 int              nedgz_tile_export(nedgz_tile_t* self,
                                    const char* base);
+int              nedgz_tile_exportflags(nedgz_tile_t* self,
+                                        const char* base,
+                                        int flags);
 nedgz_subtile_t* nedgz_tile_getij(nedgz_tile_t* self,
                                   int i, int j);
+nedgz_subtile_t* nedgz_tile_newij(nedgz_tile_t* self,
+                                  int i, int j);
 int              nedgz_tile_set(nedgz_tile_t* self,
                                 int i, int j,
                                 int m, int n,
                                 short h);
+void             nedgz_tile_getregion(nedgz_tile_t* self,
+                                      int r0, int c0,
+                                      int rows, int cols,
+                                      int stride, short* data);
+int              nedgz_tile_setregion(nedgz_tile_t* self,
+                                      int r0, int c0,
+                                      int rows, int cols,
+                                      int stride,
+                                      const short* data);
+void             nedgz_tile_getdata(nedgz_tile_t* self,
+                                    short* data);
+int              nedgz_tile_setdata(nedgz_tile_t* self,
+                                    const short* data);
 void             nedgz_tile_coord(nedgz_tile_t* self,
                                   int i, int j,
                                   int m, int n,
@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <math.h>
+#include "nedgz_geom.h"
 #include "nedgz_tile.h"
 #include "nedgz_util.h"
 
@@ -57,17 +58,7 @@ void nedgz_subtile2coord(int x, int y, int zoom,
 	LOGD("debug x=%i, y=%i, zoom=%i, i=%i, j=%i, m=%i, n=%i",
 	     x, y, zoom, i, j, m, n);
 
-	float s  = (float) NEDGZ_SUBTILE_SIZE;
-	float c  = (float) NEDGZ_SUBTILE_COUNT;
-	float xx = (float) x;
-	float yy = (float) y;
-	float jj = (float) j;
-	float ii = (float) i;
-	float nn = (float) n/(s - 1.0f);
-	float mm = (float) m/(s - 1.0f);
-
-	nedgz_tile2coord(xx + (jj + nn)/c, yy + (ii + mm)/c,
-	                 zoom, lat, lon);
+	nedgz_geom32_coord(x, y, zoom, i, j, m, n, lat, lon);
 }
 
 void nedgz_coord2tile(double lat, double lon, int zoom, float* x, float* y)
@@ -88,6 +79,476 @@ void nedgz_coord2tile(double lat, double lon, int zoom, float* x, float* y)
 	*y             = (float) worldv*pow(2.0, (double) zoom)/NEDGZ_SUBTILE_COUNT;
 }
 
+void nedgz_tile2lonv(int count, const float* x, int zoom,
+                     double* lon)
+{
+	assert(x);
+	assert(lon);
+	LOGD("debug count=%i, zoom=%i", count, zoom);
+
+	// longitude is linear in x
+	double scale = NEDGZ_SUBTILE_COUNT/pow(2.0, (double) zoom);
+	int    k;
+	for(k = 0; k < count; ++k)
+	{
+		double worldu = scale*x[k];
+		double mercx  = 2.0*M_PI*worldu - M_PI;
+		lon[k]        = mercx/(M_PI/180.0);
+	}
+}
+
+void nedgz_tile2latv(int count, const float* y, int zoom,
+                     double* lat)
+{
+	assert(y);
+	assert(lat);
+	LOGD("debug count=%i, zoom=%i", count, zoom);
+
+	double scale = NEDGZ_SUBTILE_COUNT/pow(2.0, (double) zoom);
+	int    k;
+	for(k = 0; k < count; ++k)
+	{
+		double worldv  = scale*y[k];
+		double mercy   = M_PI - 2.0*M_PI*worldv;
+		double rad_lat = 2.0*atan(exp(mercy)) - M_PI/2.0;
+		lat[k]         = rad_lat/(M_PI/180.0);
+	}
+}
+
+void nedgz_subtile2coordv(int x, int y, int zoom,
+                          int i, int j, int size,
+                          double* lat, double* lon)
+{
+	assert(size > 1);
+	assert(size <= NEDGZ_COORDV_MAX);
+	assert(lat);
+	assert(lon);
+	LOGD("debug x=%i, y=%i, zoom=%i, i=%i, j=%i, size=%i",
+	     x, y, zoom, i, j, size);
+
+	// same sample positions as nedgz_subtile2coord where
+	// lat[m] is shared by row m and lon[n] by column n
+	float s  = (float) size;
+	float c  = (float) NEDGZ_SUBTILE_COUNT;
+	float xx = (float) x;
+	float yy = (float) y;
+	float jj = (float) j;
+	float ii = (float) i;
+
+	float u[NEDGZ_COORDV_MAX];
+	float v[NEDGZ_COORDV_MAX];
+	int   k;
+	for(k = 0; k < size; ++k)
+	{
+		float kk = (float) k/(s - 1.0f);
+		u[k] = xx + (jj + kk)/c;
+		v[k] = yy + (ii + kk)/c;
+	}
+
+	nedgz_tile2latv(size, v, zoom, lat);
+	nedgz_tile2lonv(size, u, zoom, lon);
+}
+
+void nedgz_lon2tilev(int count, const double* lon, int zoom,
+                     float* x)
+{
+	assert(lon);
+	assert(x);
+	LOGD("debug count=%i, zoom=%i", count, zoom);
+
+	double scale = pow(2.0, (double) zoom)/NEDGZ_SUBTILE_COUNT;
+	int    k;
+	for(k = 0; k < count; ++k)
+	{
+		double rad_lon = lon[k]*M_PI/180.0;
+		double worldu  = (rad_lon + M_PI)/(2.0*M_PI);
+		x[k]           = (float) worldu*scale;
+	}
+}
+
+void nedgz_lat2tilev(int count, const double* lat, int zoom,
+                     float* y)
+{
+	assert(lat);
+	assert(y);
+	LOGD("debug count=%i, zoom=%i", count, zoom);
+
+	double scale = pow(2.0, (double) zoom)/NEDGZ_SUBTILE_COUNT;
+	int    k;
+	for(k = 0; k < count; ++k)
+	{
+		double rad_lat = lat[k]*M_PI/180.0;
+		double mercy   = log(tan(rad_lat) + 1.0/cos(rad_lat));
+		double worldv  = (M_PI - mercy)/(2.0*M_PI);
+		y[k]           = (float) worldv*scale;
+	}
+}
+
+// tiles per axis is 2^(zoom - NEDGZ_LEVEL0) since each tile
+// has NEDGZ_SUBTILE_COUNT subtiles per axis
+#define NEDGZ_LEVEL0 3
+
+static unsigned long long nedgz_morton_spread(unsigned int v)
+{
+	unsigned long long x = v;
+	x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+	x = (x | (x << 8))  & 0x00FF00FF00FF00FFULL;
+	x = (x | (x << 4))  & 0x0F0F0F0F0F0F0F0FULL;
+	x = (x | (x << 2))  & 0x3333333333333333ULL;
+	x = (x | (x << 1))  & 0x5555555555555555ULL;
+	return x;
+}
+
+static unsigned int nedgz_morton_compact(unsigned long long x)
+{
+	x = x & 0x5555555555555555ULL;
+	x = (x | (x >> 1))  & 0x3333333333333333ULL;
+	x = (x | (x >> 2))  & 0x0F0F0F0F0F0F0F0FULL;
+	x = (x | (x >> 4))  & 0x00FF00FF00FF00FFULL;
+	x = (x | (x >> 8))  & 0x0000FFFF0000FFFFULL;
+	x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+	return (unsigned int) x;
+}
+
+static int nedgz_morton_levels(int x1, int y1)
+{
+	// smallest level whose node covers x1 and y1
+	int level = 0;
+	while((level < 30) &&
+	      (((1 << level) <= x1) || ((1 << level) <= y1)))
+	{
+		++level;
+	}
+	return level;
+}
+
+static int nedgz_morton_overlap(int x0, int y0, int x1, int y1,
+                                unsigned long long key, int level,
+                                int* contained)
+{
+	assert(contained);
+
+	// node covers nx0-nx1, ny0-ny1
+	int nx;
+	int ny;
+	nedgz_morton_decode(key, &nx, &ny);
+
+	int nx0 = nx << level;
+	int ny0 = ny << level;
+	int nx1 = nx0 + (1 << level) - 1;
+	int ny1 = ny0 + (1 << level) - 1;
+	if((nx0 > x1) || (nx1 < x0) || (ny0 > y1) || (ny1 < y0))
+	{
+		*contained = 0;
+		return 0;
+	}
+
+	*contained = (nx0 >= x0) && (nx1 <= x1) &&
+	             (ny0 >= y0) && (ny1 <= y1);
+	return 1;
+}
+
+static int nedgz_morton_rangesr(int x0, int y0, int x1, int y1,
+                                unsigned long long key, int level,
+                                int max_count, int* count,
+                                unsigned long long* ranges)
+{
+	assert(count);
+	assert(ranges);
+
+	int contained;
+	if(nedgz_morton_overlap(x0, y0, x1, y1, key, level,
+	                        &contained) == 0)
+	{
+		return 1;
+	}
+
+	if(contained)
+	{
+		unsigned long long begin = key << (2*level);
+		unsigned long long end   = begin + (1ULL << (2*level)) - 1;
+
+		// merge with the previous interval if contiguous
+		int n = *count;
+		if((n > 0) && (ranges[2*n - 1] + 1 == begin))
+		{
+			ranges[2*n - 1] = end;
+			return 1;
+		}
+
+		if(n == max_count)
+		{
+			return 0;
+		}
+
+		ranges[2*n]     = begin;
+		ranges[2*n + 1] = end;
+		*count          = n + 1;
+		return 1;
+	}
+
+	int q;
+	for(q = 0; q < 4; ++q)
+	{
+		if(nedgz_morton_rangesr(x0, y0, x1, y1,
+		                        nedgz_morton_child(key, q),
+		                        level - 1, max_count, count,
+		                        ranges) == 0)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+unsigned long long nedgz_morton_encode(int x, int y)
+{
+	assert(x >= 0);
+	assert(y >= 0);
+
+	return nedgz_morton_spread((unsigned int) x) |
+	       (nedgz_morton_spread((unsigned int) y) << 1);
+}
+
+void nedgz_morton_decode(unsigned long long key, int* x, int* y)
+{
+	assert(x);
+	assert(y);
+
+	*x = (int) nedgz_morton_compact(key);
+	*y = (int) nedgz_morton_compact(key >> 1);
+}
+
+unsigned long long nedgz_morton_parent(unsigned long long key)
+{
+	return key >> 2;
+}
+
+unsigned long long nedgz_morton_child(unsigned long long key, int q)
+{
+	assert((q >= 0) && (q < 4));
+
+	// q is 2*ybit + xbit
+	return (key << 2) | ((unsigned long long) q);
+}
+
+int nedgz_morton_neighbor(unsigned long long key,
+                          int zoom, int dx, int dy,
+                          unsigned long long* neighbor)
+{
+	assert(neighbor);
+	LOGD("debug key=0x%llX, zoom=%i, dx=%i, dy=%i",
+	     key, zoom, dx, dy);
+
+	int count = 1;
+	if(zoom > NEDGZ_LEVEL0)
+	{
+		count = 1 << (zoom - NEDGZ_LEVEL0);
+	}
+
+	int x;
+	int y;
+	nedgz_morton_decode(key, &x, &y);
+	x += dx;
+	y += dy;
+	if((x < 0) || (x >= count) || (y < 0) || (y >= count))
+	{
+		return 0;
+	}
+
+	*neighbor = nedgz_morton_encode(x, y);
+	return 1;
+}
+
+int nedgz_morton_ranges(int x0, int y0, int x1, int y1,
+                        int max_count,
+                        unsigned long long* ranges)
+{
+	assert(x0 >= 0);
+	assert(y0 >= 0);
+	assert(ranges);
+	LOGD("debug x0=%i, y0=%i, x1=%i, y1=%i, max_count=%i",
+	     x0, y0, x1, y1, max_count);
+
+	if((x1 < x0) || (y1 < y0))
+	{
+		return 0;
+	}
+
+	int count = 0;
+	int level = nedgz_morton_levels(x1, y1);
+	if(nedgz_morton_rangesr(x0, y0, x1, y1, 0ULL, level,
+	                        max_count, &count, ranges) == 0)
+	{
+		return -1;
+	}
+
+	return count;
+}
+
+int nedgz_quadkey_encode(int x, int y, int zoom, char* quadkey)
+{
+	assert(quadkey);
+	LOGD("debug x=%i, y=%i, zoom=%i", x, y, zoom);
+
+	int levels = zoom - NEDGZ_LEVEL0;
+	if((levels < 0) || (levels > 30) ||
+	   (x < 0) || (x >= (1 << levels)) ||
+	   (y < 0) || (y >= (1 << levels)))
+	{
+		LOGE("invalid x=%i, y=%i, zoom=%i", x, y, zoom);
+		return 0;
+	}
+
+	unsigned long long key = nedgz_morton_encode(x, y);
+	int i;
+	for(i = 0; i < levels; ++i)
+	{
+		int q = (int) ((key >> (2*(levels - i - 1))) & 3);
+		quadkey[i] = (char) ('0' + q);
+	}
+	quadkey[levels] = '\0';
+
+	return 1;
+}
+
+int nedgz_quadkey_decode(const char* quadkey,
+                         int* x, int* y, int* zoom)
+{
+	assert(quadkey);
+	assert(x);
+	assert(y);
+	assert(zoom);
+	LOGD("debug quadkey=%s", quadkey);
+
+	unsigned long long key = 0;
+	int levels = 0;
+	while(quadkey[levels] != '\0')
+	{
+		int q = quadkey[levels] - '0';
+		if((q < 0) || (q > 3) || (levels == 30))
+		{
+			LOGE("invalid quadkey=%s", quadkey);
+			return 0;
+		}
+
+		key = nedgz_morton_child(key, q);
+		++levels;
+	}
+
+	nedgz_morton_decode(key, x, y);
+	*zoom = levels + NEDGZ_LEVEL0;
+
+	return 1;
+}
+
+void nedgz_zorder_init(nedgz_zorder_t* self,
+                       int x0, int y0, int x1, int y1)
+{
+	assert(self);
+	assert(x0 >= 0);
+	assert(y0 >= 0);
+	LOGD("debug x0=%i, y0=%i, x1=%i, y1=%i", x0, y0, x1, y1);
+
+	self->x0    = x0;
+	self->y0    = y0;
+	self->x1    = x1;
+	self->y1    = y1;
+	self->count = 0;
+
+	if((x1 < x0) || (y1 < y0))
+	{
+		// empty range
+		return;
+	}
+
+	// push the root node
+	self->key[0]   = 0ULL;
+	self->level[0] = nedgz_morton_levels(x1, y1);
+	self->count    = 1;
+}
+
+void nedgz_zorder_initcoord(nedgz_zorder_t* self,
+                            double latT, double lonL,
+                            double latB, double lonR,
+                            int zoom)
+{
+	assert(self);
+	LOGD("debug latT=%lf, lonL=%lf, latB=%lf, lonR=%lf, zoom=%i",
+	     latT, lonL, latB, lonR, zoom);
+
+	float x0f;
+	float y0f;
+	float x1f;
+	float y1f;
+	nedgz_coord2tile(latT, lonL, zoom, &x0f, &y0f);
+	nedgz_coord2tile(latB, lonR, zoom, &x1f, &y1f);
+
+	// clamp the tiles which overlap the region
+	int count = 1;
+	if(zoom > NEDGZ_LEVEL0)
+	{
+		count = 1 << (zoom - NEDGZ_LEVEL0);
+	}
+
+	int x0 = (x0f < 0.0f) ? 0 : (int) x0f;
+	int y0 = (y0f < 0.0f) ? 0 : (int) y0f;
+	int x1 = (x1f < 0.0f) ? -1 : (int) x1f;
+	int y1 = (y1f < 0.0f) ? -1 : (int) y1f;
+	if(x1 >= count)
+	{
+		x1 = count - 1;
+	}
+	if(y1 >= count)
+	{
+		y1 = count - 1;
+	}
+
+	nedgz_zorder_init(self, x0, y0, x1, y1);
+}
+
+int nedgz_zorder_next(nedgz_zorder_t* self, int* x, int* y)
+{
+	assert(self);
+	assert(x);
+	assert(y);
+
+	while(self->count > 0)
+	{
+		--self->count;
+		unsigned long long key   = self->key[self->count];
+		int                level = self->level[self->count];
+
+		if(level == 0)
+		{
+			nedgz_morton_decode(key, x, y);
+			return 1;
+		}
+
+		// push the overlapping children in reverse order so
+		// that they are visited in Z-order
+		int q;
+		for(q = 3; q >= 0; --q)
+		{
+			int contained;
+			unsigned long long child = nedgz_morton_child(key, q);
+			if(nedgz_morton_overlap(self->x0, self->y0,
+			                        self->x1, self->y1,
+			                        child, level - 1,
+			                        &contained))
+			{
+				assert(self->count < NEDGZ_ZORDER_STACK);
+				self->key[self->count]   = child;
+				self->level[self->count] = level - 1;
+				++self->count;
+			}
+		}
+	}
+
+	return 0;
+}
+
 float nedgz_meters2feet(float m)
 {
 	return m*5280.0f/1609.344f;
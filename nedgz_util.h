@@ -29,6 +29,79 @@ void  nedgz_subtile2coord(int x, int y, int zoom,
                           int i, int j, int m, int n,
                           double* lat, double* lon);
 void  nedgz_coord2tile(double lat, double lon, int zoom, float* x, float* y);
+
+// batch transforms are separable since longitude only
+// depends on x and latitude only depends on y
+// nedgz_subtile2coordv computes lat[m] and lon[n] for the
+// size x size samples of subtile i,j
+#define NEDGZ_COORDV_MAX 256
+
+void  nedgz_tile2lonv(int count, const float* x, int zoom,
+                      double* lon);
+void  nedgz_tile2latv(int count, const float* y, int zoom,
+                      double* lat);
+void  nedgz_subtile2coordv(int x, int y, int zoom,
+                           int i, int j, int size,
+                           double* lat, double* lon);
+void  nedgz_lon2tilev(int count, const double* lon, int zoom,
+                      float* x);
+void  nedgz_lat2tilev(int count, const double* lat, int zoom,
+                      float* y);
+
+// Morton keys interleave the tile x bits (even) with the
+// tile y bits (odd) so that sorting by key walks the tiles
+// in Z-order and the parent of a key is key >> 2
+//
+// quadkeys are the base-4 digits of the Morton key with
+// one digit per level where zoom is the nedgz zoom and the
+// number of levels is zoom - 3 (NEDGZ_SUBTILE_COUNT tiles
+// per axis at zoom 3)
+//
+// nedgz_morton_ranges decomposes the tiles x0-x1, y0-y1
+// into at most max_count inclusive key intervals stored
+// as begin/end pairs and returns the number of intervals
+// or -1 if max_count was exceeded
+unsigned long long nedgz_morton_encode(int x, int y);
+void               nedgz_morton_decode(unsigned long long key,
+                                       int* x, int* y);
+unsigned long long nedgz_morton_parent(unsigned long long key);
+unsigned long long nedgz_morton_child(unsigned long long key,
+                                      int q);
+int                nedgz_morton_neighbor(unsigned long long key,
+                                         int zoom, int dx, int dy,
+                                         unsigned long long* neighbor);
+int                nedgz_morton_ranges(int x0, int y0,
+                                       int x1, int y1,
+                                       int max_count,
+                                       unsigned long long* ranges);
+int                nedgz_quadkey_encode(int x, int y, int zoom,
+                                        char* quadkey);
+int                nedgz_quadkey_decode(const char* quadkey,
+                                        int* x, int* y, int* zoom);
+
+// the Z-order iterator walks the tiles x0-x1, y0-y1 in
+// Morton key order without allocating memory
+#define NEDGZ_ZORDER_STACK 128
+
+typedef struct
+{
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+	int count;
+	unsigned long long key[NEDGZ_ZORDER_STACK];
+	int                level[NEDGZ_ZORDER_STACK];
+} nedgz_zorder_t;
+
+void nedgz_zorder_init(nedgz_zorder_t* self,
+                       int x0, int y0, int x1, int y1);
+void nedgz_zorder_initcoord(nedgz_zorder_t* self,
+                            double latT, double lonL,
+                            double latB, double lonR,
+                            int zoom);
+int  nedgz_zorder_next(nedgz_zorder_t* self, int* x, int* y);
+
 float nedgz_meters2feet(float m);
 float nedgz_feet2meters(float f);
 
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include "nedgz/nedgz_pack.h"
+#include "nedgz/nedgz_profile.h"
+#include "nedgz/nedgz_progress.h"
+#include "nedgz/nedgz_tile.h"
+
+#define LOG_TAG "nedpak"
+#include "nedgz/nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static int read_range(FILE* f, int* zoom,
+                      int* x0, int* y0, int* x1, int* y1)
+{
+	assert(f);
+	assert(zoom);
+	assert(x0);
+	assert(y0);
+	assert(x1);
+	assert(y1);
+	LOGD("debug");
+
+	char*  line  = NULL;
+	size_t n     = 0;
+	int    count = 0;
+	while(getline(&line, &n, f) > 0)
+	{
+		int x;
+		int y;
+		int z;
+		if(sscanf(line, "%i %i %i", &z, &x, &y) != 3)
+		{
+			LOGE("invalid line=%s", line);
+			continue;
+		}
+
+		if(count == 0)
+		{
+			*zoom = z;
+			*x0   = x;
+			*y0   = y;
+			*x1   = x;
+			*y1   = y;
+		}
+		else if(z != *zoom)
+		{
+			LOGE("invalid zoom=%i, expected %i", z, *zoom);
+			free(line);
+			return 0;
+		}
+
+		*x0 = (x < *x0) ? x : *x0;
+		*y0 = (y < *y0) ? y : *y0;
+		*x1 = (x > *x1) ? x : *x1;
+		*y1 = (y > *y1) ? y : *y1;
+		++count;
+	}
+	free(line);
+
+	return count;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int main(int argc, char** argv)
+{
+	// 1. to create the list for a single zoom level
+	//     cd ned
+	//     find 15 -name "*.nedgz" > ned15.list
+	// 2. trim list elements to "zoom x y"
+	// 3. to create the pack
+	//     cd ned
+	//     <path>/nedpak ned15.list 15.nedpak
+	if(argc != 3)
+	{
+		LOGE("usage: %s in.list out.nedpak", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	const char* lname = argv[1];
+	const char* pname = argv[2];
+
+	// open the list
+	FILE* f = fopen(lname, "r");
+	if(f == NULL)
+	{
+		LOGE("failed to open %s", lname);
+		return EXIT_FAILURE;
+	}
+
+	// determine the range of the pack
+	int zoom = 0;
+	int x0   = 0;
+	int y0   = 0;
+	int x1   = 0;
+	int y1   = 0;
+	int count = read_range(f, &zoom, &x0, &y0, &x1, &y1);
+	if(count == 0)
+	{
+		LOGE("invalid %s", lname);
+		goto fail_range;
+	}
+
+	nedgz_progress_t* progress = nedgz_progress_new("nedpak", count);
+	if(progress == NULL)
+	{
+		goto fail_progress;
+	}
+	int stage_import = nedgz_progress_stage(progress, "import");
+	int stage_add    = nedgz_progress_stage(progress, "add");
+
+	nedgz_pack_t* pack = nedgz_pack_create(pname, zoom,
+	                                       x0, y0, x1, y1);
+	if(pack == NULL)
+	{
+		goto fail_pack;
+	}
+
+	// iteratively add tiles to the pack
+	rewind(f);
+	char*  line  = NULL;
+	size_t n     = 0;
+	char   fname[256];
+	while(getline(&line, &n, f) > 0)
+	{
+		int x;
+		int y;
+		if(sscanf(line, "%i %i %i", &zoom, &x, &y) != 3)
+		{
+			continue;
+		}
+
+		LOGD("debug zoom=%i, x=%i, y=%i", zoom, x, y);
+
+		double t0 = nedgz_progress_begin(progress);
+		nedgz_tile_t* ned = nedgz_tile_import(".", x, y, zoom);
+		if(ned == NULL)
+		{
+			LOGE("invalid line=%s", line);
+			nedgz_progress_fail(progress, 1);
+			continue;
+		}
+		snprintf(fname, 256, "%i/%i_%i.nedgz", zoom, x, y);
+		nedgz_progress_readfile(progress, fname);
+		nedgz_progress_end(progress, stage_import, t0);
+
+		t0 = nedgz_progress_begin(progress);
+		NEDGZ_PROFILE_BEGIN(nedpak_add);
+		int added = nedgz_pack_add(pack, ned);
+		nedgz_tile_delete(&ned);
+		NEDGZ_PROFILE_END(nedpak_add);
+		if(added == 0)
+		{
+			goto fail_add;
+		}
+		nedgz_progress_end(progress, stage_add, t0);
+		nedgz_progress_done(progress, 1);
+	}
+	free(line);
+
+	if(nedgz_pack_close(&pack) == 0)
+	{
+		goto fail_close;
+	}
+	nedgz_progress_writefile(progress, pname);
+	nedgz_progress_delete(&progress);
+	fclose(f);
+
+	// success
+	return EXIT_SUCCESS;
+
+	// failure
+	fail_add:
+		free(line);
+		nedgz_pack_close(&pack);
+	fail_close:
+	fail_pack:
+		nedgz_progress_delete(&progress);
+	fail_progress:
+	fail_range:
+		fclose(f);
+	return EXIT_FAILURE;
+}
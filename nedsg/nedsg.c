@@ -24,9 +24,13 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
-#include <math.h>
 #include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "nedgz/nedgz_profile.h"
+#include "nedgz/nedgz_progress.h"
 #include "nedgz/nedgz_scene.h"
+#include "nedgz/nedgz_scenearray.h"
 #include "nedgz/nedgz_tile.h"
 #include "nedgz/nedgz_util.h"
 
@@ -37,14 +41,41 @@
 * private                                                  *
 ***********************************************************/
 
+#define NEDSG_THREADS 64
+
+typedef struct
+{
+	FILE*  f;
+	char*  line;
+	size_t n;
+	int    usened;
+
+	nedgz_progress_t* progress;
+	int               stage_insert;
+
+	pthread_mutex_t mutex;
+} nedsg_state_t;
+
+// each worker inserts the tiles it reads into a partial
+// scene graph which is stitched into the scene once the
+// workers have finished
+typedef struct
+{
+	nedsg_state_t* state;
+	pthread_t      thread;
+	int            running;
+	nedgz_scene_t* scene;
+} nedsg_worker_t;
+
 static nedgz_scene_t* make_scene(nedgz_scene_t** _node,
                                  int fsize,
                                  int x,  int y,  int zoom,
-                                 nedgz_tile_t* ned)
+                                 int tx, int ty, int tzoom,
+                                 nedgz_header_t* header)
 {
 	// *_node may be NULL for new leaf nodes
+	// header may be NULL when min/max is unknown
 	assert(_node);
-	assert(ned);
 	LOGD("debug x=%i, y=%i, zoom=%i", x, y, zoom);
 
 	// when traversing to a new leaf create the node
@@ -61,43 +92,21 @@ static nedgz_scene_t* make_scene(nedgz_scene_t** _node,
 
 	// when traversing the scene the only way to reach
 	// the same zoom is when the node is the one we want
-	if(zoom == ned->zoom)
+	if(zoom == tzoom)
 	{
-		// compute the min/max height
-		int i;
-		int j;
-		int m;
-		int n;
-		short height;
-		for(i = 0; i < NEDGZ_SUBTILE_COUNT; ++i)
+		// update the min/max height
+		if(header && header->count)
 		{
-			for(j = 0; j < NEDGZ_SUBTILE_COUNT; ++j)
+			if((node->min == NEDGZ_NODATA) ||
+			   (node->min > header->min))
 			{
-				for(m = 0; m < NEDGZ_SUBTILE_SIZE; ++m)
-				{
-					for(n = 0; n < NEDGZ_SUBTILE_SIZE; ++n)
-					{
-						nedgz_tile_height(ned, i, j, m, n, &height);
-
-						if(height == NEDGZ_NODATA)
-						{
-							// ignore
-							continue;
-						}
-
-						if((node->min == NEDGZ_NODATA) ||
-						   (node->min > height))
-						{
-							node->min = height;
-						}
-
-						if((node->max == NEDGZ_NODATA) ||
-						   (node->max < height))
-						{
-							node->max = height;
-						}
-					}
-				}
+				node->min = header->min;
+			}
+
+			if((node->max == NEDGZ_NODATA) ||
+			   (node->max < header->max))
+			{
+				node->max = header->max;
 			}
 		}
 
@@ -111,9 +120,9 @@ static nedgz_scene_t* make_scene(nedgz_scene_t** _node,
 	int next_x    = 2*x;
 	int next_y    = 2*y;
 	int next_zoom = zoom + 1;
-	int s         = (int) powl(2, ned->zoom - next_zoom);
-	x             = ned->x / s;
-	y             = ned->y / s;
+	int s         = tzoom - next_zoom;
+	x             = tx >> s;
+	y             = ty >> s;
 	zoom          = next_zoom;
 
 	nedgz_scene_t** next;
@@ -136,11 +145,142 @@ static nedgz_scene_t* make_scene(nedgz_scene_t** _node,
 	else
 	{
 		LOGE("failed to traverse from %i,%i,%i to %i,%i,%i",
-		     x, y, zoom, ned->x, ned->y, ned->zoom);
+		     x, y, zoom, tx, ty, tzoom);
 		return NULL;
 	}
 
-	return make_scene(next, fsize, x, y, zoom, ned);
+	return make_scene(next, fsize, x, y, zoom,
+	                  tx, ty, tzoom, header);
+}
+
+static void merge_scene(nedgz_scene_t** _dst, nedgz_scene_t* src)
+{
+	// src is consumed by the merge
+	assert(_dst);
+	LOGD("debug");
+
+	if(src == NULL)
+	{
+		return;
+	}
+
+	// subtrees which only exist in src are moved as is
+	nedgz_scene_t* dst = *_dst;
+	if(dst == NULL)
+	{
+		*_dst = src;
+		return;
+	}
+
+	if(src->exists)
+	{
+		dst->exists = 1;
+		dst->fsize  = src->fsize;
+	}
+
+	if((src->min != NEDGZ_NODATA) &&
+	   ((dst->min == NEDGZ_NODATA) || (dst->min > src->min)))
+	{
+		dst->min = src->min;
+	}
+
+	if((src->max != NEDGZ_NODATA) &&
+	   ((dst->max == NEDGZ_NODATA) || (dst->max < src->max)))
+	{
+		dst->max = src->max;
+	}
+
+	merge_scene(&dst->tl, src->tl);
+	merge_scene(&dst->tr, src->tr);
+	merge_scene(&dst->bl, src->bl);
+	merge_scene(&dst->br, src->br);
+
+	src->tl = NULL;
+	src->tr = NULL;
+	src->bl = NULL;
+	src->br = NULL;
+	nedgz_scene_delete(&src);
+}
+
+static int getnode(nedsg_state_t* state, int* x, int* y, int* zoom)
+{
+	assert(state);
+	assert(x);
+	assert(y);
+	assert(zoom);
+	LOGD("debug");
+
+	pthread_mutex_lock(&state->mutex);
+	while(getline(&state->line, &state->n, state->f) > 0)
+	{
+		if(sscanf(state->line, "%i %i %i", zoom, x, y) == 3)
+		{
+			pthread_mutex_unlock(&state->mutex);
+			return 1;
+		}
+
+		LOGE("invalid line=%s", state->line);
+		nedgz_progress_fail(state->progress, 1);
+	}
+	pthread_mutex_unlock(&state->mutex);
+
+	return 0;
+}
+
+static void* run_worker(void* arg)
+{
+	assert(arg);
+	LOGD("debug");
+
+	nedsg_worker_t* worker = (nedsg_worker_t*) arg;
+	nedsg_state_t*  state  = worker->state;
+
+	int x;
+	int y;
+	int zoom;
+	while(getnode(state, &x, &y, &zoom))
+	{
+		LOGD("debug zoom=%i, x=%i, y=%i", zoom, x, y);
+		double t0 = nedgz_progress_begin(state->progress);
+
+		// the nedgz header provides the min/max height
+		// without decoding the tile
+		char            fname[256];
+		nedgz_header_t  header;
+		nedgz_header_t* hdr = NULL;
+		if(state->usened)
+		{
+			if(nedgz_tile_header(".", x, y, zoom, &header) == 0)
+			{
+				LOGE("invalid zoom=%i, x=%i, y=%i", zoom, x, y);
+				nedgz_progress_fail(state->progress, 1);
+				continue;
+			}
+			hdr = &header;
+			snprintf(fname, 256, "%i/%i_%i.nedgz", zoom, x, y);
+		}
+		else
+		{
+			snprintf(fname, 256, "%i/%i_%i.pak", zoom, x, y);
+		}
+
+		int         fsize = 0;
+		struct stat st;
+		if(stat(fname, &st) == 0)
+		{
+			fsize = (int) st.st_size;
+		}
+
+		NEDGZ_PROFILE_BEGIN(nedsg_insert);
+		make_scene(&worker->scene, fsize, 0, 0, 0,
+		           x, y, zoom, hdr);
+		NEDGZ_PROFILE_END(nedsg_insert);
+		nedgz_progress_read(state->progress, (long long) fsize);
+		nedgz_progress_end(state->progress, state->stage_insert, t0);
+		nedgz_progress_done(state->progress, 1);
+	}
+
+	return NULL;
 }
 
 static void nedgz_scene_fixheight(nedgz_scene_t* self, short* min, short* max)
@@ -194,100 +334,161 @@ int main(int argc, char** argv)
 	// 4. to create scene graph for osm/blue/etc.
 	//     cd osm
 	//     <path>/nedsg osm.list osm.sg
-	if((argc < 3) || (argc > 4))
+	// 5. to create a v2 scene graph which may be mapped
+	//    by nedgz_scenearray_import
+	//     <path>/nedsg -v2 -ned ned.list ned.sg
+	// 6. to read the tiles with 8 threads
+	//     <path>/nedsg -j 8 -ned ned.list ned.sg
+	const char* argv0  = argv[0];
+	int         usened = 0;
+	int         usev2  = 0;
+	int         jobs   = 1;
+	while((argc > 1) && (argv[1][0] == '-'))
 	{
-		LOGE("usage: %s [-ned] in.list out.sg", argv[0]);
-		LOGE("-ned: import nedgz file for min/max height");
-		return EXIT_FAILURE;
+		if(strcmp(argv[1], "-ned") == 0)
+		{
+			usened = 1;
+		}
+		else if(strcmp(argv[1], "-v2") == 0)
+		{
+			usev2 = 1;
+		}
+		else if((strcmp(argv[1], "-j") == 0) && (argc > 2))
+		{
+			jobs = (int) strtol(argv[2], NULL, 0);
+			--argc;
+			++argv;
+		}
+		else
+		{
+			break;
+		}
+		--argc;
+		++argv;
 	}
 
-	int   usened = 0;
-	char* lname  = argv[1];
-	char* sname  = argv[2];
-	if(argc == 4)
+	if((argc != 3) || (jobs < 1) || (jobs > NEDSG_THREADS))
 	{
-		usened = 1;
-		lname  = argv[2];
-		sname  = argv[3];
-
-		if(strcmp(argv[1], "-ned") != 0)
-		{
-			LOGE("usage: %s [-ned] in.list out.sg", argv[0]);
-			return EXIT_FAILURE;
-		}
+		LOGE("usage: %s [-j jobs] [-v2] [-ned] in.list out.sg", argv0);
+		LOGE("-j: number of threads to read the tiles (1-%i)",
+		     NEDSG_THREADS);
+		LOGE("-v2: write the v2 scene array format");
+		LOGE("-ned: read nedgz header for min/max height");
+		return EXIT_FAILURE;
 	}
 
+	char* lname = argv[1];
+	char* sname = argv[2];
+
+	nedsg_state_t state;
+	memset((void*) &state, 0, sizeof(nedsg_state_t));
+	state.usened = usened;
+
 	// open the list
-	FILE* f = fopen(lname, "r");
-	if(f == NULL)
+	state.f = fopen(lname, "r");
+	if(state.f == NULL)
 	{
 		LOGE("failed to open %s", lname);
 		return EXIT_FAILURE;
 	}
 
-	// iteratively add nodes to the scene graph
-	char*          line  = NULL;
-	size_t         n     = 0;
-	int            index = 0;
-	nedgz_scene_t* scene = NULL;
-	while(getline(&line, &n, f) > 0)
+	// count the nodes for the progress
+	int count = 0;
+	while(getline(&state.line, &state.n, state.f) > 0)
 	{
-		int x;
-		int y;
-		int zoom;
-		if(sscanf(line, "%i %i %i", &zoom, &x, &y) != 3)
-		{
-			LOGE("invalid line=%s", line);
-			continue;
-		}
+		++count;
+	}
+	rewind(state.f);
+
+	state.progress = nedgz_progress_new("nedsg", count);
+	if(state.progress == NULL)
+	{
+		goto fail_progress;
+	}
+	state.stage_insert = nedgz_progress_stage(state.progress, "insert");
+	int stage_merge    = nedgz_progress_stage(state.progress, "merge");
+	int stage_export   = nedgz_progress_stage(state.progress, "export");
 
-		LOGI("%i: %i %i %i", ++index, zoom, x, y);
+	if(pthread_mutex_init(&state.mutex, NULL) != 0)
+	{
+		LOGE("pthread_mutex_init failed");
+		goto fail_mutex;
+	}
 
-		char          fname[256];
-		nedgz_tile_t* ned;
-		if(usened)
-		{
-			ned = nedgz_tile_import(".", x, y, zoom);
-			snprintf(fname, 256, "%i/%i_%i.nedgz", zoom, x, y);
-		}
-		else
-		{
-			ned = nedgz_tile_new(x, y, zoom);
-			snprintf(fname, 256, "%i/%i_%i.pak", zoom, x, y);
-		}
+	// the workers read the tiles and build partial scenes
+	// where the main thread is the first worker
+	int            i;
+	nedsg_worker_t worker[NEDSG_THREADS];
+	memset((void*) worker, 0, sizeof(worker));
+	for(i = 0; i < jobs; ++i)
+	{
+		worker[i].state = &state;
+	}
 
-		if(ned == NULL)
+	for(i = 1; i < jobs; ++i)
+	{
+		if(pthread_create(&worker[i].thread, NULL, run_worker,
+		                  (void*) &worker[i]) != 0)
 		{
-			LOGE("invalid line=%s", line);
+			LOGW("pthread_create failed");
 			continue;
 		}
+		worker[i].running = 1;
+	}
+	run_worker((void*) &worker[0]);
 
-		int   fsize = 0;
-		FILE* f     = fopen(fname, "r");
-		if(f)
+	for(i = 1; i < jobs; ++i)
+	{
+		if(worker[i].running)
 		{
-			fseek(f, 0, SEEK_END);
-			fsize = (int) ftell(f);
-			if(fsize < 0)
-			{
-				LOGE("failed line=%s", line);
-				fsize = 0;
-			}
-			fclose(f);
+			pthread_join(worker[i].thread, NULL);
 		}
+	}
 
-		make_scene(&scene, fsize, 0, 0, 0, ned);
-		nedgz_tile_delete(&ned);
+	// stitch the partial scenes
+	double         t0    = nedgz_progress_begin(state.progress);
+	nedgz_scene_t* scene = worker[0].scene;
+	for(i = 1; i < jobs; ++i)
+	{
+		merge_scene(&scene, worker[i].scene);
 	}
-	free(line);
+	nedgz_progress_end(state.progress, stage_merge, t0);
 
 	// fix min/max heights across LOD
 	short min = NEDGZ_NODATA;
 	short max = NEDGZ_NODATA;
 	nedgz_scene_fixheight(scene, &min, &max);
 
-	nedgz_scene_export(scene, sname);
+	t0 = nedgz_progress_begin(state.progress);
+	if(usev2 && scene)
+	{
+		nedgz_scenearray_t* array = nedgz_scenearray_new(scene);
+		if(array)
+		{
+			nedgz_scenearray_export(array, sname);
+			nedgz_scenearray_delete(&array);
+		}
+	}
+	else
+	{
+		nedgz_scene_export(scene, sname);
+	}
 	nedgz_scene_delete(&scene);
-
+	nedgz_progress_writefile(state.progress, sname);
+	nedgz_progress_end(state.progress, stage_export, t0);
+	pthread_mutex_destroy(&state.mutex);
+	nedgz_progress_delete(&state.progress);
+	free(state.line);
+	fclose(state.f);
+
+	// success
 	return EXIT_SUCCESS;
+
+	// failure
+	fail_mutex:
+		nedgz_progress_delete(&state.progress);
+	fail_progress:
+		free(state.line);
+		fclose(state.f);
+	return EXIT_FAILURE;
 }
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2013 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "nedgz/nedgz_pack.h"
+#include "nedgz/nedgz_scene.h"
+#include "nedgz/nedgz_scenearray.h"
+
+#define LOG_TAG "nedtest"
+#include "nedgz/nedgz_log.h"
+
+#define NEDTEST_FNAME "nedtest.tmp"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static int write_file(const char* fname, const void* data, size_t size)
+{
+	assert(fname);
+	LOGD("debug fname=%s, size=%i", fname, (int) size);
+
+	FILE* f = fopen(fname, "w");
+	if(f == NULL)
+	{
+		LOGE("fopen %s failed", fname);
+		return 0;
+	}
+
+	if(size && (fwrite(data, size, 1, f) != 1))
+	{
+		LOGE("fwrite %s failed", fname);
+		fclose(f);
+		return 0;
+	}
+	fclose(f);
+
+	return 1;
+}
+
+// both importers must reject a file with the v2 magic and
+// an invalid header without recursing into each other
+static int test_scene_truncated(void)
+{
+	LOGD("debug");
+
+	int header[4] =
+	{
+		NEDGZ_SCENEARRAY_MAGIC, NEDGZ_SCENEARRAY_VERSION, 1, 0
+	};
+
+	int ret = 1;
+	int size;
+	for(size = sizeof(int); size <= sizeof(header); size += sizeof(int))
+	{
+		if(write_file(NEDTEST_FNAME, header, size) == 0)
+		{
+			return 0;
+		}
+
+		nedgz_scene_t* scene = nedgz_scene_import(NEDTEST_FNAME);
+		if(scene)
+		{
+			LOGE("nedgz_scene_import accepted size=%i", size);
+			nedgz_scene_delete(&scene);
+			ret = 0;
+		}
+
+		nedgz_scenearray_t* array;
+		array = nedgz_scenearray_import(NEDTEST_FNAME);
+		if(array)
+		{
+			LOGE("nedgz_scenearray_import accepted size=%i", size);
+			nedgz_scenearray_delete(&array);
+			ret = 0;
+		}
+	}
+	unlink(NEDTEST_FNAME);
+
+	return ret;
+}
+
+static int test_scene_roundtrip(void)
+{
+	LOGD("debug");
+
+	nedgz_scene_t* scene = nedgz_scene_new();
+	if(scene == NULL)
+	{
+		return 0;
+	}
+	scene->tl = nedgz_scene_new();
+	if(scene->tl == NULL)
+	{
+		goto fail_tl;
+	}
+	scene->tl->exists = 1;
+	scene->tl->fsize  = 1234;
+
+	nedgz_scenearray_t* array = nedgz_scenearray_new(scene);
+	if((array == NULL) ||
+	   (nedgz_scenearray_export(array, NEDTEST_FNAME) == 0))
+	{
+		goto fail_export;
+	}
+	nedgz_scenearray_delete(&array);
+	nedgz_scene_delete(&scene);
+
+	scene = nedgz_scene_import(NEDTEST_FNAME);
+	unlink(NEDTEST_FNAME);
+	if((scene == NULL) || (scene->tl == NULL) ||
+	   (scene->tl->exists == 0) || (scene->tl->fsize != 1234))
+	{
+		LOGE("invalid v2 roundtrip");
+		nedgz_scene_delete(&scene);
+		return 0;
+	}
+	nedgz_scene_delete(&scene);
+
+	// success
+	return 1;
+
+	// failure
+	fail_export:
+		nedgz_scenearray_delete(&array);
+		unlink(NEDTEST_FNAME);
+	fail_tl:
+		nedgz_scene_delete(&scene);
+	return 0;
+}
+
+// a pack must not exist under fname until it is closed
+static int test_pack_part(void)
+{
+	LOGD("debug");
+
+	unlink(NEDTEST_FNAME);
+	nedgz_pack_t* pack = nedgz_pack_create(NEDTEST_FNAME, 1,
+	                                       0, 0, 1, 1);
+	if(pack == NULL)
+	{
+		return 0;
+	}
+
+	if((access(NEDTEST_FNAME, F_OK) == 0) ||
+	   (access(NEDTEST_FNAME ".part", F_OK) != 0))
+	{
+		LOGE("invalid part");
+		goto fail_part;
+	}
+
+	if(nedgz_pack_close(&pack) == 0)
+	{
+		goto fail_close;
+	}
+
+	if(access(NEDTEST_FNAME ".part", F_OK) == 0)
+	{
+		LOGE("invalid rename");
+		goto fail_rename;
+	}
+
+	pack = nedgz_pack_open(NEDTEST_FNAME);
+	if(pack == NULL)
+	{
+		goto fail_open;
+	}
+	nedgz_pack_close(&pack);
+	unlink(NEDTEST_FNAME);
+
+	// success
+	return 1;
+
+	// failure
+	fail_part:
+		nedgz_pack_close(&pack);
+	fail_close:
+	fail_rename:
+	fail_open:
+		unlink(NEDTEST_FNAME ".part");
+		unlink(NEDTEST_FNAME);
+	return 0;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int main(int argc, char** argv)
+{
+	// nedtest runs the regression tests for the nedgz
+	// library in the current directory
+	//     make check
+	int ok = 1;
+	ok &= test_scene_truncated();
+	ok &= test_scene_roundtrip();
+	ok &= test_pack_part();
+	if(ok == 0)
+	{
+		LOGE("FAILED");
+		return EXIT_FAILURE;
+	}
+
+	LOGI("PASSED");
+	return EXIT_SUCCESS;
+}
@@ -32,51 +32,14 @@
 #include <sys/types.h>
 #include "texgz/texgz_tex.h"
 #include "texgz/texgz_png.h"
+#include "nedgz/nedgz_path.h"
+#include "nedgz/nedgz_progress.h"
 
 #define LOG_TAG "subbluemarble"
 #include "nedgz/nedgz_log.h"
 
 #define SUBTILE_SIZE 256
 
-static int mymkdir(const char* fname)
-{
-	assert(fname);
-
-	int  len = strnlen(fname, 255);
-	char dir[256];
-	int  i;
-	for(i = 0; i < len; ++i)
-	{
-		dir[i]     = fname[i];
-		dir[i + 1] = '\0';
-
-		if(dir[i] == '/')
-		{
-			if(access(dir, R_OK) == 0)
-			{
-				// dir already exists
-				continue;
-			}
-
-			// try to mkdir
-			if(mkdir(dir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
-			{
-				if(errno == EEXIST)
-				{
-					// already exists
-				}
-				else
-				{
-					LOGE("mkdir %s failed", dir);
-					return 0;
-				}
-			}
-		}
-	}
-
-	return 1;
-}
-
 static void sample_subtile(texgz_tex_t* dst, texgz_tex_t* src,
                            int m, int n, int m0, int n0)
 {
@@ -212,8 +175,12 @@ static void sample_tile(texgz_tex_t* dst,
 	snprintf(fname, 256, "png256/%i/%i/%i/%i.png",
 	         month, zoom, x, y);
 	fname[255] = '\0';
-	mymkdir(fname);
-	texgz_png_export(dst, fname);
+	nedgz_path_mkdir(fname);
+	if((texgz_png_export(dst, fname) == 0) &&
+	   nedgz_path_retry(fname))
+	{
+		texgz_png_export(dst, fname);
+	}
 
 	texgz_tex_delete(&src11);
 	texgz_tex_delete(&src10);
@@ -232,6 +199,9 @@ static void sample_tile(texgz_tex_t* dst,
 		texgz_tex_delete(&src00);
 }
 
+// reports tiles/sec and the ETA
+static nedgz_progress_t* progress = NULL;
+
 static void sample_tile_range(texgz_tex_t* dst,
                               int month, int zoom,
                               int x0, int y0, int x1, int y1)
@@ -240,20 +210,12 @@ static void sample_tile_range(texgz_tex_t* dst,
 
 	int x;
 	int y;
-	int idx   = 0;
-	int count = (x1 - x0)*(y1 - y0);
 	for(y = y0; y < y1; ++y)
 	{
 		for(x = x0; x < x1; ++x)
 		{
-			++idx;
-			if((x%8 == 0) && (y%8 == 0))
-			{
-				LOGI("%i: %i/%i: zoom=%i, x=%i, y=%i",
-				     month, idx, count, zoom, x, y);
-			}
-
 			sample_tile(dst, month, zoom, x, y);
+			nedgz_progress_done(progress, 1);
 		}
 	}
 }
@@ -276,6 +238,15 @@ int main(int argc, char** argv)
 		return EXIT_FAILURE;
 	}
 
+	// zoom levels 8 to 0 contain (4^9 - 1)/3 tiles per month
+	progress = nedgz_progress_new("subbluemarble",
+	                              12*(262144 - 1)/3);
+	if(progress == NULL)
+	{
+		texgz_tex_delete(&dst);
+		return EXIT_FAILURE;
+	}
+
 	// sample remaining zoom levels
 	int zoom;
 	for(zoom = 8; zoom >=0; --zoom)
@@ -293,6 +264,7 @@ int main(int argc, char** argv)
 		}
 	}
 
+	nedgz_progress_delete(&progress);
 	texgz_tex_delete(&dst);
 
 	// success
@@ -29,6 +29,10 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include "nedgz/nedgz_tile.h"
+#include "nedgz/nedgz_geom.h"
+#include "nedgz/nedgz_path.h"
+#include "nedgz/nedgz_profile.h"
+#include "nedgz/nedgz_progress.h"
 #include "nedgz/nedgz_util.h"
 #include "texgz/texgz_tex.h"
 #include "libpak/pak_file.h"
@@ -36,61 +40,10 @@
 #define LOG_TAG "subheightmap"
 #include "nedgz/nedgz_log.h"
 
-#define SUBTILE_SIZE 256
+#define SUBTILE_SIZE NEDGZ_GEOM256_SIZE
 
-static short interpolateh(texgz_tex_t* tex, float u, float v)
-{
-	assert(tex);
-	LOGD("debug u=%f, v=%f", u, v);
-
-	// "float indices"
-	float pu = u*(SUBTILE_SIZE - 1);
-	float pv = v*(SUBTILE_SIZE - 1);
-
-	// determine indices to sample
-	int u0 = (int) pu;
-	int v0 = (int) pv;
-	int u1 = u0 + 1;
-	int v1 = v0 + 1;
-
-	// double check the indices
-	if(u0 < 0)
-	{
-		u0 = 0;
-	}
-	if(u1 >= SUBTILE_SIZE)
-	{
-		u1 = SUBTILE_SIZE - 1;
-	}
-	if(v0 < 0)
-	{
-		v0 = 0;
-	}
-	if(v1 >= SUBTILE_SIZE)
-	{
-		v1 = SUBTILE_SIZE - 1;
-	}
-
-	// compute interpolation coordinates
-	float u0f = (float) u0;
-	float v0f = (float) v0;
-	float uf    = pu - u0f;
-	float vf    = pv - v0f;
-
-	// sample interpolation values
-	short* pixels = (short*) tex->pixels;
-	float h00   = (float) pixels[v0*SUBTILE_SIZE + u0];
-	float h01   = (float) pixels[v1*SUBTILE_SIZE + u0];
-	float h10   = (float) pixels[v0*SUBTILE_SIZE + u1];
-	float h11   = (float) pixels[v1*SUBTILE_SIZE + u1];
-
-	// interpolate u
-	float h0010 = h00 + uf*(h10 - h00);
-	float h0111 = h01 + uf*(h11 - h01);
-
-	// interpolate v
-	return (short) (h0010 + vf*(h0111 - h0010) + 0.5f);
-}
+// reports tiles/sec and the ETA
+static nedgz_progress_t* progress = NULL;
 
 static void sample_subtile(pak_file_t* pak, pak_file_t* subpak, int i, int j)
 {
@@ -111,96 +64,31 @@ static void sample_subtile(pak_file_t* pak, pak_file_t* subpak, int i, int j)
 		return;
 	}
 
-	// sample the 00-quadrant
-	int          m;
-	int          n;
+	// each quadrant of the dst subtile is sampled from
+	// one of the four corresponding src subtiles
+	int          qi;
+	int          qj;
 	int          size;
 	texgz_tex_t* subtex;
-	int          half = SUBTILE_SIZE/2;
 	int          iprime = (2*i)%NEDGZ_SUBTILE_COUNT;
 	int          jprime = (2*j)%NEDGZ_SUBTILE_COUNT;
 	char         fname[256];
-	snprintf(fname, 256, "%i_%i", jprime, iprime);
-	size = pak_file_seek(subpak, fname);
-	subtex = (size > 0) ? texgz_tex_importf(subpak->f, size) : NULL;
-	if(subtex)
-	{
-		for(m = 0; m < half; ++m)
-		{
-			for(n = 0; n < half; ++n)
-			{
-				// scale uv coords for 00-quadrant
-				float u = 2.0f*((float) n)/((float) SUBTILE_SIZE - 1.0f);
-				float v = 2.0f*((float) m)/((float) SUBTILE_SIZE - 1.0f);
-
-				short* pixels = (short*) tex->pixels;
-				pixels[m*SUBTILE_SIZE + n] = interpolateh(subtex, u, v);
-			}
-		}
-		texgz_tex_delete(&subtex);
-	}
-
-	// sample the 01-quadrant
-	snprintf(fname, 256, "%i_%i", jprime, iprime + 1);
-	size = pak_file_seek(subpak, fname);
-	subtex = (size > 0) ? texgz_tex_importf(subpak->f, size) : NULL;
-	if(subtex)
+	for(qi = 0; qi < 2; ++qi)
 	{
-		for(m = half; m < SUBTILE_SIZE; ++m)
+		for(qj = 0; qj < 2; ++qj)
 		{
-			for(n = 0; n < half; ++n)
+			snprintf(fname, 256, "%i_%i", jprime + qj, iprime + qi);
+			size = pak_file_seek(subpak, fname);
+			subtex = (size > 0) ? texgz_tex_importf(subpak->f, size) : NULL;
+			if(subtex)
 			{
-				// scale uv coords for 01-quadrant
-				float u = 2.0f*((float) n)/((float) SUBTILE_SIZE - 1.0f);
-				float v = 2.0f*((float) m)/((float) SUBTILE_SIZE - 1.0f) - 1.0f;
-
-				short* pixels = (short*) tex->pixels;
-				pixels[m*SUBTILE_SIZE + n] = interpolateh(subtex, u, v);
+				nedgz_geom256_subsample((short*) tex->pixels,
+				                        SUBTILE_SIZE,
+				                        (short*) subtex->pixels,
+				                        qi, qj);
+				texgz_tex_delete(&subtex);
 			}
 		}
-		texgz_tex_delete(&subtex);
-	}
-
-	// sample the 10-quadrant
-	snprintf(fname, 256, "%i_%i", jprime + 1, iprime);
-	size = pak_file_seek(subpak, fname);
-	subtex = (size > 0) ? texgz_tex_importf(subpak->f, size) : NULL;
-	if(subtex)
-	{
-		for(m = 0; m < half; ++m)
-		{
-			for(n = half; n < SUBTILE_SIZE; ++n)
-			{
-				// scale uv coords for 10-quadrant
-				float u = 2.0f*((float) n)/((float) SUBTILE_SIZE - 1.0f) - 1.0f;
-				float v = 2.0f*((float) m)/((float) SUBTILE_SIZE - 1.0f);
-
-				short* pixels = (short*) tex->pixels;
-				pixels[m*SUBTILE_SIZE + n] = interpolateh(subtex, u, v);
-			}
-		}
-		texgz_tex_delete(&subtex);
-	}
-
-	// sample the 11-quadrant
-	snprintf(fname, 256, "%i_%i", jprime + 1, iprime + 1);
-	size = pak_file_seek(subpak, fname);
-	subtex = (size > 0) ? texgz_tex_importf(subpak->f, size) : NULL;
-	if(subtex)
-	{
-		for(m = half; m < SUBTILE_SIZE; ++m)
-		{
-			for(n = half; n < SUBTILE_SIZE; ++n)
-			{
-				// scale uv coords for 11-quadrant
-				float u = 2.0f*((float) n)/((float) SUBTILE_SIZE - 1.0f) - 1.0f;
-				float v = 2.0f*((float) m)/((float) SUBTILE_SIZE - 1.0f) - 1.0f;
-
-				short* pixels = (short*) tex->pixels;
-				pixels[m*SUBTILE_SIZE + n] = interpolateh(subtex, u, v);
-			}
-		}
-		texgz_tex_delete(&subtex);
 	}
 
 	// j=dx, i=dy
@@ -216,30 +104,26 @@ static void sample_tile(int x, int y, int zoom)
 
 	// create directories if necessary
 	char dname[256];
-	snprintf(dname, 256, "heightmap/%i", zoom);
-	if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+	snprintf(dname, 256, "heightmap/%i/", zoom);
+	if(nedgz_path_mkdir(dname) == 0)
 	{
-		if(errno == EEXIST)
-		{
-			// already exists
-		}
-		else
-		{
-			LOGE("mkdir %s failed", dname);
-			return;
-		}
+		return;
 	}
 
 	// open the src
 	char fname[256];
 	snprintf(fname, 256, "heightmap/%i/%i_%i.pak", zoom + 1, 2*x, 2*y);
 	pak_file_t* subpak00 = pak_file_open(fname, PAK_FLAG_READ);
+	nedgz_progress_readfile(progress, fname);
 	snprintf(fname, 256, "heightmap/%i/%i_%i.pak", zoom + 1, 2*x, 2*y + 1);
 	pak_file_t* subpak01 = pak_file_open(fname, PAK_FLAG_READ);
+	nedgz_progress_readfile(progress, fname);
 	snprintf(fname, 256, "heightmap/%i/%i_%i.pak", zoom + 1, 2*x + 1, 2*y);
 	pak_file_t* subpak10 = pak_file_open(fname, PAK_FLAG_READ);
+	nedgz_progress_readfile(progress, fname);
 	snprintf(fname, 256, "heightmap/%i/%i_%i.pak", zoom + 1, 2*x + 1, 2*y + 1);
 	pak_file_t* subpak11 = pak_file_open(fname, PAK_FLAG_READ);
+	nedgz_progress_readfile(progress, fname);
 
 	if((subpak00 == NULL) &&
 	   (subpak01 == NULL) &&
@@ -252,6 +136,11 @@ static void sample_tile(int x, int y, int zoom)
 	// open the dst tile
 	snprintf(fname, 256, "heightmap/%i/%i_%i.pak", zoom, x, y);
 	pak_file_t* pak = pak_file_open(fname, PAK_FLAG_WRITE);
+	if((pak == NULL) && nedgz_path_retry(fname))
+	{
+		pak = pak_file_open(fname, PAK_FLAG_WRITE);
+	}
+
 	if(pak == NULL)
 	{
 		goto fail_dst;
@@ -313,6 +202,8 @@ static void sample_tile(int x, int y, int zoom)
 	}
 
 	pak_file_close(&pak);
+	snprintf(fname, 256, "heightmap/%i/%i_%i.pak", zoom, x, y);
+	nedgz_progress_writefile(progress, fname);
 
 	// success
 	return;
@@ -330,18 +221,20 @@ static void sample_tile_range(int x0, int y0, int x1, int y1, int zoom)
 {
 	LOGD("debug x0=%i, y0=%i, x1=%i, y1=%i, zoom=%i", x0, y0, x1, y1, zoom);
 
-	int x;
-	int y;
-	int idx   = 0;
-	int count = (x1 - x0 + 1)*(y1 - y0 + 1);
-	for(y = y0; y <= y1; ++y)
+	// walk the tiles in Z-order so that neighboring src
+	// tiles are sampled close together
+	int            x;
+	int            y;
+	nedgz_zorder_t zorder;
+	nedgz_zorder_init(&zorder, x0, y0, x1, y1);
+	while(nedgz_zorder_next(&zorder, &x, &y))
 	{
-		for(x = x0; x <= x1; ++x)
-		{
-			LOGI("%i/%i: x=%i, y=%i", idx++, count, x, y);
+		LOGD("debug x=%i, y=%i", x, y);
 
-			sample_tile(x, y, zoom);
-		}
+		NEDGZ_PROFILE_BEGIN(subheightmap_tile);
+		sample_tile(x, y, zoom);
+		NEDGZ_PROFILE_END(subheightmap_tile);
+		nedgz_progress_done(progress, 1);
 	}
 }
 
@@ -355,18 +248,10 @@ int main(int argc, char** argv)
 
 	// create directories if necessary
 	char dname[256];
-	snprintf(dname, 256, "%s", "heightmap");
-	if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+	snprintf(dname, 256, "%s", "heightmap/");
+	if(nedgz_path_mkdir(dname) == 0)
 	{
-		if(errno == EEXIST)
-		{
-			// already exists
-		}
-		else
-		{
-			LOGE("mkdir %s failed", dname);
-			return EXIT_FAILURE;
-		}
+		return EXIT_FAILURE;
 	}
 
 	int zoom = (int) strtol(argv[1], NULL, 0);
@@ -400,7 +285,14 @@ int main(int argc, char** argv)
 	// sample the set of tiles whose origin should cover range
 	// again, due to overlap with other flt tiles the sampling
 	// actually occurs over the entire flt_xx set
+	progress = nedgz_progress_new("subheightmap",
+	                              (x1 - x0 + 1)*(y1 - y0 + 1));
+	if(progress == NULL)
+	{
+		return EXIT_FAILURE;
+	}
 	sample_tile_range(x0, y0, x1, y1, zoom);
+	nedgz_progress_delete(&progress);
 
 	// success
 	return EXIT_SUCCESS;
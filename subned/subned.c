@@ -28,171 +28,63 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <string.h>
+#include <unistd.h>
 #include "nedgz/nedgz_tile.h"
+#include "nedgz/nedgz_batch.h"
+#include "nedgz/nedgz_loader.h"
+#include "nedgz/nedgz_pool.h"
+#include "nedgz/nedgz_path.h"
+#include "nedgz/nedgz_profile.h"
+#include "nedgz/nedgz_progress.h"
 #include "nedgz/nedgz_util.h"
+#include "subned_sample.h"
 
 #define LOG_TAG "subned"
 #include "nedgz/nedgz_log.h"
 
-static short interpolateh(nedgz_subtile_t* subtile, float u, float v)
-{
-	assert(subtile);
-	LOGD("debug u=%f, v=%f", u, v);
+// recycles the dst tiles between sample_tile calls
+static nedgz_pool_t* pool = NULL;
 
-	// "float indices"
-	float pu = u*(NEDGZ_SUBTILE_SIZE - 1);
-	float pv = v*(NEDGZ_SUBTILE_SIZE - 1);
+// imports the src tiles for a batch of dst tiles in parallel
+#define SUBNED_BATCH 16
+static nedgz_loader_t* loader = NULL;
 
-	// determine indices to sample
-	int u0 = (int) pu;
-	int v0 = (int) pv;
-	int u1 = u0 + 1;
-	int v1 = v0 + 1;
+// flat row-major copy of the dst tile
+static short data[NEDGZ_TILE_SIZE*NEDGZ_TILE_SIZE];
 
-	// double check the indices
-	if(u0 < 0)
-	{
-		u0 = 0;
-	}
-	if(u1 >= NEDGZ_SUBTILE_SIZE)
-	{
-		u1 = NEDGZ_SUBTILE_SIZE - 1;
-	}
-	if(v0 < 0)
-	{
-		v0 = 0;
-	}
-	if(v1 >= NEDGZ_SUBTILE_SIZE)
-	{
-		v1 = NEDGZ_SUBTILE_SIZE - 1;
-	}
-
-	// compute interpolation coordinates
-	float u0f = (float) u0;
-	float v0f = (float) v0;
-	float uf    = pu - u0f;
-	float vf    = pv - v0f;
-
-	// sample interpolation values
-	short* data = (short*) subtile->data;
-	float h00   = (float) data[v0*NEDGZ_SUBTILE_SIZE + u0];
-	float h01   = (float) data[v1*NEDGZ_SUBTILE_SIZE + u0];
-	float h10   = (float) data[v0*NEDGZ_SUBTILE_SIZE + u1];
-	float h11   = (float) data[v1*NEDGZ_SUBTILE_SIZE + u1];
-
-	// interpolate u
-	float h0010 = h00 + uf*(h10 - h00);
-	float h0111 = h01 + uf*(h11 - h01);
-
-	// interpolate v
-	return (short) (h0010 + vf*(h0111 - h0010) + 0.5f);
-}
+// dst tiles are committed to disk after each batch
+static nedgz_batch_t* batch = NULL;
 
-static void sample_subtile(nedgz_tile_t* ned, nedgz_tile_t* subned, int i, int j)
-{
-	assert(ned);
-	assert(subned);
-	LOGD("debug i=%i, j=%i", i, j);
-
-	// sample the 00-quadrant
-	int m;
-	int n;
-	int half = NEDGZ_SUBTILE_SIZE/2;
-	int iprime = (2*i)%NEDGZ_SUBTILE_COUNT;
-	int jprime = (2*j)%NEDGZ_SUBTILE_COUNT;
-	nedgz_subtile_t* subtile = nedgz_tile_getij(subned, iprime, jprime);
-	if(subtile)
-	{
-		for(m = 0; m < half; ++m)
-		{
-			for(n = 0; n < half; ++n)
-			{
-				// scale uv coords for 00-quadrant
-				float u = 2.0f*((float) n)/((float) NEDGZ_SUBTILE_SIZE - 1.0f);
-				float v = 2.0f*((float) m)/((float) NEDGZ_SUBTILE_SIZE - 1.0f);
-				short h = interpolateh(subtile, u, v);
-				nedgz_tile_set(ned, i, j, m, n, h);
-			}
-		}
-	}
+// skip dst tiles which were completed by a previous run
+static int resume = 0;
 
-	// sample the 01-quadrant
-	subtile = nedgz_tile_getij(subned, iprime + 1, jprime);
-	if(subtile)
-	{
-		for(m = half; m < NEDGZ_SUBTILE_SIZE; ++m)
-		{
-			for(n = 0; n < half; ++n)
-			{
-				// scale uv coords for 01-quadrant
-				float u = 2.0f*((float) n)/((float) NEDGZ_SUBTILE_SIZE - 1.0f);
-				float v = 2.0f*((float) m)/((float) NEDGZ_SUBTILE_SIZE - 1.0f) - 1.0f;
-				short h = interpolateh(subtile, u, v);
-				nedgz_tile_set(ned, i, j, m, n, h);
-			}
-		}
-	}
+// reports tiles/sec and the ETA
+static nedgz_progress_t* progress = NULL;
+static int stage_load   = -1;
+static int stage_sample = -1;
+static int stage_commit = -1;
 
-	// sample the 10-quadrant
-	subtile = nedgz_tile_getij(subned, iprime, jprime + 1);
-	if(subtile)
-	{
-		for(m = 0; m < half; ++m)
-		{
-			for(n = half; n < NEDGZ_SUBTILE_SIZE; ++n)
-			{
-				// scale uv coords for 10-quadrant
-				float u = 2.0f*((float) n)/((float) NEDGZ_SUBTILE_SIZE - 1.0f) - 1.0f;
-				float v = 2.0f*((float) m)/((float) NEDGZ_SUBTILE_SIZE - 1.0f);
-				short h = interpolateh(subtile, u, v);
-				nedgz_tile_set(ned, i, j, m, n, h);
-			}
-		}
-	}
-
-	// sample the 11-quadrant
-	subtile = nedgz_tile_getij(subned, iprime + 1, jprime + 1);
-	if(subtile)
-	{
-		for(m = half; m < NEDGZ_SUBTILE_SIZE; ++m)
-		{
-			for(n = half; n < NEDGZ_SUBTILE_SIZE; ++n)
-			{
-				// scale uv coords for 11-quadrant
-				float u = 2.0f*((float) n)/((float) NEDGZ_SUBTILE_SIZE - 1.0f) - 1.0f;
-				float v = 2.0f*((float) m)/((float) NEDGZ_SUBTILE_SIZE - 1.0f) - 1.0f;
-				short h = interpolateh(subtile, u, v);
-				nedgz_tile_set(ned, i, j, m, n, h);
-			}
-		}
-	}
-}
-
-static void sample_tile(int x, int y, int zoom)
+static void sample_tile(int x, int y, int zoom, nedgz_tile_t** src)
 {
+	assert(src);
 	LOGD("debug x=%i, y=%i, zoom=%i", x, y, zoom);
 
+	// src is ordered 00, 01, 10, 11
+	nedgz_tile_t* subned00 = src[0];
+	nedgz_tile_t* subned01 = src[1];
+	nedgz_tile_t* subned10 = src[2];
+	nedgz_tile_t* subned11 = src[3];
+
 	// create directories if necessary
 	char dname[256];
-	snprintf(dname, 256, "ned/%i", zoom);
-	if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+	snprintf(dname, 256, "ned/%i/", zoom);
+	if(nedgz_path_mkdir(dname) == 0)
 	{
-		if(errno == EEXIST)
-		{
-			// already exists
-		}
-		else
-		{
-			LOGE("mkdir %s failed", dname);
-			return;
-		}
+		goto fail_mkdir;
 	}
 
-	// open the src
-	nedgz_tile_t* subned00 = nedgz_tile_import("ned", 2*x, 2*y, zoom + 1);
-	nedgz_tile_t* subned01 = nedgz_tile_import("ned", 2*x, 2*y + 1, zoom + 1);
-	nedgz_tile_t* subned10 = nedgz_tile_import("ned", 2*x + 1, 2*y, zoom + 1);
-	nedgz_tile_t* subned11 = nedgz_tile_import("ned", 2*x + 1, 2*y + 1, zoom + 1);
+	// check the src
 	if((subned00 == NULL) &&
 	   (subned01 == NULL) &&
 	   (subned10 == NULL) &&
@@ -202,123 +94,163 @@ static void sample_tile(int x, int y, int zoom)
 	}
 
 	// open the dst tile
-	nedgz_tile_t* ned = nedgz_tile_new(x, y, zoom);
+	nedgz_tile_t* ned = nedgz_pool_get(pool, x, y, zoom);
 	if(ned == NULL)
 	{
 		goto fail_dst;
 	}
 
-	// sample the 00-quadrant
-	int i;
-	int j;
-	int half = NEDGZ_SUBTILE_COUNT/2;
-	if(subned00)
+	if(subned_sample(ned, src, data) == 0)
 	{
-		for(i = 0; i < half; ++i)
-		{
-			for(j = 0; j < half; ++j)
-			{
-				sample_subtile(ned, subned00, i, j);
-			}
-		}
-		nedgz_tile_delete(&subned00);
+		goto fail_set;
 	}
+	nedgz_batch_export(batch, ned, "ned", 0);
+	nedgz_pool_put(pool, &ned);
+	nedgz_pool_put(pool, &subned00);
+	nedgz_pool_put(pool, &subned01);
+	nedgz_pool_put(pool, &subned10);
+	nedgz_pool_put(pool, &subned11);
+
+	// success
+	return;
 
-	// sample the 01-quadrant
-	if(subned01)
+	// failure
+	fail_set:
+		nedgz_pool_put(pool, &ned);
+	fail_dst:
+	fail_src:
+	fail_mkdir:
+		nedgz_pool_put(pool, &subned00);
+		nedgz_pool_put(pool, &subned01);
+		nedgz_pool_put(pool, &subned10);
+		nedgz_pool_put(pool, &subned11);
+}
+
+static void sample_batch(int* bx, int* by, int count, int zoom)
+{
+	assert(bx);
+	assert(by);
+	LOGD("debug count=%i, zoom=%i", count, zoom);
+
+	// request the src tiles for the batch
+	int k;
+	int q;
+	for(k = 0; k < count; ++k)
 	{
-		for(i = half; i < NEDGZ_SUBTILE_COUNT; ++i)
+		for(q = 0; q < 4; ++q)
 		{
-			for(j = 0; j < half; ++j)
-			{
-				sample_subtile(ned, subned01, i, j);
-			}
+			nedgz_loader_request(loader, 2*bx[k] + q/2,
+			                     2*by[k] + q%2, zoom + 1);
 		}
-		nedgz_tile_delete(&subned01);
 	}
 
-	// sample the 10-quadrant
-	if(subned10)
+	// collect the src tiles as they complete
+	nedgz_tile_t* src[SUBNED_BATCH][4];
+	memset((void*) src, 0, sizeof(src));
+
+	int           x;
+	int           y;
+	int           z;
+	nedgz_tile_t* tile;
+	char          fname[256];
+	double        t0 = nedgz_progress_begin(progress);
+	NEDGZ_PROFILE_BEGIN(subned_load);
+	while(nedgz_loader_next(loader, &x, &y, &z, &tile))
 	{
-		for(i = 0; i < half; ++i)
+		if(tile)
 		{
-			for(j = half; j < NEDGZ_SUBTILE_COUNT; ++j)
-			{
-				sample_subtile(ned, subned10, i, j);
-			}
+			snprintf(fname, 256, "ned/%i/%i_%i.nedgz", z, x, y);
+			nedgz_progress_readfile(progress, fname);
 		}
-		nedgz_tile_delete(&subned10);
-	}
 
-	// sample the 11-quadrant
-	if(subned11)
-	{
-		for(i = half; i < NEDGZ_SUBTILE_COUNT; ++i)
+		for(k = 0; k < count; ++k)
 		{
-			for(j = half; j < NEDGZ_SUBTILE_COUNT; ++j)
+			if((bx[k] == x/2) && (by[k] == y/2))
 			{
-				sample_subtile(ned, subned11, i, j);
+				src[k][2*(x%2) + (y%2)] = tile;
+				break;
 			}
 		}
-		nedgz_tile_delete(&subned11);
 	}
+	NEDGZ_PROFILE_END(subned_load);
+	nedgz_progress_end(progress, stage_load, t0);
 
-	nedgz_tile_export(ned, "ned");
-	nedgz_tile_delete(&ned);
-
-	// success
-	return;
+	for(k = 0; k < count; ++k)
+	{
+		t0 = nedgz_progress_begin(progress);
+		NEDGZ_PROFILE_BEGIN(subned_sample);
+		sample_tile(bx[k], by[k], zoom, src[k]);
+		NEDGZ_PROFILE_END(subned_sample);
+		nedgz_progress_end(progress, stage_sample, t0);
+	}
 
-	// failure
-	fail_dst:
-	fail_src:
-		nedgz_tile_delete(&subned00);
-		nedgz_tile_delete(&subned01);
-		nedgz_tile_delete(&subned10);
-		nedgz_tile_delete(&subned11);
+	t0 = nedgz_progress_begin(progress);
+	nedgz_batch_commit(batch);
+	nedgz_progress_end(progress, stage_commit, t0);
+	nedgz_progress_done(progress, count);
 }
 
 static void sample_tile_range(int x0, int y0, int x1, int y1, int zoom)
 {
 	LOGD("debug x0=%i, y0=%i, x1=%i, y1=%i, zoom=%i", x0, y0, x1, y1, zoom);
 
-	int x;
-	int y;
-	int idx   = 0;
-	int count = (x1 - x0 + 1)*(y1 - y0 + 1);
-	for(y = y0; y <= y1; ++y)
+	// walk the dst tiles in Z-order so that each batch
+	// requests a compact block of src tiles
+	int            x;
+	int            y;
+	int            n = 0;
+	int            bx[SUBNED_BATCH];
+	int            by[SUBNED_BATCH];
+	nedgz_zorder_t zorder;
+	nedgz_zorder_init(&zorder, x0, y0, x1, y1);
+	while(nedgz_zorder_next(&zorder, &x, &y))
 	{
-		for(x = x0; x <= x1; ++x)
+		LOGD("debug x=%i, y=%i", x, y);
+
+		if(resume && nedgz_tile_valid("ned", x, y, zoom))
 		{
-			LOGI("%i/%i: x=%i, y=%i", idx++, count, x, y);
+			nedgz_progress_skip(progress, 1);
+			continue;
+		}
 
-			sample_tile(x, y, zoom);
+		bx[n] = x;
+		by[n] = y;
+		++n;
+		if(n == SUBNED_BATCH)
+		{
+			sample_batch(bx, by, n, zoom);
+			n = 0;
 		}
 	}
+
+	if(n)
+	{
+		sample_batch(bx, by, n, zoom);
+	}
 }
 
 int main(int argc, char** argv)
 {
+	// optionally resume an interrupted run
+	if((argc == 7) && (strcmp(argv[1], "-resume") == 0))
+	{
+		resume = 1;
+		--argc;
+		++argv;
+	}
+
 	if(argc != 6)
 	{
-		LOGE("usage: %s [zoom] [latT] [lonL] [latB] [lonR]", argv[0]);
+		LOGE("usage: %s [-resume] [zoom] [latT] [lonL] [latB] [lonR]", argv[0]);
 		return EXIT_FAILURE;
 	}
 
 	// create directories if necessary
 	char dname[256];
-	snprintf(dname, 256, "%s", "ned");
-	if(mkdir(dname, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
+	snprintf(dname, 256, "%s", "ned/");
+	if(nedgz_path_mkdir(dname) == 0)
 	{
-		if(errno == EEXIST)
-		{
-			// already exists
-		}
-		else
-		{
-			LOGE("mkdir %s failed", dname);
-			return EXIT_FAILURE;
-		}
+		return EXIT_FAILURE;
 	}
 
 	int zoom = (int) strtol(argv[1], NULL, 0);
@@ -352,7 +284,47 @@ int main(int argc, char** argv)
 	// sample the set of tiles whose origin should cover range
 	// again, due to overlap with other flt tiles the sampling
 	// actually occurs over the entire flt_xx set
+	pool = nedgz_pool_new(1);
+	if(pool == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+
+	int threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	loader = nedgz_loader_new("ned", (threads > 0) ? threads : 1);
+	if(loader == NULL)
+	{
+		nedgz_pool_delete(&pool);
+		return EXIT_FAILURE;
+	}
+
+	batch = nedgz_batch_new();
+	if(batch == NULL)
+	{
+		nedgz_loader_delete(&loader);
+		nedgz_pool_delete(&pool);
+		return EXIT_FAILURE;
+	}
+
+	progress = nedgz_progress_new("subned",
+	                              (x1 - x0 + 1)*(y1 - y0 + 1));
+	if(progress == NULL)
+	{
+		nedgz_batch_delete(&batch);
+		nedgz_loader_delete(&loader);
+		nedgz_pool_delete(&pool);
+		return EXIT_FAILURE;
+	}
+	nedgz_batch_progress(batch, progress);
+	stage_load   = nedgz_progress_stage(progress, "load");
+	stage_sample = nedgz_progress_stage(progress, "sample");
+	stage_commit = nedgz_progress_stage(progress, "commit");
+
 	sample_tile_range(x0, y0, x1, y1, zoom);
+	nedgz_progress_delete(&progress);
+	nedgz_batch_delete(&batch);
+	nedgz_loader_delete(&loader);
+	nedgz_pool_delete(&pool);
 
 	// success
 	return EXIT_SUCCESS;
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2014 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include "nedgz/nedgz_geom.h"
+#include "subned_sample.h"
+
+#define LOG_TAG "subned"
+#include "nedgz/nedgz_log.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static int subned_sample_subtile(nedgz_tile_t* ned, short* data,
+                                 nedgz_tile_t* subned, int i, int j)
+{
+	assert(ned);
+	assert(data);
+	assert(subned);
+	LOGD("debug i=%i, j=%i", i, j);
+
+	// each quadrant of the dst subtile is sampled from
+	// one of the four corresponding src subtiles
+	int iprime = (2*i)%NEDGZ_SUBTILE_COUNT;
+	int jprime = (2*j)%NEDGZ_SUBTILE_COUNT;
+	short* dst = &data[i*NEDGZ_SUBTILE_SIZE*NEDGZ_TILE_SIZE +
+	                   j*NEDGZ_SUBTILE_SIZE];
+
+	int qi;
+	int qj;
+	for(qi = 0; qi < 2; ++qi)
+	{
+		for(qj = 0; qj < 2; ++qj)
+		{
+			nedgz_subtile_t* subtile;
+			subtile = nedgz_tile_getij(subned, iprime + qi,
+			                           jprime + qj);
+			if(subtile == NULL)
+			{
+				continue;
+			}
+
+			// setdata skips NODATA spans so the dst
+			// subtile must exist before it is copied
+			if(nedgz_tile_newij(ned, i, j) == NULL)
+			{
+				return 0;
+			}
+
+			nedgz_geom32_subsample(dst, NEDGZ_TILE_SIZE,
+			                       subtile->data, qi, qj);
+		}
+	}
+
+	return 1;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int subned_sample(nedgz_tile_t* ned, nedgz_tile_t** src,
+                  short* data)
+{
+	assert(ned);
+	assert(src);
+	assert(data);
+	LOGD("debug x=%i, y=%i, zoom=%i", ned->x, ned->y, ned->zoom);
+
+	// the dst is sampled into data and copied to
+	// the tile once all quadrants are complete
+	nedgz_tile_getdata(ned, data);
+
+	// the y parity selects the rows and the x parity
+	// selects the columns of the dst quadrant
+	int half = NEDGZ_SUBTILE_COUNT/2;
+	int i;
+	int j;
+	int q;
+	for(q = 0; q < 4; ++q)
+	{
+		if(src[q] == NULL)
+		{
+			continue;
+		}
+
+		int i0 = (q%2)*half;
+		int j0 = (q/2)*half;
+		for(i = i0; i < i0 + half; ++i)
+		{
+			for(j = j0; j < j0 + half; ++j)
+			{
+				if(subned_sample_subtile(ned, data, src[q],
+				                         i, j) == 0)
+				{
+					return 0;
+				}
+			}
+		}
+	}
+
+	return nedgz_tile_setdata(ned, data);
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2014 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef subned_sample_H
+#define subned_sample_H
+
+#include "nedgz/nedgz_tile.h"
+
+// samples the four src tiles at zoom + 1 into the dst tile
+// where src is ordered 00, 01, 10, 11 by the x,y parity and
+// missing src tiles are NULL
+//
+// a dst subtile is created for every src subtile which
+// exists even when it only contains NODATA so that the
+// pyramid preserves the subtile mask of the src tiles
+//
+// data is a scratch buffer of NEDGZ_TILE_SIZE^2 samples
+int subned_sample(nedgz_tile_t* ned, nedgz_tile_t** src,
+                  short* data);
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2014 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include "nedgz/nedgz_tile.h"
+#include "subned_sample.h"
+
+#define LOG_TAG "subned"
+#include "nedgz/nedgz_log.h"
+
+static short data[NEDGZ_TILE_SIZE*NEDGZ_TILE_SIZE];
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+// src subtiles are created where bit i*8 + j of mask is set
+// and filled with h where bit i*8 + j of hmask is set
+static nedgz_tile_t* make_src(int x, int y, int zoom,
+                              unsigned long long mask,
+                              unsigned long long hmask,
+                              short h)
+{
+	LOGD("debug x=%i, y=%i, zoom=%i", x, y, zoom);
+
+	nedgz_tile_t* tile = nedgz_tile_new(x, y, zoom);
+	if(tile == NULL)
+	{
+		return NULL;
+	}
+
+	int idx;
+	int k;
+	for(idx = 0; idx < 64; ++idx)
+	{
+		if((mask & (1ULL << idx)) == 0)
+		{
+			continue;
+		}
+
+		nedgz_subtile_t* subtile;
+		subtile = nedgz_tile_newij(tile, idx/8, idx%8);
+		if(subtile == NULL)
+		{
+			nedgz_tile_delete(&tile);
+			return NULL;
+		}
+
+		if(hmask & (1ULL << idx))
+		{
+			for(k = 0; k < NEDGZ_SUBTILE_SIZE*NEDGZ_SUBTILE_SIZE; ++k)
+			{
+				subtile->data[k] = h;
+			}
+		}
+	}
+
+	return tile;
+}
+
+// the dst mask expected for a src mask in quadrant q
+static unsigned long long expect_mask(unsigned long long mask, int q)
+{
+	unsigned long long dst = 0;
+
+	int i;
+	int j;
+	for(i = 0; i < 8; ++i)
+	{
+		for(j = 0; j < 8; ++j)
+		{
+			int s = 16*(i/2) + 2*(j/2);
+			if((mask >> s) & 0x303ULL)
+			{
+				int di = (q%2)*4 + i/2;
+				int dj = (q/2)*4 + j/2;
+				dst |= 1ULL << (di*8 + dj);
+			}
+		}
+	}
+
+	return dst;
+}
+
+static int check(const char* name, unsigned long long mask,
+                 unsigned long long hmask, short h)
+{
+	assert(name);
+	LOGD("debug name=%s", name);
+
+	int ret = 1;
+	int q;
+	for(q = 0; q < 4; ++q)
+	{
+		nedgz_tile_t* src[4] = { NULL, NULL, NULL, NULL };
+		src[q] = make_src(2*100 + q/2, 2*200 + q%2, 11,
+		                  mask, hmask, h);
+		nedgz_tile_t* ned = nedgz_tile_new(100, 200, 10);
+		if((src[q] == NULL) || (ned == NULL))
+		{
+			nedgz_tile_delete(&src[q]);
+			nedgz_tile_delete(&ned);
+			return 0;
+		}
+
+		unsigned long long expect = expect_mask(mask, q);
+		if(subned_sample(ned, src, data) == 0)
+		{
+			LOGE("%s: q=%i sample failed", name, q);
+			ret = 0;
+		}
+		else if(ned->mask != expect)
+		{
+			LOGE("%s: q=%i mask=%016llx, expect=%016llx",
+			     name, q, ned->mask, expect);
+			ret = 0;
+		}
+		else if(hmask)
+		{
+			// a subtile sampled from filled src subtiles
+			short hs;
+			int   idx = 0;
+			while((hmask & (1ULL << idx)) == 0)
+			{
+				++idx;
+			}
+			int i = (q%2)*4 + (idx/8)/2;
+			int j = (q/2)*4 + (idx%8)/2;
+			hs = ned->subtile[i*8 + j]->data[0];
+			if(hs != h)
+			{
+				LOGE("%s: q=%i h=%i, expect=%i", name, q, hs, h);
+				ret = 0;
+			}
+		}
+
+		nedgz_tile_delete(&src[q]);
+		nedgz_tile_delete(&ned);
+	}
+
+	return ret;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int main(int argc, char** argv)
+{
+	// subned_test checks that the dst subtile mask matches
+	// the src subtiles including those which only contain
+	// NODATA (e.g. along coasts)
+	int ok = 1;
+	ok &= check("nodata", 0xFFFFFFFFFFFFFFFFULL, 0ULL, 0);
+	ok &= check("mixed", 0xFFFFFFFFFFFFFFFFULL,
+	            0x00FF00FF0F0F0303ULL, 1234);
+	ok &= check("sparse", 0x8000004000200001ULL,
+	            0x0000004000000001ULL, 56);
+	ok &= check("data", 0x00000000FFFFFFFFULL,
+	            0x00000000FFFFFFFFULL, 4321);
+	if(ok == 0)
+	{
+		LOGE("FAILED");
+		return EXIT_FAILURE;
+	}
+
+	LOGI("PASSED");
+	return EXIT_SUCCESS;
+}
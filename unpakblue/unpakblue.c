@@ -30,6 +30,7 @@
 #include <sys/types.h>
 #include "libpak/pak_file.h"
 #include "nedgz/nedgz_scene.h"
+#include "nedgz/nedgz_path.h"
 #include "nedgz/nedgz_tile.h"
 
 #define LOG_TAG "unpakblue"
@@ -39,46 +40,6 @@
 * private                                                  *
 ***********************************************************/
 
-static int recursive_mkdir(const char* path)
-{
-	assert(path);
-	LOGD("debug");
-
-	int  len = strnlen(path, 255);
-	char dir[256];
-	int  i;
-	for(i = 0; i < len; ++i)
-	{
-		dir[i]     = path[i];
-		dir[i + 1] = '\0';
-
-		if(dir[i] == '/')
-		{
-			if(access(dir, R_OK) == 0)
-			{
-				// dir already exists
-				continue;
-			}
-
-			// try to mkdir
-			if(mkdir(dir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
-			{
-				if(errno == EEXIST)
-				{
-					// already exists
-				}
-				else
-				{
-					LOGE("mkdir %s failed", dir);
-					return 0;
-				}
-			}
-		}
-	}
-
-	return 1;
-}
-
 static int export_pak(int zoom, int x, int y,
                       const char* in, const char* out)
 {
@@ -114,13 +75,13 @@ static int export_pak(int zoom, int x, int y,
 			snprintf(name_tex, 256, "%s/%i/%i.texz", out, 8*x + j, 8*y + i);
 			name_tex[255] = '\0';
 
-			if(recursive_mkdir(name_tex) == 0)
+			if(nedgz_path_mkdir(name_tex) == 0)
 			{
 				goto fail_mkdir;
 			}
 
 
-			f = fopen(name_tex, "w");
+			f = nedgz_path_fopen(name_tex, "w");
 			if(f == NULL)
 			{
 				LOGE("fopen %s failed", name_tex);
@@ -30,6 +30,9 @@
 #include <sys/types.h>
 #include "libpak/pak_file.h"
 #include "nedgz/nedgz_scene.h"
+#include "nedgz/nedgz_path.h"
+#include "nedgz/nedgz_profile.h"
+#include "nedgz/nedgz_progress.h"
 #include "nedgz/nedgz_tile.h"
 
 #define LOG_TAG "upgradesg"
@@ -55,44 +58,18 @@
 * private                                                  *
 ***********************************************************/
 
-static int recursive_mkdir(const char* path)
-{
-	assert(path);
-	LOGD("debug");
+// reports nodes/sec and the ETA
+static nedgz_progress_t* progress = NULL;
 
-	int  len = strnlen(path, 255);
-	char dir[256];
-	int  i;
-	for(i = 0; i < len; ++i)
+static int count_nodes(nedgz_scene_t* scene)
+{
+	if(scene == NULL)
 	{
-		dir[i]     = path[i];
-		dir[i + 1] = '\0';
-
-		if(dir[i] == '/')
-		{
-			if(access(dir, R_OK) == 0)
-			{
-				// dir already exists
-				continue;
-			}
-
-			// try to mkdir
-			if(mkdir(dir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == -1)
-			{
-				if(errno == EEXIST)
-				{
-					// already exists
-				}
-				else
-				{
-					LOGE("mkdir %s failed", dir);
-					return 0;
-				}
-			}
-		}
+		return 0;
 	}
 
-	return 1;
+	return 1 + count_nodes(scene->tl) + count_nodes(scene->tr) +
+	       count_nodes(scene->bl) + count_nodes(scene->br);
 }
 
 static int export_pak(char* mask,
@@ -110,10 +87,11 @@ static int export_pak(char* mask,
 		0, 0, 0, 0, 0, 0, 0, 0
 	};
 
+	NEDGZ_PROFILE_BEGIN(upgradesg_pak);
 	pak_file_t* pak = pak_file_open(in, PAK_FLAG_READ);
 	if(pak == NULL)
 	{
-		return 0;
+		goto fail_pak;
 	}
 
 	int i;
@@ -176,6 +154,7 @@ static int export_pak(char* mask,
 	         bmask[0], bmask[1], bmask[2], bmask[3],
 	         bmask[4], bmask[5], bmask[6], bmask[7]);
 	mask[255] = '\0';
+	NEDGZ_PROFILE_END(upgradesg_pak);
 
 	// success
 	return 1;
@@ -186,6 +165,8 @@ static int export_pak(char* mask,
 		fclose(f);
 	fail_tex:
 		pak_file_close(&pak);
+	fail_pak:
+		NEDGZ_PROFILE_END(upgradesg_pak);
 	return 0;
 }
 
@@ -194,7 +175,8 @@ static int upgrade_osm(nedgz_scene_t* scene,
                        const char* in, const char* out)
 {
 	assert(scene);
-	LOGI("zoom=%i, x=%i, y=%i", zoom, x, y);
+	LOGD("debug zoom=%i, x=%i, y=%i", zoom, x, y);
+	nedgz_progress_done(progress, 1);
 
 	char name_kv[256];
 	char name_pak[256];
@@ -206,12 +188,12 @@ static int upgrade_osm(nedgz_scene_t* scene,
 	name_pak[255] = '\0';
 	name_dir[255] = '\0';
 
-	if(recursive_mkdir(name_kv) == 0)
+	if(nedgz_path_mkdir(name_kv) == 0)
 	{
 		return 0;
 	}
 
-	FILE* f = fopen(name_kv, "w");
+	FILE* f = nedgz_path_fopen(name_kv, "w");
 	if(f == NULL)
 	{
 		LOGE("fopen %s failed", name_kv);
@@ -283,7 +265,8 @@ static int upgrade_bluemarble(nedgz_scene_t* scene,
                               const char* in, const char* out)
 {
 	assert(scene);
-	LOGI("zoom=%i, x=%i, y=%i", zoom, x, y);
+	LOGD("debug zoom=%i, x=%i, y=%i", zoom, x, y);
+	nedgz_progress_done(progress, 1);
 
 	FILE* f = NULL;
 	int month;
@@ -299,7 +282,7 @@ static int upgrade_bluemarble(nedgz_scene_t* scene,
 		name_pak[255] = '\0';
 		name_dir[255] = '\0';
 
-		if(recursive_mkdir(name_kv) == 0)
+		if(nedgz_path_mkdir(name_kv) == 0)
 		{
 			return 0;
 		}
@@ -361,7 +344,8 @@ static int upgrade_hillshade(nedgz_scene_t* scene,
                              const char* in, const char* out)
 {
 	assert(scene);
-	LOGI("zoom=%i, x=%i, y=%i", zoom, x, y);
+	LOGD("debug zoom=%i, x=%i, y=%i", zoom, x, y);
+	nedgz_progress_done(progress, 1);
 
 	char name_kv[256];
 	char name_pak[256];
@@ -373,12 +357,12 @@ static int upgrade_hillshade(nedgz_scene_t* scene,
 	name_pak[255] = '\0';
 	name_dir[255] = '\0';
 
-	if(recursive_mkdir(name_kv) == 0)
+	if(nedgz_path_mkdir(name_kv) == 0)
 	{
 		return 0;
 	}
 
-	FILE* f = fopen(name_kv, "w");
+	FILE* f = nedgz_path_fopen(name_kv, "w");
 	if(f == NULL)
 	{
 		LOGE("fopen %s failed", name_kv);
@@ -450,7 +434,8 @@ static int upgrade_ned(nedgz_scene_t* scene,
                        const char* in, const char* out)
 {
 	assert(scene);
-	LOGI("zoom=%i, x=%i, y=%i", zoom, x, y);
+	LOGD("debug zoom=%i, x=%i, y=%i", zoom, x, y);
+	nedgz_progress_done(progress, 1);
 
 	char name_kv[256];
 	char name_dir[256];
@@ -459,7 +444,7 @@ static int upgrade_ned(nedgz_scene_t* scene,
 	name_kv[255]  = '\0';
 	name_dir[255] = '\0';
 
-	if(recursive_mkdir(name_kv) == 0)
+	if(nedgz_path_mkdir(name_kv) == 0)
 	{
 		return 0;
 	}
@@ -495,7 +480,7 @@ static int upgrade_ned(nedgz_scene_t* scene,
 		nedgz_tile_delete(&ned);
 	}
 
-	FILE* f = fopen(name_kv, "w");
+	FILE* f = nedgz_path_fopen(name_kv, "w");
 	if(f == NULL)
 	{
 		LOGE("fopen %s failed", name_kv);
@@ -575,6 +560,12 @@ int main(int argc, const char** argv)
 		return EXIT_FAILURE;
 	}
 
+	progress = nedgz_progress_new("upgradesg", count_nodes(scene));
+	if(progress == NULL)
+	{
+		goto fail_progress;
+	}
+
 	// upgrade scene graph
 	if(strcmp(in, "osm") == 0)
 	{
@@ -611,11 +602,14 @@ int main(int argc, const char** argv)
 	}
 
 	// success
+	nedgz_progress_delete(&progress);
 	nedgz_scene_delete(&scene);
 	return EXIT_SUCCESS;
 
 	// failure
 	fail_in:
+		nedgz_progress_delete(&progress);
+	fail_progress:
 		nedgz_scene_delete(&scene);
 	return EXIT_FAILURE;
 }